@@ -47,6 +47,7 @@
 #include "playlist/PlaylistRegistry.hxx"
 #include "zeroconf/ZeroconfGlue.hxx"
 #include "decoder/DecoderList.hxx"
+#include "decoder/SeekIndex.hxx"
 #include "AudioConfig.hxx"
 #include "pcm/PcmConvert.hxx"
 #include "unix/SignalHandlers.hxx"
@@ -255,11 +256,39 @@ glue_sticker_init(void)
 		return;
 	}
 
-	if (!sticker_global_init(std::move(sticker_file), error))
+	const bool wal = config_get_bool(CONF_STICKER_WAL, true);
+	if (!sticker_global_init(std::move(sticker_file), wal, error))
 		FatalError(error);
 #endif
 }
 
+/**
+ * Configure and load the persistent seek index.
+ */
+static void
+glue_seek_index_init(void)
+{
+	Error error;
+	auto path_fs = config_get_path(CONF_SEEK_INDEX_FILE, error);
+	if (path_fs.IsNull()) {
+		if (error.IsDefined())
+			FatalError(error);
+
+		/* default: next to the database file */
+		const auto db_file = config_get_path(CONF_DB_FILE, error);
+		if (db_file.IsNull()) {
+			if (error.IsDefined())
+				FatalError(error);
+			return;
+		}
+
+		path_fs = AllocatedPath::FromFS(std::string(db_file.c_str())
+						+ ".seek");
+	}
+
+	seek_index_global_init(std::move(path_fs));
+}
+
 static bool
 glue_state_file_init(Error &error)
 {
@@ -526,7 +555,7 @@ int mpd_main(int argc, char *argv[])
 
 	initPermissions();
 	playlist_global_init();
-	spl_global_init();
+	spl_global_init(*instance->event_loop);
 #ifdef ENABLE_ARCHIVE
 	archive_plugin_init_all();
 #endif
@@ -543,12 +572,13 @@ int mpd_main(int argc, char *argv[])
 #endif
 
 	glue_sticker_init();
+	glue_seek_index_init();
 
 	command_init();
 	initAudioConfig();
 	instance->partition->outputs.Configure(*instance->event_loop,
 					       instance->partition->pc);
-	client_manager_init();
+	client_manager_init(*instance->event_loop);
 	replay_gain_global_init();
 
 	if (!input_stream_global_init(error)) {
@@ -650,7 +680,9 @@ int mpd_main(int argc, char *argv[])
 	instance->partition->pc.Kill();
 	ZeroconfDeinit();
 	listen_global_finish();
+	client_manager_finish();
 	delete instance->client_list;
+	spl_global_finish();
 
 #ifdef ENABLE_NEIGHBOR_PLUGINS
 	if (instance->neighbors != nullptr) {
@@ -674,6 +706,8 @@ int mpd_main(int argc, char *argv[])
 	sticker_global_finish();
 #endif
 
+	seek_index_global_finish();
+
 	GlobalEvents::Deinitialize();
 
 	playlist_list_global_finish();
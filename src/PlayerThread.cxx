@@ -611,7 +611,19 @@ Player::ProcessCommand()
 		assert(!IsDecoderAtNextSong());
 
 		queued = true;
-		pc.CommandFinished();
+
+		{
+			/* let the preload thread open the next song's
+			   input stream now, so its connection is
+			   established and its buffer is filled by the
+			   time the decoder needs it */
+			const std::string uri(pc.next_song->GetRealURI());
+			pc.CommandFinished();
+
+			pc.Unlock();
+			dc.Preload(uri.c_str());
+			pc.Lock();
+		}
 		break;
 
 	case PlayerCommand::PAUSE:
@@ -665,6 +677,10 @@ Player::ProcessCommand()
 		pc.next_song = nullptr;
 		queued = false;
 		pc.CommandFinished();
+
+		pc.Unlock();
+		dc.CancelPreload();
+		pc.Lock();
 		break;
 
 	case PlayerCommand::REFRESH:
@@ -1070,6 +1086,7 @@ Player::Run()
 	}
 
 	StopDecoder();
+	dc.CancelPreload();
 
 	ClearAndDeletePipe();
 
@@ -36,22 +36,137 @@
 #include "fs/Charset.hxx"
 #include "fs/FileSystem.hxx"
 #include "fs/DirectoryReader.hxx"
+#include "event/TimeoutMonitor.hxx"
+#include "thread/Mutex.hxx"
 #include "util/StringUtil.hxx"
 #include "util/UriUtil.hxx"
 #include "util/Error.hxx"
+#include "Log.hxx"
+
+#include <algorithm>
+#include <map>
 
 #include <assert.h>
 #include <sys/stat.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 
 static const char PLAYLIST_COMMENT = '#';
 
+/**
+ * Modifications of cached stored playlists are written to the file
+ * after this number of seconds, so a series of edits costs only one
+ * rewrite.
+ */
+static constexpr unsigned SPL_WRITE_BACK_DELAY = 1;
+
+/**
+ * After a failed write-back, retry after this number of seconds.
+ */
+static constexpr unsigned SPL_WRITE_BACK_RETRY_DELAY = 30;
+
+/**
+ * The maximum total number of songs in #spl_cache.
+ */
+static constexpr size_t SPL_CACHE_MAX_SONGS = 1 << 17;
+
 static unsigned playlist_max_length;
 bool playlist_saveAbsolutePaths = DEFAULT_PLAYLIST_SAVE_ABSOLUTE_PATHS;
 
+/**
+ * An in-memory copy of a stored playlist file.
+ */
+struct CachedPlaylistFile {
+	PlaylistFileContents contents;
+
+	/**
+	 * The modification time of the file when it was last read or
+	 * written.
+	 */
+	time_t mtime;
+
+	/**
+	 * When was the file last read or written?  A modification
+	 * within the same second cannot be detected by comparing
+	 * #mtime.
+	 */
+	time_t checked;
+
+	/**
+	 * Were #contents modified without writing them to the file?
+	 */
+	bool dirty;
+
+	gcc_pure
+	bool IsValid(time_t new_mtime) const {
+		return new_mtime == mtime && mtime < checked;
+	}
+};
+
+/**
+ * Protects #spl_cache and #spl_list, because "listplaylist" and
+ * "listplaylists" may run in worker threads.
+ */
+static Mutex spl_cache_mutex;
+
+/**
+ * Recently used stored playlists, indexed by their UTF-8 name.
+ */
+static std::map<std::string, CachedPlaylistFile> spl_cache;
+
+/**
+ * The total number of songs in #spl_cache.
+ */
+static size_t spl_cache_songs;
+
+/**
+ * The cached result of ListPlaylistFiles().  It is valid while the
+ * modification time of the playlist directory equals
+ * #spl_list_mtime.
+ */
+static PlaylistVector spl_list;
+static bool spl_list_valid;
+static time_t spl_list_mtime, spl_list_checked;
+
+/**
+ * Has the last write-back failed?  Until one succeeds, modifications
+ * are written synchronously, so the client gets to see the error.
+ * Protected by #spl_cache_mutex.
+ */
+static bool spl_write_back_failed;
+
+static void
+spl_flush_all();
+
+/**
+ * Writes dirty #spl_cache entries to disk after
+ * #SPL_WRITE_BACK_DELAY.
+ */
+class PlaylistWriteBack final : TimeoutMonitor {
+public:
+	explicit PlaylistWriteBack(EventLoop &_loop)
+		:TimeoutMonitor(_loop) {}
+
+	void Schedule() {
+		if (!IsActive())
+			ScheduleSeconds(SPL_WRITE_BACK_DELAY);
+	}
+
+	void ScheduleRetry() {
+		ScheduleSeconds(SPL_WRITE_BACK_RETRY_DELAY);
+	}
+
+private:
+	virtual void OnTimeout() override {
+		spl_flush_all();
+	}
+};
+
+static PlaylistWriteBack *spl_write_back;
+
 void
-spl_global_init(void)
+spl_global_init(EventLoop &loop)
 {
 	playlist_max_length = config_get_positive(CONF_MAX_PLAYLIST_LENGTH,
 						  DEFAULT_PLAYLIST_MAX_LENGTH);
@@ -59,6 +174,22 @@ spl_global_init(void)
 	playlist_saveAbsolutePaths =
 		config_get_bool(CONF_SAVE_ABSOLUTE_PATHS,
 				DEFAULT_PLAYLIST_SAVE_ABSOLUTE_PATHS);
+
+	spl_write_back = new PlaylistWriteBack(loop);
+}
+
+void
+spl_global_finish()
+{
+	spl_flush_all();
+
+	delete spl_write_back;
+	spl_write_back = nullptr;
+
+	spl_cache.clear();
+	spl_cache_songs = 0;
+	spl_list.erase(spl_list.begin(), spl_list.end());
+	spl_list_valid = false;
 }
 
 bool
@@ -188,6 +319,29 @@ LoadPlaylistFileInfo(PlaylistInfo &info,
 	return true;
 }
 
+/**
+ * Determines the modification time of a file.
+ *
+ * @return false if the file cannot be accessed
+ */
+static bool
+GetModificationTime(Path path_fs, time_t &mtime_r)
+{
+	struct stat st;
+	if (!StatFile(path_fs, st))
+		return false;
+
+	mtime_r = st.st_mtime;
+	return true;
+}
+
+static void
+CopyPlaylistVector(PlaylistVector &dest, const PlaylistVector &src)
+{
+	for (const auto &i : src)
+		dest.push_back(PlaylistInfo(i.name, i.mtime));
+}
+
 PlaylistVector
 ListPlaylistFiles(Error &error)
 {
@@ -197,6 +351,20 @@ ListPlaylistFiles(Error &error)
 	if (parent_path_fs.IsNull())
 		return list;
 
+	const ScopeLock protect(spl_cache_mutex);
+
+	/* creating, deleting or renaming a playlist file modifies
+	   the directory; everything else is tracked by this
+	   library */
+	time_t mtime;
+	if (spl_list_valid && GetModificationTime(parent_path_fs, mtime) &&
+	    mtime == spl_list_mtime && mtime < spl_list_checked) {
+		CopyPlaylistVector(list, spl_list);
+		return list;
+	}
+
+	const time_t now = time(nullptr);
+
 	DirectoryReader reader(parent_path_fs);
 	if (reader.HasFailed()) {
 		error.SetErrno();
@@ -210,9 +378,61 @@ ListPlaylistFiles(Error &error)
 			list.push_back(std::move(info));
 	}
 
+	spl_list.erase(spl_list.begin(), spl_list.end());
+	CopyPlaylistVector(spl_list, list);
+	spl_list_valid = GetModificationTime(parent_path_fs, spl_list_mtime);
+	spl_list_checked = now;
+
 	return list;
 }
 
+/**
+ * Updates one entry of #spl_list.  Caller must lock
+ * #spl_cache_mutex.
+ */
+static void
+spl_list_update(const char *utf8path, time_t mtime)
+{
+	if (!spl_list_valid)
+		return;
+
+	/* not using PlaylistVector::UpdateOrInsert(), because that
+	   one is protected by the database lock */
+	auto i = std::find_if(spl_list.begin(), spl_list.end(),
+			      PlaylistInfo::CompareName(utf8path));
+	if (i != spl_list.end())
+		i->mtime = mtime;
+	else
+		spl_list.push_back(PlaylistInfo(utf8path, mtime));
+}
+
+/**
+ * Removes one entry from #spl_list.  Caller must lock
+ * #spl_cache_mutex.
+ */
+static void
+spl_list_erase(const char *utf8path)
+{
+	auto i = std::find_if(spl_list.begin(), spl_list.end(),
+			      PlaylistInfo::CompareName(utf8path));
+	if (i != spl_list.end())
+		spl_list.erase(i);
+}
+
+/**
+ * Updates one entry of #spl_list with the modification time of the
+ * file.  Caller must lock #spl_cache_mutex.
+ */
+static void
+spl_list_update(const char *utf8path, Path path_fs)
+{
+	time_t mtime;
+	if (GetModificationTime(path_fs, mtime))
+		spl_list_update(utf8path, mtime);
+	else
+		spl_list_valid = false;
+}
+
 static bool
 SavePlaylistFile(const PlaylistFileContents &contents, const char *utf8path,
 		 Error &error)
@@ -239,18 +459,11 @@ SavePlaylistFile(const PlaylistFileContents &contents, const char *utf8path,
 	return true;
 }
 
-PlaylistFileContents
-LoadPlaylistFile(const char *utf8path, Error &error)
+static PlaylistFileContents
+ReadPlaylistFile(Path path_fs, Error &error)
 {
 	PlaylistFileContents contents;
 
-	if (spl_map(error).IsNull())
-		return contents;
-
-	const auto path_fs = spl_map_to_fs(utf8path, error);
-	if (path_fs.IsNull())
-		return contents;
-
 	TextFile file(path_fs, error);
 	if (file.HasFailed()) {
 		TranslatePlaylistError(error);
@@ -294,6 +507,242 @@ LoadPlaylistFile(const char *utf8path, Error &error)
 	return contents;
 }
 
+/**
+ * Writes a dirty #spl_cache entry to the file.  Caller must lock
+ * #spl_cache_mutex.
+ */
+static bool
+spl_cache_write(const char *utf8path, CachedPlaylistFile &entry,
+		Error &error)
+{
+	assert(entry.dirty);
+
+	const auto path_fs = spl_map_to_fs(utf8path, error);
+	if (path_fs.IsNull())
+		return false;
+
+	/* don't overwrite (or recreate) a file which was modified
+	   (or deleted) by somebody else since we read it; discard
+	   our modifications, and let spl_cache_get() reload it */
+	time_t mtime;
+	if (!GetModificationTime(path_fs, mtime)) {
+		entry.dirty = false;
+		error.Set(playlist_domain, int(PlaylistResult::NO_SUCH_LIST),
+			  "No such playlist");
+		return false;
+	}
+
+	if (mtime != entry.mtime) {
+		entry.dirty = false;
+		error.Format(playlist_domain, int(PlaylistResult::ERRNO),
+			     "Playlist \"%s\" was modified by another program",
+			     utf8path);
+		return false;
+	}
+
+	if (!SavePlaylistFile(entry.contents, utf8path, error))
+		return false;
+
+	entry.dirty = false;
+	entry.checked = time(nullptr);
+
+	if (!GetModificationTime(path_fs, entry.mtime))
+		/* force a reload */
+		entry.mtime = entry.checked;
+	else
+		spl_list_update(utf8path, entry.mtime);
+
+	return true;
+}
+
+/**
+ * Discards the #spl_cache entry of the specified playlist, after
+ * writing pending modifications.  Caller must lock
+ * #spl_cache_mutex.
+ */
+static bool
+spl_cache_remove(const char *utf8path, bool write, Error &error)
+{
+	auto i = spl_cache.find(utf8path);
+	if (i == spl_cache.end())
+		return true;
+
+	if (write && i->second.dirty &&
+	    !spl_cache_write(utf8path, i->second, error))
+		return false;
+
+	spl_cache_songs -= i->second.contents.size();
+	spl_cache.erase(i);
+	return true;
+}
+
+/**
+ * Makes room in #spl_cache by discarding all entries without pending
+ * modifications, except the specified one.  Caller must lock
+ * #spl_cache_mutex.
+ */
+static void
+spl_cache_shrink(const CachedPlaylistFile &keep)
+{
+	for (auto i = spl_cache.begin(); i != spl_cache.end();) {
+		if (&i->second == &keep || i->second.dirty) {
+			++i;
+			continue;
+		}
+
+		spl_cache_songs -= i->second.contents.size();
+		i = spl_cache.erase(i);
+	}
+}
+
+/**
+ * Returns the cached copy of the specified stored playlist, and
+ * (re)loads it from the file if necessary.  Caller must lock
+ * #spl_cache_mutex.
+ *
+ * @return the entry or nullptr on error
+ */
+static CachedPlaylistFile *
+spl_cache_get(const char *utf8path, Error &error)
+{
+	if (spl_map(error).IsNull())
+		return nullptr;
+
+	const auto path_fs = spl_map_to_fs(utf8path, error);
+	if (path_fs.IsNull())
+		return nullptr;
+
+	auto i = spl_cache.find(utf8path);
+	if (i != spl_cache.end()) {
+		CachedPlaylistFile &entry = i->second;
+
+		time_t mtime;
+		if (entry.dirty ||
+		    (GetModificationTime(path_fs, mtime) &&
+		     entry.IsValid(mtime)))
+			return &entry;
+
+		/* modified by somebody else */
+		spl_cache_songs -= entry.contents.size();
+		spl_cache.erase(i);
+	}
+
+	/* obtain the modification time before reading, so a
+	   concurrent modification will be noticed next time */
+	CachedPlaylistFile entry;
+	entry.checked = time(nullptr);
+	entry.dirty = false;
+	if (!GetModificationTime(path_fs, entry.mtime))
+		entry.mtime = entry.checked;
+
+	entry.contents = ReadPlaylistFile(path_fs, error);
+	if (entry.contents.empty() && error.IsDefined())
+		return nullptr;
+
+	spl_cache_songs += entry.contents.size();
+
+	auto &result = spl_cache[utf8path] = std::move(entry);
+	if (spl_cache_songs > SPL_CACHE_MAX_SONGS)
+		spl_cache_shrink(result);
+
+	return &result;
+}
+
+/**
+ * Marks a #spl_cache entry as modified, and schedules writing it.
+ * Caller must lock #spl_cache_mutex.
+ */
+static bool
+spl_cache_modified(const char *utf8path, CachedPlaylistFile &entry,
+		   Error &error)
+{
+	entry.dirty = true;
+	spl_list_update(utf8path, time(nullptr));
+
+	if (spl_write_back != nullptr && !spl_write_back_failed) {
+		spl_write_back->Schedule();
+		return true;
+	}
+
+	/* not initialized, or the file system refused the last
+	   write-back: write it right now and report errors to the
+	   client */
+	if (!spl_cache_write(utf8path, entry, error)) {
+		/* the cache must not pretend that the file contains
+		   this modification */
+		spl_cache_remove(utf8path, false, IgnoreError());
+		return false;
+	}
+
+	spl_write_back_failed = false;
+	return true;
+}
+
+static void
+spl_flush_all()
+{
+	const ScopeLock protect(spl_cache_mutex);
+
+	bool failed = false;
+	for (auto &i : spl_cache) {
+		if (!i.second.dirty)
+			continue;
+
+		Error error;
+		if (!spl_cache_write(i.first.c_str(), i.second, error)) {
+			LogError(error);
+
+			/* a conflict has cleared the "dirty" flag;
+			   only a failed write is worth a retry */
+			if (i.second.dirty)
+				failed = true;
+		}
+	}
+
+	spl_write_back_failed = failed;
+	if (failed && spl_write_back != nullptr)
+		spl_write_back->ScheduleRetry();
+}
+
+void
+spl_flush(const char *utf8path)
+{
+	const ScopeLock protect(spl_cache_mutex);
+
+	auto i = spl_cache.find(utf8path);
+	if (i == spl_cache.end() || !i->second.dirty)
+		return;
+
+	Error error;
+	if (!spl_cache_write(utf8path, i->second, error)) {
+		LogError(error);
+
+		if (i->second.dirty)
+			spl_write_back_failed = true;
+	}
+}
+
+void
+spl_invalidate(const char *utf8path)
+{
+	const ScopeLock protect(spl_cache_mutex);
+
+	spl_cache_remove(utf8path, false, IgnoreError());
+	spl_list_valid = false;
+}
+
+PlaylistFileContents
+LoadPlaylistFile(const char *utf8path, Error &error)
+{
+	const ScopeLock protect(spl_cache_mutex);
+
+	const CachedPlaylistFile *entry = spl_cache_get(utf8path, error);
+	if (entry == nullptr)
+		return PlaylistFileContents();
+
+	return entry->contents;
+}
+
 bool
 spl_move_index(const char *utf8path, unsigned src, unsigned dest,
 	       Error &error)
@@ -303,24 +752,26 @@ spl_move_index(const char *utf8path, unsigned src, unsigned dest,
 		   what the hell.. */
 		return true;
 
-	auto contents = LoadPlaylistFile(utf8path, error);
-	if (contents.empty() && error.IsDefined())
+	const ScopeLock protect(spl_cache_mutex);
+
+	CachedPlaylistFile *entry = spl_cache_get(utf8path, error);
+	if (entry == nullptr)
 		return false;
 
+	auto &contents = entry->contents;
 	if (src >= contents.size() || dest >= contents.size()) {
 		error.Set(playlist_domain, int(PlaylistResult::BAD_RANGE),
 			  "Bad range");
 		return false;
 	}
 
-	const auto src_i = std::next(contents.begin(), src);
-	auto value = std::move(*src_i);
-	contents.erase(src_i);
-
-	const auto dest_i = std::next(contents.begin(), dest);
-	contents.insert(dest_i, std::move(value));
+	const auto begin = contents.begin();
+	if (src < dest)
+		std::rotate(begin + src, begin + src + 1, begin + dest + 1);
+	else
+		std::rotate(begin + dest, begin + src, begin + src + 1);
 
-	bool result = SavePlaylistFile(contents, utf8path, error);
+	bool result = spl_cache_modified(utf8path, *entry, error);
 
 	idle_add(IDLE_STORED_PLAYLIST);
 	return result;
@@ -336,6 +787,11 @@ spl_clear(const char *utf8path, Error &error)
 	if (path_fs.IsNull())
 		return false;
 
+	const ScopeLock protect(spl_cache_mutex);
+
+	/* pending modifications are obsolete */
+	spl_cache_remove(utf8path, false, error);
+
 	FILE *file = FOpen(path_fs, FOpenMode::WriteText);
 	if (file == nullptr) {
 		playlist_errno(error);
@@ -344,6 +800,8 @@ spl_clear(const char *utf8path, Error &error)
 
 	fclose(file);
 
+	spl_list_update(utf8path, path_fs);
+
 	idle_add(IDLE_STORED_PLAYLIST);
 	return true;
 }
@@ -355,11 +813,17 @@ spl_delete(const char *name_utf8, Error &error)
 	if (path_fs.IsNull())
 		return false;
 
+	const ScopeLock protect(spl_cache_mutex);
+
+	spl_cache_remove(name_utf8, false, error);
+
 	if (!RemoveFile(path_fs)) {
 		playlist_errno(error);
 		return false;
 	}
 
+	spl_list_erase(name_utf8);
+
 	idle_add(IDLE_STORED_PLAYLIST);
 	return true;
 }
@@ -367,19 +831,23 @@ spl_delete(const char *name_utf8, Error &error)
 bool
 spl_remove_index(const char *utf8path, unsigned pos, Error &error)
 {
-	auto contents = LoadPlaylistFile(utf8path, error);
-	if (contents.empty() && error.IsDefined())
+	const ScopeLock protect(spl_cache_mutex);
+
+	CachedPlaylistFile *entry = spl_cache_get(utf8path, error);
+	if (entry == nullptr)
 		return false;
 
+	auto &contents = entry->contents;
 	if (pos >= contents.size()) {
 		error.Set(playlist_domain, int(PlaylistResult::BAD_RANGE),
 			  "Bad range");
 		return false;
 	}
 
-	contents.erase(std::next(contents.begin(), pos));
+	contents.erase(contents.begin() + pos);
+	--spl_cache_songs;
 
-	bool result = SavePlaylistFile(contents, utf8path, error);
+	bool result = spl_cache_modified(utf8path, *entry, error);
 
 	idle_add(IDLE_STORED_PLAYLIST);
 	return result;
@@ -395,6 +863,13 @@ spl_append_song(const char *utf8path, const DetachedSong &song, Error &error)
 	if (path_fs.IsNull())
 		return false;
 
+	const ScopeLock protect(spl_cache_mutex);
+
+	/* appending to the file is cheap; the cached copy will be
+	   reloaded when it is needed again */
+	if (!spl_cache_remove(utf8path, true, error))
+		return false;
+
 	FILE *file = FOpen(path_fs, FOpenMode::AppendText);
 	if (file == nullptr) {
 		playlist_errno(error);
@@ -419,6 +894,8 @@ spl_append_song(const char *utf8path, const DetachedSong &song, Error &error)
 
 	fclose(file);
 
+	spl_list_update(utf8path, path_fs);
+
 	idle_add(IDLE_STORED_PLAYLIST);
 	return true;
 }
@@ -476,5 +953,12 @@ spl_rename(const char *utf8from, const char *utf8to, Error &error)
 	if (to_path_fs.IsNull())
 		return false;
 
+	const ScopeLock protect(spl_cache_mutex);
+
+	if (!spl_cache_remove(utf8from, true, error))
+		return false;
+
+	spl_list_valid = false;
+
 	return spl_rename_internal(from_path_fs, to_path_fs, error);
 }
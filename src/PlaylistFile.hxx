@@ -23,6 +23,7 @@
 #include <vector>
 #include <string>
 
+class EventLoop;
 class DetachedSong;
 class SongLoader;
 class PlaylistVector;
@@ -34,9 +35,33 @@ extern bool playlist_saveAbsolutePaths;
 
 /**
  * Perform some global initialization, e.g. load configuration values.
+ *
+ * @param loop the #EventLoop which schedules writing modified stored
+ * playlists
+ */
+void
+spl_global_init(EventLoop &loop);
+
+/**
+ * Write all pending modifications and free the stored playlist
+ * cache.
+ */
+void
+spl_global_finish();
+
+/**
+ * Write pending modifications of the specified stored playlist to
+ * its file.  Call this before reading the file directly.
+ */
+void
+spl_flush(const char *name_utf8);
+
+/**
+ * Discard the cached copy of the specified stored playlist.  Call
+ * this after the file has been modified directly.
  */
 void
-spl_global_init(void);
+spl_invalidate(const char *name_utf8);
 
 /**
  * Determines whether the specified string is a valid name for a
@@ -90,6 +90,8 @@ spl_save_queue(const char *name_utf8, const Queue &queue)
 
 	fclose(file);
 
+	spl_invalidate(name_utf8);
+
 	idle_add(IDLE_STORED_PLAYLIST);
 	return PlaylistResult::SUCCESS;
 }
@@ -34,6 +34,7 @@
 #include "tag/TagHandler.hxx"
 #include "tag/TagId3.hxx"
 #include "tag/ApeTag.hxx"
+#include "tag/TagFileBuffer.hxx"
 #include "TagFile.hxx"
 #include "TagStream.hxx"
 
@@ -66,20 +67,39 @@ Song::LoadFile(Storage &storage, const char *path_utf8, Directory &parent)
 #endif
 
 /**
- * Attempts to load APE or ID3 tags from the specified file.
+ * Attempts to load APE or ID3 tags from the specified file.  The file
+ * is opened only once for both parsers.
  */
 static bool
 tag_scan_fallback(Path path,
 		  const struct tag_handler *handler, void *handler_ctx)
 {
-	return tag_ape_scan2(path, handler, handler_ctx) ||
-		tag_id3_scan(path, handler, handler_ctx);
+	TagFileBuffer file(path);
+	if (!file.IsDefined())
+		return false;
+
+	return tag_ape_scan2(file, handler, handler_ctx) ||
+		tag_id3_scan(file, handler, handler_ctx);
 }
 
 #ifdef ENABLE_DATABASE
 
 bool
 Song::UpdateFile(Storage &storage)
+{
+	TagBuilder tag_builder;
+	time_t new_mtime;
+	if (!ScanFile(storage, new_mtime, tag_builder))
+		return false;
+
+	mtime = new_mtime;
+	tag_builder.Commit(tag);
+	return true;
+}
+
+bool
+Song::ScanFile(Storage &storage, time_t &mtime_r,
+	       TagBuilder &tag_builder) const
 {
 	const auto &relative_uri = GetURI();
 
@@ -90,8 +110,6 @@ Song::UpdateFile(Storage &storage)
 	if (!info.IsRegular())
 		return false;
 
-	TagBuilder tag_builder;
-
 	const auto path_fs = storage.MapFS(relative_uri.c_str());
 	if (path_fs.IsNull()) {
 		const auto absolute_uri =
@@ -108,8 +126,7 @@ Song::UpdateFile(Storage &storage)
 					  &tag_builder);
 	}
 
-	mtime = info.mtime;
-	tag_builder.Commit(tag);
+	mtime_r = info.mtime;
 	return true;
 }
 
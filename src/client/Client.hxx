@@ -42,6 +42,7 @@ class Path;
 struct Partition;
 class Database;
 class Storage;
+struct BackgroundCommand;
 
 class Client final
 	: FullyBufferedSocket, TimeoutMonitor,
@@ -66,6 +67,25 @@ public:
 
 	unsigned int num;	/* client number */
 
+	/**
+	 * The name of the command being executed, for the "ACK"
+	 * response generated by command_error().  This is not a
+	 * global variable because commands may run on a worker
+	 * thread.
+	 */
+	const char *current_command;
+
+	/** the position of #current_command in the command list */
+	int command_list_num;
+
+	/**
+	 * The command which is currently being executed by a worker
+	 * thread, or nullptr.  While this is set, the output of this
+	 * client is collected in BackgroundCommand::output, and no
+	 * further input is processed.
+	 */
+	BackgroundCommand *background;
+
 	/** is this client waiting for an "idle" response? */
 	bool idle_waiting;
 
@@ -112,6 +132,25 @@ public:
 	void Close();
 	void SetExpired();
 
+	/**
+	 * Is a worker thread executing a command for this client?
+	 */
+	bool IsBusy() const {
+		return background != nullptr;
+	}
+
+	/**
+	 * Hand the given command line to the #ClientWorkerPool.
+	 */
+	void StartBackground(const char *line);
+
+	/**
+	 * Called by the #ClientWorkerPool in the main thread after
+	 * the worker thread has finished executing the command.
+	 * Sends the response and resumes processing input.
+	 */
+	void OnBackgroundFinished(BackgroundCommand &cmd);
+
 	using FullyBufferedSocket::Write;
 
 	/**
@@ -200,12 +239,31 @@ private:
 	virtual void OnTimeout() override;
 };
 
-void client_manager_init(void);
+void client_manager_init(EventLoop &loop);
+
+void client_manager_finish();
 
 void
 client_new(EventLoop &loop, Partition &partition,
 	   int fd, const sockaddr *sa, size_t sa_length, int uid);
 
+struct ClientIdleStats {
+	/** the number of "idle" responses sent to clients */
+	unsigned long notifications;
+
+	/** the number of "changed" lines in these responses */
+	unsigned long events;
+
+	/** the number of distinct responses which were formatted */
+	unsigned formatted;
+};
+
+/**
+ * Returns counters about "idle" notifications.
+ */
+const ClientIdleStats &
+client_idle_get_stats();
+
 /**
  * Write a C string to the client.
  */
@@ -19,17 +19,22 @@
 
 #include "config.h"
 #include "ClientInternal.hxx"
+#include "ClientWorker.hxx"
 #include "config/ConfigGlobal.hxx"
+#include "system/FatalError.hxx"
+#include "util/Error.hxx"
 
 #define CLIENT_TIMEOUT_DEFAULT			(60)
 #define CLIENT_MAX_COMMAND_LIST_DEFAULT		(2048*1024)
 #define CLIENT_MAX_OUTPUT_BUFFER_SIZE_DEFAULT	(8192*1024)
+#define CLIENT_WORKER_THREADS_DEFAULT		(2)
 
 int client_timeout;
 size_t client_max_command_list_size;
 size_t client_max_output_buffer_size;
+ClientWorkerPool *client_worker_pool;
 
-void client_manager_init(void)
+void client_manager_init(EventLoop &loop)
 {
 	client_timeout = config_get_positive(CONF_CONN_TIMEOUT,
 					     CLIENT_TIMEOUT_DEFAULT);
@@ -42,4 +47,25 @@ void client_manager_init(void)
 		config_get_positive(CONF_MAX_OUTPUT_BUFFER_SIZE,
 				    CLIENT_MAX_OUTPUT_BUFFER_SIZE_DEFAULT / 1024)
 		* 1024;
+
+	const unsigned worker_threads =
+		config_get_unsigned(CONF_WORKER_THREADS,
+				    CLIENT_WORKER_THREADS_DEFAULT);
+	if (worker_threads > 0) {
+		client_worker_pool =
+			new ClientWorkerPool(loop, worker_threads);
+
+		Error error;
+		if (!client_worker_pool->Start(error))
+			FatalError(error);
+	}
+}
+
+void client_manager_finish()
+{
+	if (client_worker_pool != nullptr) {
+		client_worker_pool->Stop();
+		delete client_worker_pool;
+		client_worker_pool = nullptr;
+	}
 }
@@ -21,26 +21,81 @@
 #include "ClientInternal.hxx"
 #include "Idle.hxx"
 
+#include <string>
+#include <map>
+
 #include <assert.h>
 
+/**
+ * Preformatted "idle" responses, indexed by the mask of reported
+ * flags.  They are shared by all clients, so a change which is
+ * broadcast to many waiting clients is formatted only once.  There
+ * are only few distinct masks in practice, but each one is a
+ * combination of flags, so up to 2^N of them are possible; the map
+ * is therefore limited to #IDLE_RESPONSES_MAX entries.
+ */
+static std::map<unsigned, std::string> idle_responses;
+
+static constexpr size_t IDLE_RESPONSES_MAX = 64;
+
+static ClientIdleStats idle_stats;
+
+const ClientIdleStats &
+client_idle_get_stats()
+{
+	return idle_stats;
+}
+
+static const std::string &
+idle_get_response(unsigned flags)
+{
+	auto i = idle_responses.find(flags);
+	if (i != idle_responses.end())
+		return i->second;
+
+	std::string response;
+
+	const char *const*idle_names = idle_get_names();
+	for (unsigned j = 0; idle_names[j]; ++j) {
+		if (flags & (1 << j)) {
+			response += "changed: ";
+			response += idle_names[j];
+			response += '\n';
+		}
+	}
+
+	response += "OK\n";
+
+	++idle_stats.formatted;
+
+	if (idle_responses.size() >= IDLE_RESPONSES_MAX)
+		/* unusual flag combinations have filled the map;
+		   start over */
+		idle_responses.clear();
+
+	return idle_responses.insert(std::make_pair(flags,
+						    std::move(response)))
+		.first->second;
+}
+
 void
 Client::IdleNotify()
 {
 	assert(idle_waiting);
 	assert(idle_flags != 0);
 
-	unsigned flags = idle_flags;
+	const unsigned flags = idle_flags & idle_subscriptions;
 	idle_flags = 0;
 	idle_waiting = false;
 
-	const char *const*idle_names = idle_get_names();
-	for (unsigned i = 0; idle_names[i]; ++i) {
-		if (flags & (1 << i) & idle_subscriptions)
-			client_printf(*this, "changed: %s\n",
-				      idle_names[i]);
-	}
+	/* one write per client, no matter how many subsystems have
+	   changed */
+	const std::string &response = idle_get_response(flags);
+	if (!IsExpired())
+		Write(response.data(), response.length());
 
-	client_puts(*this, "OK\n");
+	++idle_stats.notifications;
+	idle_stats.events += __builtin_popcount(flags);
 
 	TimeoutMonitor::ScheduleSeconds(client_timeout);
 }
@@ -27,12 +27,19 @@
 static constexpr unsigned CLIENT_MAX_SUBSCRIPTIONS = 16;
 static constexpr unsigned CLIENT_MAX_MESSAGES = 64;
 
+class ClientWorkerPool;
+
 extern const class Domain client_domain;
 
 extern int client_timeout;
 extern size_t client_max_command_list_size;
 extern size_t client_max_output_buffer_size;
 
+/**
+ * Executes read-only commands; nullptr if disabled.
+ */
+extern ClientWorkerPool *client_worker_pool;
+
 CommandResult
 client_process_line(Client &client, char *line);
 
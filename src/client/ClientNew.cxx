@@ -50,6 +50,8 @@ Client::Client(EventLoop &_loop, Partition &_partition,
 	 permission(getDefaultPermissions()),
 	 uid(_uid),
 	 num(_num),
+	 current_command(nullptr), command_list_num(0),
+	 background(nullptr),
 	 idle_waiting(false), idle_flags(0),
 	 num_subscriptions(0)
 {
@@ -108,6 +110,13 @@ client_new(EventLoop &loop, Partition &partition,
 void
 Client::Close()
 {
+	if (IsBusy()) {
+		/* a worker thread is still using this object; it
+		   will be deleted by OnBackgroundFinished() */
+		SetExpired();
+		return;
+	}
+
 	partition.instance.client_list->Remove(*this);
 
 	SetExpired();
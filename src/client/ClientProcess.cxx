@@ -23,6 +23,11 @@
 #include "command/AllCommands.hxx"
 #include "Log.hxx"
 
+#ifdef ENABLE_SQLITE
+#include "sticker/StickerDatabase.hxx"
+#include "util/Error.hxx"
+#endif
+
 #include <string.h>
 
 #define CLIENT_LIST_MODE_BEGIN "command_list_begin"
@@ -36,6 +41,16 @@ client_process_command_list(Client &client, bool list_ok,
 	CommandResult ret = CommandResult::OK;
 	unsigned num = 0;
 
+#ifdef ENABLE_SQLITE
+	/* commit all sticker modifications of this command list in
+	   one transaction; this is not possible with "list_OK",
+	   because that acknowledges each command before the
+	   transaction is committed */
+	const bool sticker_batch = !list_ok && sticker_enabled();
+	if (sticker_batch)
+		sticker_begin_batch();
+#endif
+
 	for (auto &&i : list) {
 		char *cmd = &*i.begin();
 
@@ -48,6 +63,21 @@ client_process_command_list(Client &client, bool list_ok,
 			client_puts(client, "list_OK\n");
 	}
 
+#ifdef ENABLE_SQLITE
+	if (sticker_batch) {
+		Error error;
+		if (!sticker_end_batch(error) && ret == CommandResult::OK) {
+			/* no response has been sent yet; report the
+			   lost modifications instead of "OK" */
+			client.current_command = "";
+			command_error(client, ACK_ERROR_SYSTEM, "%s",
+				      error.GetMessage());
+			client.current_command = nullptr;
+			ret = CommandResult::ERROR;
+		}
+	}
+#endif
+
 	return ret;
 }
 
@@ -119,6 +149,13 @@ client_process_line(Client &client, char *line)
 		} else if (strcmp(line, CLIENT_LIST_OK_MODE_BEGIN) == 0) {
 			client.cmd_list.Begin(true);
 			ret = CommandResult::OK;
+		} else if (client_worker_pool != nullptr &&
+			   command_is_background(client, line)) {
+			FormatDebug(client_domain,
+				    "[%u] process command \"%s\" in background",
+				    client.num, line);
+			client.StartBackground(line);
+			ret = CommandResult::BACKGROUND;
 		} else {
 			FormatDebug(client_domain,
 				    "[%u] process command \"%s\"",
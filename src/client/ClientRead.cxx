@@ -29,6 +29,11 @@
 BufferedSocket::InputResult
 Client::OnSocketInput(void *data, size_t length)
 {
+	if (IsBusy())
+		/* a worker thread is still executing the previous
+		   command; OnBackgroundFinished() will resume */
+		return InputResult::PAUSE;
+
 	char *p = (char *)data;
 	char *newline = (char *)memchr(p, '\n', length);
 	if (newline == nullptr)
@@ -51,6 +56,9 @@ Client::OnSocketInput(void *data, size_t length)
 	case CommandResult::ERROR:
 		break;
 
+	case CommandResult::BACKGROUND:
+		return InputResult::PAUSE;
+
 	case CommandResult::KILL:
 		Close();
 		partition.instance.event_loop->Break();
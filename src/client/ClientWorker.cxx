@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "config.h"
+#include "ClientWorker.hxx"
+#include "ClientInternal.hxx"
+#include "Partition.hxx"
+#include "Instance.hxx"
+#include "command/AllCommands.hxx"
+#include "protocol/Result.hxx"
+#include "thread/Thread.hxx"
+#include "thread/Name.hxx"
+#include "event/Loop.hxx"
+#include "util/Error.hxx"
+#include "Log.hxx"
+
+#include <assert.h>
+
+ClientWorkerPool::ClientWorkerPool(EventLoop &_loop, unsigned _n_threads)
+	:DeferredMonitor(_loop),
+	 n_threads(_n_threads), threads(new Thread[_n_threads]),
+	 quit(false)
+{
+	assert(n_threads > 0);
+}
+
+ClientWorkerPool::~ClientWorkerPool()
+{
+	assert(pending.empty());
+	assert(finished.empty());
+
+	delete[] threads;
+}
+
+bool
+ClientWorkerPool::Start(Error &error)
+{
+	for (unsigned i = 0; i < n_threads; ++i)
+		if (!threads[i].Start(Task, this, error))
+			return false;
+
+	return true;
+}
+
+static void
+DiscardCommands(std::list<BackgroundCommand *> &list)
+{
+	for (BackgroundCommand *cmd : list) {
+		cmd->client.background = nullptr;
+		delete cmd;
+	}
+
+	list.clear();
+}
+
+void
+ClientWorkerPool::Stop()
+{
+	mutex.lock();
+	quit = true;
+	cond.broadcast();
+	mutex.unlock();
+
+	for (unsigned i = 0; i < n_threads; ++i)
+		if (threads[i].IsDefined())
+			threads[i].Join();
+
+	DeferredMonitor::Cancel();
+
+	/* all threads have exited, no need to lock */
+	DiscardCommands(pending);
+	DiscardCommands(finished);
+}
+
+void
+ClientWorkerPool::Push(BackgroundCommand &cmd)
+{
+	const ScopeLock protect(mutex);
+	assert(!quit);
+
+	pending.push_back(&cmd);
+	cond.signal();
+}
+
+inline void
+ClientWorkerPool::Run()
+{
+	mutex.lock();
+
+	while (!quit) {
+		if (pending.empty()) {
+			cond.wait(mutex);
+			continue;
+		}
+
+		BackgroundCommand &cmd = *pending.front();
+		pending.pop_front();
+		mutex.unlock();
+
+		/* the command line is nul-terminated; tokenize it in
+		   place, just like the main thread does */
+		cmd.result = command_process(cmd.client, 0, &cmd.line[0]);
+
+		mutex.lock();
+
+		const bool was_empty = finished.empty();
+		finished.push_back(&cmd);
+		if (was_empty)
+			DeferredMonitor::Schedule();
+	}
+
+	mutex.unlock();
+}
+
+void
+ClientWorkerPool::Task(void *ctx)
+{
+	SetThreadName("client");
+
+	ClientWorkerPool &pool = *(ClientWorkerPool *)ctx;
+	pool.Run();
+}
+
+void
+ClientWorkerPool::RunDeferred()
+{
+	mutex.lock();
+	std::list<BackgroundCommand *> done;
+	done.swap(finished);
+	mutex.unlock();
+
+	for (BackgroundCommand *cmd : done)
+		cmd->client.OnBackgroundFinished(*cmd);
+}
+
+void
+Client::StartBackground(const char *line)
+{
+	assert(!IsBusy());
+	assert(client_worker_pool != nullptr);
+
+	/* the worker thread needs this object until the command has
+	   finished; don't let the timeout close the connection
+	   meanwhile */
+	TimeoutMonitor::Cancel();
+
+	background = new BackgroundCommand(*this, line);
+	client_worker_pool->Push(*background);
+}
+
+void
+Client::OnBackgroundFinished(BackgroundCommand &cmd)
+{
+	assert(&cmd == background);
+
+	background = nullptr;
+
+	const CommandResult result = cmd.result;
+	if (cmd.overflow) {
+		FormatWarning(client_domain,
+			      "[%u] output buffer is full", num);
+		SetExpired();
+	} else if (!IsExpired() && !cmd.output.empty())
+		Write(cmd.output.data(), cmd.output.length());
+
+	delete &cmd;
+
+	FormatDebug(client_domain,
+		    "[%u] background command returned %i", num, (int)result);
+
+	if (IsExpired()) {
+		Close();
+		return;
+	}
+
+	switch (result) {
+	case CommandResult::OK:
+		command_success(*this);
+		break;
+
+	case CommandResult::IDLE:
+	case CommandResult::BACKGROUND:
+		/* not possible for the commands which are executed
+		   in a worker thread */
+		assert(false);
+		gcc_unreachable();
+
+	case CommandResult::ERROR:
+		break;
+
+	case CommandResult::KILL:
+		Close();
+		partition.instance.event_loop->Break();
+		return;
+
+	case CommandResult::FINISH:
+		if (Flush())
+			Close();
+		return;
+
+	case CommandResult::CLOSE:
+		Close();
+		return;
+	}
+
+	if (IsExpired()) {
+		Close();
+		return;
+	}
+
+	TimeoutMonitor::ScheduleSeconds(client_timeout);
+
+	/* process the commands the client has sent meanwhile */
+	ResumeInput();
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MPD_CLIENT_WORKER_HXX
+#define MPD_CLIENT_WORKER_HXX
+
+#include "check.h"
+#include "command/CommandResult.hxx"
+#include "event/DeferredMonitor.hxx"
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+
+#include <string>
+#include <list>
+
+class Client;
+class Thread;
+class Error;
+
+/**
+ * A command line which is executed by a #ClientWorkerPool on behalf
+ * of a #Client.
+ */
+struct BackgroundCommand {
+	Client &client;
+
+	/**
+	 * The command line; command_process() modifies it in place
+	 * while tokenizing.
+	 */
+	std::string line;
+
+	/**
+	 * The response generated by the command, to be sent to the
+	 * client by the main thread.
+	 */
+	std::string output;
+
+	/**
+	 * Has #output exceeded "max_output_buffer_size"?  The
+	 * connection will be closed then, just like when the socket's
+	 * output buffer overflows.
+	 */
+	bool overflow;
+
+	CommandResult result;
+
+	BackgroundCommand(Client &_client, const char *_line)
+		:client(_client), line(_line), overflow(false),
+		 result(CommandResult::ERROR) {}
+};
+
+/**
+ * A pool of threads which execute read-only commands (database
+ * queries, stored playlists, sticker lookups) so one expensive
+ * request does not block all other clients.  Commands which modify
+ * MPD's state are always executed in the main thread.
+ *
+ * The response is collected in BackgroundCommand::output and handed
+ * back to the #Client in the main thread via #DeferredMonitor.
+ */
+class ClientWorkerPool final : DeferredMonitor {
+	const unsigned n_threads;
+	Thread *const threads;
+
+	Mutex mutex;
+	Cond cond;
+
+	/**
+	 * Commands waiting for a worker thread.  Protected by
+	 * #mutex.
+	 */
+	std::list<BackgroundCommand *> pending;
+
+	/**
+	 * Commands which have been executed, waiting to be
+	 * delivered by RunDeferred().  Protected by #mutex.
+	 */
+	std::list<BackgroundCommand *> finished;
+
+	bool quit;
+
+public:
+	ClientWorkerPool(EventLoop &_loop, unsigned _n_threads);
+	~ClientWorkerPool();
+
+	bool Start(Error &error);
+
+	/**
+	 * Stop all worker threads.  Commands which were not yet
+	 * delivered are discarded.  Must be called before the
+	 * clients are destroyed.
+	 */
+	void Stop();
+
+	/**
+	 * Enqueue a command.  The pool takes over ownership; it is
+	 * passed to Client::OnBackgroundFinished() when done.
+	 */
+	void Push(BackgroundCommand &cmd);
+
+private:
+	void Run();
+	static void Task(void *ctx);
+
+	/* virtual methods from class DeferredMonitor */
+	virtual void RunDeferred() override;
+};
+
+#endif
@@ -19,6 +19,7 @@
 
 #include "config.h"
 #include "ClientInternal.hxx"
+#include "ClientWorker.hxx"
 #include "util/FormatString.hxx"
 
 #include <string.h>
@@ -29,6 +30,18 @@
 static void
 client_write(Client &client, const char *data, size_t length)
 {
+	if (client.IsBusy()) {
+		/* called by a worker thread: collect the output, it
+		   will be sent by the main thread */
+		BackgroundCommand &cmd = *client.background;
+		if (cmd.output.length() + length >
+		    client_max_output_buffer_size)
+			cmd.overflow = true;
+		else if (!cmd.overflow)
+			cmd.output.append(data, length);
+		return;
+	}
+
 	/* if the client is going to be closed, do nothing */
 	if (client.IsExpired() || length == 0)
 		return;
@@ -36,8 +36,14 @@
 #include "Partition.hxx"
 #include "client/Client.hxx"
 #include "util/Tokenizer.hxx"
+#include "util/Macros.hxx"
 #include "util/Error.hxx"
 
+#ifdef ENABLE_DATABASE
+#include "db/Interface.hxx"
+#include "db/DatabasePlugin.hxx"
+#endif
+
 #ifdef ENABLE_SQLITE
 #include "StickerCommands.hxx"
 #include "sticker/StickerDatabase.hxx"
@@ -102,6 +108,8 @@ static const struct command commands[] = {
 	{ "findadd", PERMISSION_ADD, 2, -1, handle_findadd},
 #endif
 	{ "idle", PERMISSION_READ, 0, -1, handle_idle },
+	{ "idlestats", PERMISSION_READ, 0, 0, handle_idlestats },
+	{ "inputstats", PERMISSION_READ, 0, 0, handle_inputstats },
 	{ "kill", PERMISSION_ADMIN, -1, -1, handle_kill },
 #ifdef ENABLE_DATABASE
 	{ "list", PERMISSION_READ, 1, -1, handle_list },
@@ -120,6 +128,7 @@ static const struct command commands[] = {
 	{ "listplaylists", PERMISSION_READ, 0, 0, handle_listplaylists },
 	{ "load", PERMISSION_ADD, 1, 2, handle_load },
 	{ "lsinfo", PERMISSION_READ, 0, 1, handle_lsinfo },
+	{ "memorystats", PERMISSION_READ, 0, 0, handle_memorystats },
 	{ "mixrampdb", PERMISSION_CONTROL, 1, 1, handle_mixrampdb },
 	{ "mixrampdelay", PERMISSION_CONTROL, 1, 1, handle_mixrampdelay },
 #ifdef ENABLE_DATABASE
@@ -130,6 +139,7 @@ static const struct command commands[] = {
 	{ "next", PERMISSION_CONTROL, 0, 0, handle_next },
 	{ "notcommands", PERMISSION_NONE, 0, 0, handle_not_commands },
 	{ "outputs", PERMISSION_READ, 0, 0, handle_devices },
+	{ "outputstats", PERMISSION_READ, 0, 0, handle_outputstats },
 	{ "password", PERMISSION_NONE, 1, 1, handle_password },
 	{ "pause", PERMISSION_CONTROL, 0, 1, handle_pause },
 	{ "ping", PERMISSION_NONE, 0, 0, handle_ping },
@@ -196,6 +206,33 @@ static const struct command commands[] = {
 
 static const unsigned num_commands = sizeof(commands) / sizeof(commands[0]);
 
+/**
+ * These commands only read from the database, the stored playlists
+ * and the sticker database.  They may be executed by a worker thread.
+ */
+static const char *const background_commands[] = {
+	"count",
+	"find",
+	"list",
+	"listall",
+	"listallinfo",
+	"listplaylist",
+	"listplaylistinfo",
+	"listplaylists",
+	"lsinfo",
+	"search",
+};
+
+/**
+ * The "sticker" sub-commands which do not modify the sticker
+ * database.
+ */
+static const char *const background_sticker_commands[] = {
+	"get",
+	"list",
+	"find",
+};
+
 static bool
 command_available(gcc_unused const Partition &partition,
 		  gcc_unused const struct command *cmd)
@@ -324,7 +361,7 @@ command_checked_lookup(Client &client, unsigned permission,
 {
 	const struct command *cmd;
 
-	current_command = "";
+	client.current_command = "";
 
 	if (argc == 0)
 		return nullptr;
@@ -336,7 +373,7 @@ command_checked_lookup(Client &client, unsigned permission,
 		return nullptr;
 	}
 
-	current_command = cmd->cmd;
+	client.current_command = cmd->cmd;
 
 	if (!command_check_request(cmd, client, permission, argc, argv))
 		return nullptr;
@@ -352,14 +389,14 @@ command_process(Client &client, unsigned num, char *line)
 	const struct command *cmd;
 	CommandResult ret = CommandResult::ERROR;
 
-	command_list_num = num;
+	client.command_list_num = num;
 
 	/* get the command name (first word on the line) */
 
 	Tokenizer tokenizer(line);
 	argv[0] = tokenizer.NextWord(error);
 	if (argv[0] == nullptr) {
-		current_command = "";
+		client.current_command = "";
 		if (tokenizer.IsEnd())
 			command_error(client, ACK_ERROR_UNKNOWN,
 				      "No command given");
@@ -367,7 +404,7 @@ command_process(Client &client, unsigned num, char *line)
 			command_error(client, ACK_ERROR_UNKNOWN,
 				      "%s", error.GetMessage());
 
-		current_command = nullptr;
+		client.current_command = nullptr;
 
 		/* this client does not speak the MPD protocol; kick
 		   the connection */
@@ -386,17 +423,17 @@ command_process(Client &client, unsigned num, char *line)
 	/* some error checks; we have to set current_command because
 	   command_error() expects it to be set */
 
-	current_command = argv[0];
+	client.current_command = argv[0];
 
 	if (argc >= COMMAND_ARGV_MAX) {
 		command_error(client, ACK_ERROR_ARG, "Too many arguments");
-		current_command = nullptr;
+		client.current_command = nullptr;
 		return CommandResult::ERROR;
 	}
 
 	if (!tokenizer.IsEnd()) {
 		command_error(client, ACK_ERROR_ARG, "%s", error.GetMessage());
-		current_command = nullptr;
+		client.current_command = nullptr;
 		return CommandResult::ERROR;
 	}
 
@@ -407,8 +444,56 @@ command_process(Client &client, unsigned num, char *line)
 	if (cmd)
 		ret = cmd->handler(client, argc, argv);
 
-	current_command = nullptr;
-	command_list_num = 0;
+	client.current_command = nullptr;
+	client.command_list_num = 0;
 
 	return ret;
 }
+
+gcc_pure
+static bool
+word_equals(const char *word, size_t length, const char *name)
+{
+	return strncmp(word, name, length) == 0 && name[length] == 0;
+}
+
+gcc_pure
+static bool
+word_in_list(const char *word, size_t length,
+	     const char *const*list, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+		if (word_equals(word, length, list[i]))
+			return true;
+
+	return false;
+}
+
+bool
+command_is_background(gcc_unused const Client &client, const char *line)
+{
+#ifdef ENABLE_DATABASE
+	const Database *db = client.GetDatabase(IgnoreError());
+	if (db != nullptr && !db->GetPlugin().IsThreadSafe())
+		/* this database plugin may only be used by the main
+		   thread */
+		return false;
+#endif
+
+	const size_t length = strcspn(line, " \t");
+	if (word_in_list(line, length, background_commands,
+			 ARRAY_SIZE(background_commands)))
+		return true;
+
+#ifdef ENABLE_SQLITE
+	if (word_equals(line, length, "sticker")) {
+		const char *sub = line + length;
+		sub += strspn(sub, " \t");
+		return word_in_list(sub, strcspn(sub, " \t"),
+				    background_sticker_commands,
+				    ARRAY_SIZE(background_sticker_commands));
+	}
+#endif
+
+	return false;
+}
@@ -21,6 +21,7 @@
 #define MPD_ALL_COMMANDS_HXX
 
 #include "CommandResult.hxx"
+#include "Compiler.h"
 
 class Client;
 
@@ -31,4 +32,13 @@ void command_finish(void);
 CommandResult
 command_process(Client &client, unsigned num, char *line);
 
+/**
+ * May this command line be executed by a worker thread?  This is
+ * only true for commands which do not modify MPD's state and which
+ * only access data that may be used by any thread.
+ */
+gcc_pure
+bool
+command_is_background(const Client &client, const char *line);
+
 #endif
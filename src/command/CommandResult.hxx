@@ -41,6 +41,13 @@ enum class CommandResult {
 	 */
 	IDLE,
 
+	/**
+	 * The command has been handed to a worker thread.  The
+	 * response will be sent when it finishes, and no further
+	 * input shall be processed from this client until then.
+	 */
+	BACKGROUND,
+
 	/**
 	 * There was an error.  The "ACK" response was sent to the
 	 * client.
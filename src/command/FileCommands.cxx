@@ -31,6 +31,7 @@
 #include "tag/TagHandler.hxx"
 #include "tag/ApeTag.hxx"
 #include "tag/TagId3.hxx"
+#include "tag/TagFileBuffer.hxx"
 #include "TagStream.hxx"
 #include "TagFile.hxx"
 #include "storage/StorageInterface.hxx"
@@ -193,8 +194,11 @@ read_file_comments(Client &client, const Path path_fs)
 		return CommandResult::ERROR;
 	}
 
-	tag_ape_scan2(path_fs, &print_comment_handler, &client);
-	tag_id3_scan(path_fs, &print_comment_handler, &client);
+	TagFileBuffer file(path_fs);
+	if (file.IsDefined()) {
+		tag_ape_scan2(file, &print_comment_handler, &client);
+		tag_id3_scan(file, &print_comment_handler, &client);
+	}
 
 	return CommandResult::OK;
 
@@ -29,8 +29,10 @@
 #include "TagPrint.hxx"
 #include "TagStream.hxx"
 #include "tag/TagHandler.hxx"
+#include "tag/TagPool.hxx"
 #include "TimePrint.hxx"
 #include "decoder/DecoderPrint.hxx"
+#include "input/AsyncInputStream.hxx"
 #include "protocol/ArgParser.hxx"
 #include "protocol/Result.hxx"
 #include "ls.hxx"
@@ -51,6 +53,7 @@
 #include "DatabaseCommands.hxx"
 #include "db/Interface.hxx"
 #include "db/update/Service.hxx"
+#include "db/plugins/simple/SimpleDatabasePlugin.hxx"
 #endif
 
 #include <assert.h>
@@ -85,6 +88,24 @@ handle_decoders(Client &client,
 	return CommandResult::OK;
 }
 
+CommandResult
+handle_inputstats(Client &client,
+		  gcc_unused unsigned argc, gcc_unused char *argv[])
+{
+	AsyncInputStream::VisitStats([&client](const AsyncInputStreamStats &stats){
+			client_printf(client,
+				      "uri: %s\n"
+				      "buffer_size: %zu\n"
+				      "buffer_fill: %zu\n"
+				      "underruns: %u\n",
+				      stats.uri.c_str(),
+				      stats.buffer_size, stats.buffer_fill,
+				      stats.underruns);
+		});
+
+	return CommandResult::OK;
+}
+
 CommandResult
 handle_tagtypes(Client &client,
 		gcc_unused unsigned argc, gcc_unused char *argv[])
@@ -449,3 +470,47 @@ handle_idle(Client &client,
 
 	return CommandResult::IDLE;
 }
+
+CommandResult
+handle_idlestats(Client &client,
+		 gcc_unused unsigned argc, gcc_unused char *argv[])
+{
+	const ClientIdleStats &stats = client_idle_get_stats();
+	client_printf(client,
+		      "notifications: %lu\n"
+		      "events: %lu\n"
+		      "formatted: %u\n",
+		      stats.notifications, stats.events, stats.formatted);
+	return CommandResult::OK;
+}
+
+CommandResult
+handle_memorystats(Client &client,
+		   gcc_unused unsigned argc, gcc_unused char *argv[])
+{
+#ifdef ENABLE_DATABASE
+	const Database *db = client.partition.instance.database;
+	if (db != nullptr && db->IsPlugin(simple_db_plugin)) {
+		const auto stats = ((const SimpleDatabase *)db)->GetMemoryStats();
+		client_printf(client,
+			      "db_directories: %u\n"
+			      "db_songs: %u\n"
+			      "db_tag_items: %u\n"
+			      "db_directory_bytes: %lu\n"
+			      "db_song_bytes: %lu\n"
+			      "db_tag_bytes: %lu\n",
+			      stats.directories, stats.songs, stats.tag_items,
+			      (unsigned long)stats.directory_bytes,
+			      (unsigned long)stats.song_bytes,
+			      (unsigned long)stats.tag_bytes);
+	}
+#endif
+
+	const TagPoolStats pool = tag_pool_get_stats();
+	client_printf(client,
+		      "tag_pool_items: %lu\n"
+		      "tag_pool_bytes: %lu\n",
+		      (unsigned long)pool.items,
+		      (unsigned long)pool.bytes);
+	return CommandResult::OK;
+}
@@ -30,6 +30,9 @@ handle_urlhandlers(Client &client, unsigned argc, char *argv[]);
 CommandResult
 handle_decoders(Client &client, unsigned argc, char *argv[]);
 
+CommandResult
+handle_inputstats(Client &client, unsigned argc, char *argv[]);
+
 CommandResult
 handle_tagtypes(Client &client, unsigned argc, char *argv[]);
 
@@ -72,4 +75,10 @@ handle_config(Client &client, unsigned argc, char *argv[]);
 CommandResult
 handle_idle(Client &client, unsigned argc, char *argv[]);
 
+CommandResult
+handle_idlestats(Client &client, unsigned argc, char *argv[]);
+
+CommandResult
+handle_memorystats(Client &client, unsigned argc, char *argv[]);
+
 #endif
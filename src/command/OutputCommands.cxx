@@ -82,3 +82,12 @@ handle_devices(Client &client,
 
 	return CommandResult::OK;
 }
+
+CommandResult
+handle_outputstats(Client &client,
+		   gcc_unused unsigned argc, gcc_unused char *argv[])
+{
+	printAudioOutputStats(client, client.partition.outputs);
+
+	return CommandResult::OK;
+}
@@ -36,4 +36,7 @@ handle_toggleoutput(Client &client, unsigned argc, char *argv[]);
 CommandResult
 handle_devices(Client &client, unsigned argc, char *argv[]);
 
+CommandResult
+handle_outputstats(Client &client, unsigned argc, char *argv[]);
+
 #endif
@@ -27,6 +27,7 @@
 #include "sticker/StickerDatabase.hxx"
 #include "CommandError.hxx"
 #include "protocol/Result.hxx"
+#include "protocol/ArgParser.hxx"
 #include "client/Client.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
@@ -122,12 +123,37 @@ handle_sticker_song(Client &client, unsigned argc, char *argv[])
 		}
 
 		return CommandResult::OK;
-	/* find song dir key */
-	} else if (argc == 5 && strcmp(argv[1], "find") == 0) {
-		/* "sticker find song a/directory name" */
+	/* find song dir key [op value] */
+	} else if ((argc == 5 || argc == 7) && strcmp(argv[1], "find") == 0) {
+		/* "sticker find song a/directory name [op value]" */
 
 		const char *const base_uri = argv[3];
 
+		StickerOperator op = StickerOperator::EXISTS;
+		const char *value = nullptr;
+
+		if (argc == 7) {
+			const char *const op_s = argv[5];
+			value = argv[6];
+
+			if (strcmp(op_s, "=") == 0)
+				op = StickerOperator::EQUALS;
+			else if (strcmp(op_s, "<") == 0)
+				op = StickerOperator::LESS_THAN;
+			else if (strcmp(op_s, ">") == 0)
+				op = StickerOperator::GREATER_THAN;
+			else {
+				command_error(client, ACK_ERROR_ARG,
+					      "bad operator");
+				return CommandResult::ERROR;
+			}
+
+			int i;
+			if (op != StickerOperator::EQUALS &&
+			    !check_int(client, &i, value))
+				return CommandResult::ERROR;
+		}
+
 		bool success;
 		struct sticker_song_find_data data = {
 			client,
@@ -135,6 +161,7 @@ handle_sticker_song(Client &client, unsigned argc, char *argv[])
 		};
 
 		success = sticker_song_find(*db, base_uri, data.name,
+					    op, value,
 					    sticker_song_find_print_cb, &data);
 		if (!success) {
 			command_error(client, ACK_ERROR_SYSTEM,
@@ -29,6 +29,7 @@ enum ConfigOption {
 	CONF_FOLLOW_OUTSIDE_SYMLINKS,
 	CONF_DB_FILE,
 	CONF_STICKER_FILE,
+	CONF_STICKER_WAL,
 	CONF_LOG_FILE,
 	CONF_PID_FILE,
 	CONF_STATE_FILE,
@@ -79,6 +80,11 @@ enum ConfigOption {
 	CONF_AUDIO_FILTER,
 	CONF_DATABASE,
 	CONF_NEIGHBORS,
+	CONF_SEEK_INDEX_FILE,
+	CONF_INPUT_CACHE_DIRECTORY,
+	CONF_INPUT_CACHE_SIZE,
+	CONF_INPUT_CACHE_TTL,
+	CONF_WORKER_THREADS,
 	CONF_MAX
 };
 
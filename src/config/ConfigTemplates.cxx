@@ -29,6 +29,7 @@ const ConfigTemplate config_templates[] = {
 	{ "follow_outside_symlinks", false, false },
 	{ "db_file", false, false },
 	{ "sticker_file", false, false },
+	{ "sticker_wal", false, false },
 	{ "log_file", false, false },
 	{ "pid_file", false, false },
 	{ "state_file", false, false },
@@ -79,6 +80,11 @@ const ConfigTemplate config_templates[] = {
 	{ "filter", true, true },
 	{ "database", false, true },
 	{ "neighbors", true, true },
+	{ "seek_index_file", false, false },
+	{ "input_cache_directory", false, false },
+	{ "input_cache_size", false, false },
+	{ "input_cache_ttl", false, false },
+	{ "worker_threads", false, false },
 };
 
 static constexpr unsigned n_config_templates =
@@ -39,6 +39,13 @@ struct DatabasePlugin {
 	 */
 	static constexpr unsigned FLAG_REQUIRE_STORAGE = 0x1;
 
+	/**
+	 * The read-only methods (GetSong(), Visit(),
+	 * VisitUniqueTags(), GetStats()) may be called from any
+	 * thread, concurrently.
+	 */
+	static constexpr unsigned FLAG_THREAD_SAFE = 0x2;
+
 	const char *name;
 
 	unsigned flags;
@@ -53,6 +60,10 @@ struct DatabasePlugin {
 	constexpr bool RequireStorage() const {
 		return flags & FLAG_REQUIRE_STORAGE;
 	}
+
+	constexpr bool IsThreadSafe() const {
+		return flags & FLAG_THREAD_SAFE;
+	}
 };
 
 #endif
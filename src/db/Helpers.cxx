@@ -23,8 +23,11 @@
 #include "LightSong.hxx"
 #include "tag/Tag.hxx"
 
+#include <map>
 #include <set>
+#include <string>
 
+#include <assert.h>
 #include <string.h>
 
 struct StringLess {
@@ -96,3 +99,58 @@ GetStats(const Database &db, const DatabaseSelection &selection,
 	stats.album_count = albums.size();
 	return true;
 }
+
+typedef std::map<std::string, SearchStats> TagCountMap;
+
+static bool
+CollectGroupCounts(TagCountMap &map, TagType group, const Tag &tag)
+{
+	bool found = false;
+	for (const auto &item : tag) {
+		if (item.type == group) {
+			auto r = map.insert(std::make_pair(item.value,
+							   SearchStats()));
+			SearchStats &s = r.first->second;
+			++s.n_songs;
+			if (!tag.duration.IsNegative())
+				s.total_duration += tag.duration;
+
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+static bool
+GroupCountVisitor(TagCountMap &map, TagType group, const LightSong &song)
+{
+	assert(song.tag != nullptr);
+
+	const Tag &tag = *song.tag;
+	if (!CollectGroupCounts(map, group, tag) && group == TAG_ALBUM_ARTIST)
+		/* fall back to "Artist" if no "AlbumArtist" was found */
+		CollectGroupCounts(map, TAG_ARTIST, tag);
+
+	return true;
+}
+
+bool
+VisitTagCounts(const Database &db, const DatabaseSelection &selection,
+	       TagType tag_type, VisitTagCount visit_tag_count,
+	       Error &error)
+{
+	TagCountMap map;
+
+	using namespace std::placeholders;
+	const auto f = std::bind(GroupCountVisitor, std::ref(map),
+				 tag_type, _1);
+	if (!db.Visit(selection, f, error))
+		return false;
+
+	for (const auto &i : map)
+		if (!visit_tag_count(i.first.c_str(), i.second, error))
+			return false;
+
+	return true;
+}
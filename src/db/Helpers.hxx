@@ -20,6 +20,9 @@
 #ifndef MPD_MEMORY_DATABASE_PLUGIN_HXX
 #define MPD_MEMORY_DATABASE_PLUGIN_HXX
 
+#include "Visitor.hxx"
+#include "tag/TagType.h"
+
 class Error;
 class Database;
 struct DatabaseSelection;
@@ -29,4 +32,13 @@ bool
 GetStats(const Database &db, const DatabaseSelection &selection,
 	 DatabaseStats &stats, Error &error);
 
+/**
+ * Implementation of Database::VisitTagCounts() which visits all
+ * selected songs.
+ */
+bool
+VisitTagCounts(const Database &db, const DatabaseSelection &selection,
+	       TagType tag_type, VisitTagCount visit_tag_count,
+	       Error &error);
+
 #endif
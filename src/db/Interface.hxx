@@ -111,6 +111,16 @@ public:
 				     VisitTag visit_tag,
 				     Error &error) const = 0;
 
+	/**
+	 * Visit all values of the specified tag (sorted), together
+	 * with the number of songs and their total duration.  Songs
+	 * without "AlbumArtist" are counted for their "Artist".
+	 */
+	virtual bool VisitTagCounts(const DatabaseSelection &selection,
+				    TagType tag_type,
+				    VisitTagCount visit_tag_count,
+				    Error &error) const = 0;
+
 	virtual bool GetStats(const DatabaseSelection &selection,
 			      DatabaseStats &stats,
 			      Error &error) const = 0;
@@ -50,4 +50,16 @@ struct DatabaseStats {
 	}
 };
 
+/**
+ * The number of songs and their total duration, e.g. for one value
+ * of a "count group" response.
+ */
+struct SearchStats {
+	unsigned n_songs;
+	std::chrono::duration<std::uint64_t, SongTime::period> total_duration;
+
+	constexpr SearchStats()
+		:n_songs(0), total_duration(0) {}
+};
+
 #endif
@@ -26,6 +26,7 @@ struct LightDirectory;
 struct LightSong;
 struct PlaylistInfo;
 struct Tag;
+struct SearchStats;
 class Error;
 
 typedef std::function<bool(const LightDirectory &, Error &)> VisitDirectory;
@@ -35,4 +36,7 @@ typedef std::function<bool(const PlaylistInfo &, const LightDirectory &,
 
 typedef std::function<bool(const Tag &, Error &)> VisitTag;
 
+typedef std::function<bool(const char *, const SearchStats &,
+			   Error &)> VisitTagCount;
+
 #endif
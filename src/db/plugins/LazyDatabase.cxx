@@ -94,6 +94,17 @@ LazyDatabase::VisitUniqueTags(const DatabaseSelection &selection,
 				    error);
 }
 
+bool
+LazyDatabase::VisitTagCounts(const DatabaseSelection &selection,
+			     TagType tag_type,
+			     VisitTagCount visit_tag_count,
+			     Error &error) const
+{
+	return EnsureOpen(error) &&
+		db->VisitTagCounts(selection, tag_type, visit_tag_count,
+				   error);
+}
+
 bool
 LazyDatabase::GetStats(const DatabaseSelection &selection,
 		       DatabaseStats &stats, Error &error) const
@@ -56,6 +56,11 @@ public:
 				     VisitTag visit_tag,
 				     Error &error) const override;
 
+	virtual bool VisitTagCounts(const DatabaseSelection &selection,
+				    TagType tag_type,
+				    VisitTagCount visit_tag_count,
+				    Error &error) const override;
+
 	virtual bool GetStats(const DatabaseSelection &selection,
 			      DatabaseStats &stats,
 			      Error &error) const override;
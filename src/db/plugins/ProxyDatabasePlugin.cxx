@@ -28,6 +28,7 @@
 #include "db/LightDirectory.hxx"
 #include "db/LightSong.hxx"
 #include "db/Stats.hxx"
+#include "db/Helpers.hxx"
 #include "SongFilter.hxx"
 #include "Compiler.h"
 #include "config/ConfigData.hxx"
@@ -46,6 +47,12 @@
 #include <cassert>
 #include <string>
 #include <list>
+#include <map>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#include <string.h>
 
 class ProxySong : public LightSong {
 	Tag tag2;
@@ -66,6 +73,56 @@ public:
 	}
 };
 
+class ProxyEntity {
+	struct mpd_entity *entity;
+
+public:
+	explicit ProxyEntity(struct mpd_entity *_entity)
+		:entity(_entity) {}
+
+	ProxyEntity(const ProxyEntity &other) = delete;
+
+	ProxyEntity(ProxyEntity &&other)
+		:entity(other.entity) {
+		other.entity = nullptr;
+	}
+
+	~ProxyEntity() {
+		if (entity != nullptr)
+			mpd_entity_free(entity);
+	}
+
+	ProxyEntity &operator=(const ProxyEntity &other) = delete;
+
+	operator const struct mpd_entity *() const {
+		return entity;
+	}
+};
+
+/**
+ * A response received from the other MPD.  It may be kept in the
+ * #ProxyDatabase cache until the other MPD reports a database
+ * modification.
+ */
+struct ProxyResponse {
+	/**
+	 * The entities received from "lsinfo".
+	 */
+	std::list<ProxyEntity> entities;
+
+	/**
+	 * The songs received from "search" or "find".
+	 */
+	std::list<AllocatedProxySong> songs;
+
+	/**
+	 * The tag values received from "list".
+	 */
+	std::vector<std::string> values;
+};
+
+typedef std::shared_ptr<const ProxyResponse> ProxyResponsePtr;
+
 class ProxyDatabase final : public Database, SocketMonitor, IdleMonitor {
 	DatabaseListener &listener;
 
@@ -89,11 +146,37 @@ class ProxyDatabase final : public Database, SocketMonitor, IdleMonitor {
 	 */
 	bool is_idle;
 
+	/**
+	 * The maximum number of objects (entities, songs and tag
+	 * values) in the #cache.  0 disables the cache.
+	 */
+	size_t cache_limit;
+
+	/**
+	 * Responses received from the other MPD.  They are discarded
+	 * as soon as the other MPD reports a database modification,
+	 * and when the connection is lost.
+	 */
+	mutable std::map<std::string, ProxyResponsePtr> cache;
+
+	/**
+	 * The number of objects in #cache.
+	 */
+	mutable size_t cache_size;
+
+	/**
+	 * Is #cached_stats valid?
+	 */
+	mutable bool stats_valid;
+
+	mutable DatabaseStats cached_stats;
+
 public:
 	ProxyDatabase(EventLoop &_loop, DatabaseListener &_listener)
 		:Database(proxy_db_plugin),
 		 SocketMonitor(_loop), IdleMonitor(_loop),
-		 listener(_listener) {}
+		 listener(_listener),
+		 cache_size(0), stats_valid(false) {}
 
 	static Database *Create(EventLoop &loop, DatabaseListener &listener,
 				const config_param &param,
@@ -116,6 +199,11 @@ public:
 				     VisitTag visit_tag,
 				     Error &error) const override;
 
+	virtual bool VisitTagCounts(const DatabaseSelection &selection,
+				    TagType tag_type,
+				    VisitTagCount visit_tag_count,
+				    Error &error) const override;
+
 	virtual bool GetStats(const DatabaseSelection &selection,
 			      DatabaseStats &stats,
 			      Error &error) const override;
@@ -136,6 +224,39 @@ private:
 
 	void Disconnect();
 
+	gcc_pure
+	ProxyResponsePtr LookupCache(const std::string &key) const;
+
+	void StoreCache(std::string &&key,
+			const ProxyResponsePtr &response) const;
+
+	void FlushCache() const;
+
+	/**
+	 * Obtain the "lsinfo" responses for the given directories.
+	 * Those which are not in the cache are requested with one
+	 * command list.
+	 *
+	 * @param n the number of directories; must not be larger
+	 * than #PROXY_PIPELINE_DEPTH
+	 * @param result an array of #n elements which receives the
+	 * responses
+	 */
+	bool ListDirectories(const char *const*uris, size_t n,
+			     ProxyResponsePtr *result,
+			     Error &error) const;
+
+	bool VisitEntities(const std::list<ProxyEntity> &entities,
+			   bool recursive, const SongFilter *filter,
+			   VisitDirectory visit_directory,
+			   VisitSong visit_song,
+			   VisitPlaylist visit_playlist,
+			   Error &error) const;
+
+	bool SearchSongs(const DatabaseSelection &selection,
+			 VisitSong visit_song,
+			 Error &error) const;
+
 	/* virtual methods from SocketMonitor */
 	virtual bool OnSocketReady(unsigned flags) override;
 
@@ -145,6 +266,14 @@ private:
 
 static constexpr Domain libmpdclient_domain("libmpdclient");
 
+/**
+ * The maximum number of "lsinfo" commands sent in one command list.
+ * The other MPD buffers the response to the whole command list, and
+ * drops the connection when it exceeds "max_output_buffer_size", so
+ * this must not be too large.
+ */
+static constexpr size_t PROXY_PIPELINE_DEPTH = 8;
+
 static constexpr struct {
 	TagType d;
 	enum mpd_tag_type s;
@@ -332,6 +461,7 @@ ProxyDatabase::Configure(const config_param &param, gcc_unused Error &error)
 {
 	host = param.GetBlockValue("host", "");
 	port = param.GetBlockValue("port", 0u);
+	cache_limit = param.GetBlockValue("cache_size", 100000u);
 
 	return true;
 }
@@ -375,6 +505,10 @@ ProxyDatabase::Connect(Error &error)
 	idle_received = unsigned(-1);
 	is_idle = false;
 
+	/* we may have missed database modifications while we were
+	   disconnected */
+	FlushCache();
+
 	SocketMonitor::Open(mpd_async_get_fd(mpd_connection_get_async(connection)));
 	IdleMonitor::Schedule();
 
@@ -398,6 +532,9 @@ ProxyDatabase::CheckConnection(Error &error)
 			return false;
 		}
 
+		if (idle & MPD_IDLE_DATABASE)
+			FlushCache();
+
 		idle_received |= idle;
 		is_idle = false;
 		IdleMonitor::Schedule();
@@ -424,6 +561,43 @@ ProxyDatabase::Disconnect()
 
 	mpd_connection_free(connection);
 	connection = nullptr;
+
+	FlushCache();
+}
+
+ProxyResponsePtr
+ProxyDatabase::LookupCache(const std::string &key) const
+{
+	auto i = cache.find(key);
+	return i != cache.end()
+		? i->second
+		: nullptr;
+}
+
+void
+ProxyDatabase::StoreCache(std::string &&key,
+			  const ProxyResponsePtr &response) const
+{
+	const size_t size = 1 + response->entities.size() +
+		response->songs.size() + response->values.size();
+	if (size > cache_limit)
+		return;
+
+	if (cache_size + size > cache_limit)
+		/* the cache is full; start over instead of tracking
+		   which entry was used least recently */
+		FlushCache();
+
+	cache.insert(std::make_pair(std::move(key), response));
+	cache_size += size;
+}
+
+void
+ProxyDatabase::FlushCache() const
+{
+	cache.clear();
+	cache_size = 0;
+	stats_valid = false;
 }
 
 bool
@@ -447,6 +621,9 @@ ProxyDatabase::OnSocketReady(gcc_unused unsigned flags)
 		}
 	}
 
+	if (idle & MPD_IDLE_DATABASE)
+		FlushCache();
+
 	/* let OnIdle() handle this */
 	idle_received |= idle;
 	is_idle = false;
@@ -480,6 +657,7 @@ ProxyDatabase::OnIdle()
 		SocketMonitor::Steal();
 		mpd_connection_free(connection);
 		connection = nullptr;
+		FlushCache();
 		return;
 	}
 
@@ -487,9 +665,66 @@ ProxyDatabase::OnIdle()
 	SocketMonitor::ScheduleRead();
 }
 
+/**
+ * Build the #ProxyDatabase cache key for the "lsinfo" response of
+ * the given directory.
+ */
+static std::string
+MakeListKey(const char *uri)
+{
+	std::string key("L");
+	key += uri;
+	return key;
+}
+
+/**
+ * Build the #ProxyDatabase cache key for a command which uses
+ * SendConstraints().
+ *
+ * @param command a character identifying the command
+ * @param arg a command specific parameter
+ */
+static std::string
+MakeConstraintsKey(char command, unsigned arg,
+		   const DatabaseSelection &selection)
+{
+	std::string key(1, command);
+	key += std::to_string(arg);
+	key.push_back('\n');
+	key += selection.uri;
+
+	if (selection.filter != nullptr) {
+		for (const auto &i : selection.filter->GetItems()) {
+			key.push_back('\n');
+			key += std::to_string(i.GetTag());
+			key.push_back(i.GetFoldCase() ? '~' : '=');
+			key += i.GetValue();
+		}
+	}
+
+	return key;
+}
+
 const LightSong *
 ProxyDatabase::GetSong(const char *uri, Error &error) const
 {
+	/* try the cached listing of the parent directory first */
+	const char *slash = strrchr(uri, '/');
+	const std::string parent = slash != nullptr
+		? std::string(uri, slash)
+		: std::string();
+	const auto listing = LookupCache(MakeListKey(parent.c_str()));
+	if (listing != nullptr) {
+		for (const auto &entity : listing->entities) {
+			if (mpd_entity_get_type(entity) != MPD_ENTITY_TYPE_SONG)
+				continue;
+
+			const auto *song = mpd_entity_get_song(entity);
+			if (strcmp(mpd_song_get_uri(song), uri) == 0)
+				return new AllocatedProxySong(mpd_song_dup(song));
+		}
+	}
+
 	// TODO: eliminate the const_cast
 	if (!const_cast<ProxyDatabase *>(this)->EnsureConnected(error))
 		return nullptr;
@@ -526,18 +761,12 @@ ProxyDatabase::ReturnSong(const LightSong *_song) const
 }
 
 static bool
-Visit(struct mpd_connection *connection, const char *uri,
-      bool recursive, const SongFilter *filter,
-      VisitDirectory visit_directory, VisitSong visit_song,
-      VisitPlaylist visit_playlist, Error &error);
-
-static bool
-Visit(struct mpd_connection *connection,
-      bool recursive, const SongFilter *filter,
-      const struct mpd_directory *directory,
-      VisitDirectory visit_directory, VisitSong visit_song,
-      VisitPlaylist visit_playlist, Error &error)
+Visit(const struct mpd_directory *directory,
+      VisitDirectory visit_directory, Error &error)
 {
+	if (!visit_directory)
+		return true;
+
 	const char *path = mpd_directory_get_path(directory);
 #if LIBMPDCLIENT_CHECK_VERSION(2,9,0)
 	time_t mtime = mpd_directory_get_last_modified(directory);
@@ -545,16 +774,7 @@ Visit(struct mpd_connection *connection,
 	time_t mtime = 0;
 #endif
 
-	if (visit_directory &&
-	    !visit_directory(LightDirectory(path, mtime), error))
-		return false;
-
-	if (recursive &&
-	    !Visit(connection, path, recursive, filter,
-		   visit_directory, visit_song, visit_playlist, error))
-		return false;
-
-	return true;
+	return visit_directory(LightDirectory(path, mtime), error);
 }
 
 gcc_pure
@@ -589,56 +809,106 @@ Visit(const struct mpd_playlist *playlist,
 	return visit_playlist(p, LightDirectory::Root(), error);
 }
 
-class ProxyEntity {
+/**
+ * Receive the entities of one "lsinfo" response.  Does not finish
+ * the response, because it may be part of a command list.
+ */
+static void
+ReceiveEntities(struct mpd_connection *connection,
+		std::list<ProxyEntity> &entities)
+{
 	struct mpd_entity *entity;
+	while ((entity = mpd_recv_entity(connection)) != nullptr)
+		entities.push_back(ProxyEntity(entity));
+}
 
-public:
-	explicit ProxyEntity(struct mpd_entity *_entity)
-		:entity(_entity) {}
+bool
+ProxyDatabase::ListDirectories(const char *const*uris, size_t n,
+			       ProxyResponsePtr *result,
+			       Error &error) const
+{
+	assert(n > 0);
+	assert(n <= PROXY_PIPELINE_DEPTH);
+
+	size_t missing[PROXY_PIPELINE_DEPTH], n_missing = 0;
+	for (size_t i = 0; i < n; ++i) {
+		result[i] = LookupCache(MakeListKey(uris[i]));
+		if (result[i] == nullptr)
+			missing[n_missing++] = i;
+	}
 
-	ProxyEntity(const ProxyEntity &other) = delete;
+	if (n_missing == 0)
+		return true;
 
-	ProxyEntity(ProxyEntity &&other)
-		:entity(other.entity) {
-		other.entity = nullptr;
-	}
+	// TODO: eliminate the const_cast
+	if (!const_cast<ProxyDatabase *>(this)->EnsureConnected(error))
+		return false;
 
-	~ProxyEntity() {
-		if (entity != nullptr)
-			mpd_entity_free(entity);
-	}
+	/* send all "lsinfo" commands at once, and receive the
+	   responses in one round trip */
 
-	ProxyEntity &operator=(const ProxyEntity &other) = delete;
+	if (!mpd_command_list_begin(connection, true))
+		return CheckError(connection, error);
 
-	operator const struct mpd_entity *() const {
-		return entity;
-	}
-};
+	for (size_t j = 0; j < n_missing; ++j)
+		if (!mpd_send_list_meta(connection, uris[missing[j]]))
+			return CheckError(connection, error);
 
-static std::list<ProxyEntity>
-ReceiveEntities(struct mpd_connection *connection)
-{
-	std::list<ProxyEntity> entities;
-	struct mpd_entity *entity;
-	while ((entity = mpd_recv_entity(connection)) != nullptr)
-		entities.push_back(ProxyEntity(entity));
+	if (!mpd_command_list_end(connection))
+		return CheckError(connection, error);
+
+	for (size_t j = 0; j < n_missing; ++j) {
+		if (j > 0 && !mpd_response_next(connection))
+			break;
+
+		auto response = std::make_shared<ProxyResponse>();
+		ReceiveEntities(connection, response->entities);
+		if (mpd_connection_get_error(connection) != MPD_ERROR_SUCCESS)
+			break;
+
+		const size_t i = missing[j];
+		result[i] = response;
+		StoreCache(MakeListKey(uris[i]), result[i]);
+	}
 
 	mpd_response_finish(connection);
-	return entities;
+	if (!CheckError(connection, error))
+		return false;
+
+	for (size_t j = 0; j < n_missing; ++j) {
+		if (result[missing[j]] == nullptr) {
+			error.Set(libmpdclient_domain,
+				  "Incomplete command list response");
+			return false;
+		}
+	}
+
+	return true;
 }
 
-static bool
-Visit(struct mpd_connection *connection, const char *uri,
-      bool recursive, const SongFilter *filter,
-      VisitDirectory visit_directory, VisitSong visit_song,
-      VisitPlaylist visit_playlist, Error &error)
+bool
+ProxyDatabase::VisitEntities(const std::list<ProxyEntity> &entities,
+			     bool recursive, const SongFilter *filter,
+			     VisitDirectory visit_directory,
+			     VisitSong visit_song,
+			     VisitPlaylist visit_playlist,
+			     Error &error) const
 {
-	if (!mpd_send_list_meta(connection, uri))
-		return CheckError(connection, error);
+	/* collect the sub directories, to request their listings in
+	   batches */
+	std::vector<const char *> directories;
+	if (recursive) {
+		for (const auto &entity : entities) {
+			if (mpd_entity_get_type(entity) != MPD_ENTITY_TYPE_DIRECTORY)
+				continue;
+
+			const auto *directory = mpd_entity_get_directory(entity);
+			directories.push_back(mpd_directory_get_path(directory));
+		}
+	}
 
-	std::list<ProxyEntity> entities(ReceiveEntities(connection));
-	if (!CheckError(connection, error))
-		return false;
+	ProxyResponsePtr children[PROXY_PIPELINE_DEPTH];
+	size_t n_directories = 0;
 
 	for (const auto &entity : entities) {
 		switch (mpd_entity_get_type(entity)) {
@@ -646,36 +916,53 @@ Visit(struct mpd_connection *connection, const char *uri,
 			break;
 
 		case MPD_ENTITY_TYPE_DIRECTORY:
-			if (!Visit(connection, recursive, filter,
-				   mpd_entity_get_directory(entity),
-				   visit_directory, visit_song, visit_playlist,
-				   error))
+			if (!::Visit(mpd_entity_get_directory(entity),
+				     visit_directory, error))
 				return false;
+
+			if (recursive) {
+				const size_t i = n_directories++;
+				const size_t slot = i % PROXY_PIPELINE_DEPTH;
+				if (slot == 0 &&
+				    !ListDirectories(&directories[i],
+						     std::min(directories.size() - i,
+							      PROXY_PIPELINE_DEPTH),
+						     children, error))
+					return false;
+
+				if (!VisitEntities(children[slot]->entities,
+						   recursive, filter,
+						   visit_directory, visit_song,
+						   visit_playlist, error))
+					return false;
+
+				children[slot].reset();
+			}
+
 			break;
 
 		case MPD_ENTITY_TYPE_SONG:
-			if (!Visit(filter,
-				   mpd_entity_get_song(entity), visit_song,
-				   error))
+			if (!::Visit(filter,
+				     mpd_entity_get_song(entity), visit_song,
+				     error))
 				return false;
 			break;
 
 		case MPD_ENTITY_TYPE_PLAYLIST:
-			if (!Visit(mpd_entity_get_playlist(entity),
-				   visit_playlist, error))
+			if (!::Visit(mpd_entity_get_playlist(entity),
+				     visit_playlist, error))
 				return false;
 			break;
 		}
 	}
 
-	return CheckError(connection, error);
+	return true;
 }
 
-static bool
-SearchSongs(struct mpd_connection *connection,
-	    const DatabaseSelection &selection,
-	    VisitSong visit_song,
-	    Error &error)
+bool
+ProxyDatabase::SearchSongs(const DatabaseSelection &selection,
+			   VisitSong visit_song,
+			   Error &error) const
 {
 	assert(selection.recursive);
 	assert(visit_song);
@@ -683,22 +970,38 @@ SearchSongs(struct mpd_connection *connection,
 	const bool exact = selection.filter == nullptr ||
 		!selection.filter->HasFoldCase();
 
-	if (!mpd_search_db_songs(connection, exact) ||
-	    !SendConstraints(connection, selection) ||
-	    !mpd_search_commit(connection))
-		return CheckError(connection, error);
+	std::string key = MakeConstraintsKey('S', exact, selection);
+	ProxyResponsePtr response = LookupCache(key);
+	if (response == nullptr) {
+		// TODO: eliminate the const_cast
+		if (!const_cast<ProxyDatabase *>(this)->EnsureConnected(error))
+			return false;
+
+		if (!mpd_search_db_songs(connection, exact) ||
+		    !SendConstraints(connection, selection) ||
+		    !mpd_search_commit(connection))
+			return CheckError(connection, error);
 
-	bool result = true;
-	struct mpd_song *song;
-	while (result && (song = mpd_recv_song(connection)) != nullptr) {
-		AllocatedProxySong song2(song);
+		auto songs = std::make_shared<ProxyResponse>();
+		struct mpd_song *song;
+		while ((song = mpd_recv_song(connection)) != nullptr)
+			songs->songs.emplace_back(song);
 
-		result = !Match(selection.filter, song2) ||
-			visit_song(song2, error);
+		mpd_response_finish(connection);
+		if (!CheckError(connection, error))
+			return false;
+
+		response = songs;
+		StoreCache(std::move(key), response);
 	}
 
-	mpd_response_finish(connection);
-	return result && CheckError(connection, error);
+	/* the filter is applied again, because not all of its items
+	   can be passed to the other MPD */
+	for (const auto &song : response->songs)
+		if (Match(selection.filter, song) && !visit_song(song, error))
+			return false;
+
+	return true;
 }
 
 /**
@@ -725,9 +1028,13 @@ ProxyDatabase::Visit(const DatabaseSelection &selection,
 		     VisitPlaylist visit_playlist,
 		     Error &error) const
 {
+	/* the server version is needed to choose the code path, but
+	   if we're connected, don't wake it up from "idle" yet; the
+	   response may be in the cache */
 	// TODO: eliminate the const_cast
-	if (!const_cast<ProxyDatabase *>(this)->EnsureConnected(error))
-		return nullptr;
+	if (connection == nullptr &&
+	    !const_cast<ProxyDatabase *>(this)->EnsureConnected(error))
+		return false;
 
 	if (!visit_directory && !visit_playlist && selection.recursive &&
 	    (ServerSupportsSearchBase(connection)
@@ -735,13 +1042,17 @@ ProxyDatabase::Visit(const DatabaseSelection &selection,
 	     : selection.HasOtherThanBase()))
 		/* this optimized code path can only be used under
 		   certain conditions */
-		return ::SearchSongs(connection, selection, visit_song, error);
-
-	/* fall back to recursive walk (slow!) */
-	return ::Visit(connection, selection.uri.c_str(),
-		       selection.recursive, selection.filter,
-		       visit_directory, visit_song, visit_playlist,
-		       error);
+		return SearchSongs(selection, visit_song, error);
+
+	/* fall back to recursive walk (slow, but the listings are
+	   requested in batches and cached) */
+	const char *uri = selection.uri.c_str();
+	ProxyResponsePtr listing;
+	return ListDirectories(&uri, 1, &listing, error) &&
+		VisitEntities(listing->entities,
+			      selection.recursive, selection.filter,
+			      visit_directory, visit_song, visit_playlist,
+			      error);
 }
 
 bool
@@ -751,34 +1062,50 @@ ProxyDatabase::VisitUniqueTags(const DatabaseSelection &selection,
 			       VisitTag visit_tag,
 			       Error &error) const
 {
-	// TODO: eliminate the const_cast
-	if (!const_cast<ProxyDatabase *>(this)->EnsureConnected(error))
-		return nullptr;
-
 	enum mpd_tag_type tag_type2 = Convert(tag_type);
 	if (tag_type2 == MPD_TAG_COUNT) {
 		error.Set(libmpdclient_domain, "Unsupported tag");
 		return false;
 	}
 
-	if (!mpd_search_db_tags(connection, tag_type2))
-		return CheckError(connection, error);
+	std::string key = MakeConstraintsKey('T', tag_type2, selection);
+	ProxyResponsePtr response = LookupCache(key);
+	if (response == nullptr) {
+		// TODO: eliminate the const_cast
+		if (!const_cast<ProxyDatabase *>(this)->EnsureConnected(error))
+			return false;
 
-	if (!SendConstraints(connection, selection))
-		return CheckError(connection, error);
+		if (!mpd_search_db_tags(connection, tag_type2))
+			return CheckError(connection, error);
 
-	// TODO: use group_mask
+		if (!SendConstraints(connection, selection))
+			return CheckError(connection, error);
 
-	if (!mpd_search_commit(connection))
-		return CheckError(connection, error);
+		// TODO: use group_mask
+
+		if (!mpd_search_commit(connection))
+			return CheckError(connection, error);
+
+		auto values = std::make_shared<ProxyResponse>();
+
+		struct mpd_pair *pair;
+		while ((pair = mpd_recv_pair_tag(connection,
+						 tag_type2)) != nullptr) {
+			values->values.emplace_back(pair->value);
+			mpd_return_pair(connection, pair);
+		}
+
+		mpd_response_finish(connection);
+		if (!CheckError(connection, error))
+			return false;
 
-	bool result = true;
+		response = values;
+		StoreCache(std::move(key), response);
+	}
 
-	struct mpd_pair *pair;
-	while (result &&
-	       (pair = mpd_recv_pair_tag(connection, tag_type2)) != nullptr) {
+	for (const auto &value : response->values) {
 		TagBuilder tag;
-		tag.AddItem(tag_type, pair->value);
+		tag.AddItem(tag_type, value.c_str());
 
 		if (tag.IsEmpty())
 			/* if no tag item has been added, then the
@@ -788,13 +1115,21 @@ ProxyDatabase::VisitUniqueTags(const DatabaseSelection &selection,
 			   given tag type to be present */
 			tag.AddEmptyItem(tag_type);
 
-		result = visit_tag(tag.Commit(), error);
-		mpd_return_pair(connection, pair);
+		if (!visit_tag(tag.Commit(), error))
+			return false;
 	}
 
-	return mpd_response_finish(connection) &&
-		CheckError(connection, error) &&
-		result;
+	return true;
+}
+
+bool
+ProxyDatabase::VisitTagCounts(const DatabaseSelection &selection,
+			      TagType tag_type,
+			      VisitTagCount visit_tag_count,
+			      Error &error) const
+{
+	return ::VisitTagCounts(*this, selection, tag_type, visit_tag_count,
+				error);
 }
 
 bool
@@ -804,9 +1139,14 @@ ProxyDatabase::GetStats(const DatabaseSelection &selection,
 	// TODO: match
 	(void)selection;
 
+	if (stats_valid) {
+		stats = cached_stats;
+		return true;
+	}
+
 	// TODO: eliminate the const_cast
 	if (!const_cast<ProxyDatabase *>(this)->EnsureConnected(error))
-		return nullptr;
+		return false;
 
 	struct mpd_stats *stats2 =
 		mpd_run_stats(connection);
@@ -821,6 +1161,11 @@ ProxyDatabase::GetStats(const DatabaseSelection &selection,
 	stats.album_count = mpd_stats_get_number_of_albums(stats2);
 	mpd_stats_free(stats2);
 
+	if (cache_limit > 0) {
+		cached_stats = stats;
+		stats_valid = true;
+	}
+
 	return true;
 }
 
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "Counters.hxx"
+#include "tag/Tag.hxx"
+#include "tag/TagItem.hxx"
+#include "tag/TagBuilder.hxx"
+
+#include <assert.h>
+
+/**
+ * The tag types which are always counted, because "stats" needs
+ * them.
+ */
+static constexpr uint32_t COUNTERS_DEFAULT_MASK =
+	(1u << TAG_ARTIST) | (1u << TAG_ALBUM);
+
+void
+DatabaseCounters::ValueCounter::Add(TagType type, TagPoolId id,
+				    SignedSongTime duration)
+{
+	const TagItem &item = tag_pool_lookup(id);
+	auto i = map.find(item.value);
+	if (i == map.end()) {
+		/* the key points into the pool item; hold a
+		   reference on it */
+		const TagPoolId own_id = item.type == type
+			? tag_pool_dup_item(id)
+			: tag_pool_get_item(type, item.value,
+					    strlen(item.value));
+
+		const char *key = tag_pool_lookup(own_id).value;
+		i = map.insert(std::make_pair(key,
+					      Item{own_id, SearchStats()})).first;
+	}
+
+	SearchStats &stats = i->second.stats;
+	++stats.n_songs;
+	if (!duration.IsNegative())
+		stats.total_duration += duration;
+}
+
+void
+DatabaseCounters::ValueCounter::Remove(TagPoolId id,
+				       SignedSongTime duration)
+{
+	auto i = map.find(tag_pool_lookup(id).value);
+	assert(i != map.end());
+
+	SearchStats &stats = i->second.stats;
+	assert(stats.n_songs > 0);
+
+	if (--stats.n_songs == 0) {
+		const TagPoolId own_id = i->second.id;
+		map.erase(i);
+		tag_pool_put_item(own_id);
+	} else if (!duration.IsNegative())
+		stats.total_duration -= duration;
+}
+
+void
+DatabaseCounters::ValueCounter::Clear()
+{
+	for (const auto &i : map)
+		tag_pool_put_item(i.second.id);
+
+	map.clear();
+	missing = 0;
+}
+
+bool
+DatabaseCounters::ValueCounter::VisitValues(TagType type,
+					    VisitTag visit_tag,
+					    Error &error) const
+{
+	if (missing > 0 && (map.empty() || *map.begin()->first != 0)) {
+		/* like TagSet::InsertUnique(), report an empty
+		   value for songs which don't have this tag */
+		TagBuilder builder;
+		builder.AddEmptyItem(type);
+		if (!visit_tag(builder.Commit(), error))
+			return false;
+	}
+
+	/* pass the ids owned by the map in a reusable one-item
+	   #Tag instead of allocating a new one for each value */
+	Tag tag;
+	tag.items = new TagPoolId[1];
+	tag.num_items = 1;
+
+	bool result = true;
+	for (const auto &i : map) {
+		tag.items[0] = i.second.id;
+		if (!visit_tag(tag, error)) {
+			result = false;
+			break;
+		}
+	}
+
+	/* the id is not owned by the #Tag */
+	tag.num_items = 0;
+	return result;
+}
+
+bool
+DatabaseCounters::ValueCounter::VisitCounts(VisitTagCount visit_tag_count,
+					    Error &error) const
+{
+	for (const auto &i : map)
+		if (!visit_tag_count(i.first, i.second.stats, error))
+			return false;
+
+	return true;
+}
+
+void
+DatabaseCounters::Clear()
+{
+	song_count = 0;
+	total_duration = total_duration.zero();
+	enabled_mask = COUNTERS_DEFAULT_MASK;
+
+	for (auto &i : values)
+		i.Clear();
+}
+
+/**
+ * Invoke the function for each item of the specified type.  Falls
+ * back to "Artist" if there is no "AlbumArtist", like "list" and
+ * "count group" do.
+ *
+ * @return false if no item was found
+ */
+template<typename F>
+static bool
+ForEachValue(const Tag &tag, TagType type, F &&f)
+{
+	bool found = false;
+	for (unsigned i = 0; i < tag.num_items; ++i) {
+		if (tag_pool_lookup(tag.items[i]).type == type) {
+			f(tag.items[i]);
+			found = true;
+		}
+	}
+
+	if (!found && type == TAG_ALBUM_ARTIST)
+		found = ForEachValue(tag, TAG_ARTIST, f);
+
+	return found;
+}
+
+void
+DatabaseCounters::AddValues(TagType type, const Tag &tag)
+{
+	ValueCounter &counter = values[type];
+	if (!ForEachValue(tag, type, [&counter, type, &tag](TagPoolId id){
+				counter.Add(type, id, tag.duration);
+			}))
+		counter.AddMissing();
+}
+
+void
+DatabaseCounters::RemoveValues(TagType type, const Tag &tag)
+{
+	ValueCounter &counter = values[type];
+	if (!ForEachValue(tag, type, [&counter, &tag](TagPoolId id){
+				counter.Remove(id, tag.duration);
+			}))
+		counter.RemoveMissing();
+}
+
+void
+DatabaseCounters::Add(const Tag &tag)
+{
+	++song_count;
+
+	if (!tag.duration.IsNegative())
+		total_duration += tag.duration;
+
+	for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i)
+		if (IsEnabled(TagType(i)))
+			AddValues(TagType(i), tag);
+}
+
+void
+DatabaseCounters::Remove(const Tag &tag)
+{
+	assert(song_count > 0);
+
+	--song_count;
+
+	if (!tag.duration.IsNegative())
+		total_duration -= tag.duration;
+
+	for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i)
+		if (IsEnabled(TagType(i)))
+			RemoveValues(TagType(i), tag);
+}
+
+DatabaseStats
+DatabaseCounters::Get() const
+{
+	DatabaseStats stats;
+	stats.song_count = song_count;
+	stats.total_duration = total_duration;
+	stats.artist_count = values[TAG_ARTIST].size();
+	stats.album_count = values[TAG_ALBUM].size();
+	return stats;
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DATABASE_COUNTERS_HXX
+#define MPD_DATABASE_COUNTERS_HXX
+
+#include "db/Stats.hxx"
+#include "db/Visitor.hxx"
+#include "tag/TagType.h"
+#include "tag/TagPool.hxx"
+#include "Chrono.hxx"
+#include "Compiler.h"
+
+#include <map>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+struct Tag;
+
+/**
+ * Aggregate statistics of all songs in a #SimpleDatabase.  They are
+ * updated incrementally whenever a song is added to or removed from
+ * a #Directory, so SimpleDatabase::GetStats() does not need to visit
+ * the whole database.  Internal #SimpleDatabase class.
+ *
+ * For each enabled #TagType, the set of distinct values is
+ * maintained together with the number of songs and their total
+ * duration, which answers unfiltered "list" and "count group"
+ * requests.  "Artist" and "Album" are always enabled; other types
+ * are enabled on demand with Enable().
+ *
+ * Caller must lock the #db_mutex.
+ */
+class DatabaseCounters {
+	struct StringLess {
+		gcc_pure
+		bool operator()(const char *a, const char *b) const {
+			return strcmp(a, b) < 0;
+		}
+	};
+
+	/**
+	 * The distinct values of one tag type.
+	 */
+	class ValueCounter {
+		struct Item {
+			/**
+			 * A tag pool reference which keeps the key
+			 * string alive.  Its type is the one of this
+			 * counter, even for "Artist" values counted as
+			 * "AlbumArtist".
+			 */
+			TagPoolId id;
+
+			/**
+			 * The number of tag items (usually one per
+			 * song) with this value.
+			 */
+			SearchStats stats;
+		};
+
+		typedef std::map<const char *, Item, StringLess> Map;
+		Map map;
+
+		/**
+		 * The number of songs without a value.
+		 */
+		unsigned missing;
+
+	public:
+		ValueCounter():missing(0) {}
+		ValueCounter(const ValueCounter &) = delete;
+
+		~ValueCounter() {
+			Clear();
+		}
+
+		unsigned size() const {
+			return map.size();
+		}
+
+		void Add(TagType type, TagPoolId id, SignedSongTime duration);
+		void Remove(TagPoolId id, SignedSongTime duration);
+
+		void AddMissing() {
+			++missing;
+		}
+
+		void RemoveMissing() {
+			assert(missing > 0);
+			--missing;
+		}
+
+		void Clear();
+
+		bool VisitValues(TagType type, VisitTag visit_tag,
+				 Error &error) const;
+		bool VisitCounts(VisitTagCount visit_tag_count,
+				 Error &error) const;
+	};
+
+	unsigned song_count;
+
+	decltype(DatabaseStats::total_duration) total_duration;
+
+	/**
+	 * A bit mask of #TagType values which are counted in
+	 * #values.
+	 */
+	uint32_t enabled_mask;
+
+	ValueCounter values[TAG_NUM_OF_ITEM_TYPES];
+
+public:
+	DatabaseCounters() {
+		Clear();
+	}
+
+	/**
+	 * Remove all songs and disable all optional tag types.
+	 */
+	void Clear();
+
+	/**
+	 * Account for a song which was added to the database.
+	 */
+	void Add(const Tag &tag);
+
+	/**
+	 * Account for a song which was removed from the database.
+	 * The #Tag must be the same as the one passed to Add().
+	 */
+	void Remove(const Tag &tag);
+
+	gcc_pure
+	bool IsEnabled(TagType type) const {
+		return (enabled_mask & (1u << unsigned(type))) != 0;
+	}
+
+	/**
+	 * Start counting the values of the specified tag type.  The
+	 * caller must then call AddValues() for every song in the
+	 * database.
+	 */
+	void Enable(TagType type) {
+		assert(!IsEnabled(type));
+
+		enabled_mask |= 1u << unsigned(type);
+	}
+
+	/**
+	 * Count the values of one tag type; Add() does this for all
+	 * enabled types.
+	 */
+	void AddValues(TagType type, const Tag &tag);
+
+	gcc_pure
+	DatabaseStats Get() const;
+
+	/**
+	 * Visit all distinct values of the specified (enabled) tag
+	 * type like VisitUniqueTags() without filter and grouping.
+	 */
+	bool VisitValues(TagType type, VisitTag visit_tag,
+			 Error &error) const {
+		assert(IsEnabled(type));
+
+		return values[type].VisitValues(type, visit_tag, error);
+	}
+
+	/**
+	 * Visit all distinct values of the specified (enabled) tag
+	 * type like Database::VisitTagCounts() without filter.
+	 */
+	bool VisitCounts(TagType type, VisitTagCount visit_tag_count,
+			 Error &error) const {
+		assert(IsEnabled(type));
+
+		return values[type].VisitCounts(visit_tag_count, error);
+	}
+
+private:
+	void RemoveValues(TagType type, const Tag &tag);
+};
+
+#endif
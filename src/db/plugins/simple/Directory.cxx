@@ -21,6 +21,7 @@
 #include "Directory.hxx"
 #include "SongSort.hxx"
 #include "Song.hxx"
+#include "Counters.hxx"
 #include "Mount.hxx"
 #include "db/LightDirectory.hxx"
 #include "db/LightSong.hxx"
@@ -42,7 +43,8 @@ Directory::Directory(std::string &&_path_utf8, Directory *_parent)
 	 mtime(0),
 	 inode(0), device(0),
 	 path(std::move(_path_utf8)),
-	 mounted_database(nullptr)
+	 mounted_database(nullptr),
+	 counters(_parent != nullptr ? _parent->counters : nullptr)
 {
 }
 
@@ -54,12 +56,30 @@ Directory::~Directory()
 	children.clear_and_dispose(Disposer());
 }
 
+/**
+ * Remove all songs in the specified directory and its children from
+ * the #DatabaseCounters.
+ */
+static void
+RemoveCountersRecursive(DatabaseCounters &counters,
+			const Directory &directory)
+{
+	for (const auto &song : directory.songs)
+		counters.Remove(song.tag);
+
+	for (const auto &child : directory.children)
+		RemoveCountersRecursive(counters, child);
+}
+
 void
 Directory::Delete()
 {
 	assert(holding_db_lock());
 	assert(parent != nullptr);
 
+	if (counters != nullptr)
+		RemoveCountersRecursive(*counters, *this);
+
 	parent->children.erase_and_dispose(parent->children.iterator_to(*this),
 					   Disposer());
 }
@@ -169,6 +189,9 @@ Directory::AddSong(Song *song)
 	assert(song->parent == this);
 
 	songs.push_back(*song);
+
+	if (counters != nullptr)
+		counters->Add(song->tag);
 }
 
 void
@@ -179,6 +202,24 @@ Directory::RemoveSong(Song *song)
 	assert(song->parent == this);
 
 	songs.erase(songs.iterator_to(*song));
+
+	if (counters != nullptr)
+		counters->Remove(song->tag);
+}
+
+void
+Directory::ReplaceSongTag(Song &song, Tag &&tag)
+{
+	assert(holding_db_lock());
+	assert(song.parent == this);
+
+	if (counters != nullptr)
+		counters->Remove(song.tag);
+
+	song.tag = std::move(tag);
+
+	if (counters != nullptr)
+		counters->Add(song.tag);
 }
 
 const Song *
@@ -45,6 +45,7 @@ static constexpr unsigned DEVICE_CONTAINER = -2;
 
 struct db_visitor;
 class SongFilter;
+class DatabaseCounters;
 class Error;
 class Database;
 
@@ -104,6 +105,13 @@ struct Directory {
 	 */
 	Database *mounted_database;
 
+	/**
+	 * The statistics of the #SimpleDatabase this directory
+	 * belongs to; they are updated by AddSong(), RemoveSong() and
+	 * Delete().  Inherited from the parent; may be nullptr.
+	 */
+	DatabaseCounters *counters;
+
 public:
 	Directory(std::string &&_path_utf8, Directory *_parent);
 	~Directory();
@@ -112,8 +120,10 @@ public:
 	 * Create a new root #Directory object.
 	 */
 	gcc_malloc
-	static Directory *NewRoot() {
-		return new Directory(std::string(), nullptr);
+	static Directory *NewRoot(DatabaseCounters *counters=nullptr) {
+		Directory *root = new Directory(std::string(), nullptr);
+		root->counters = counters;
+		return root;
 	}
 
 	bool IsMount() const {
@@ -258,6 +268,14 @@ public:
 	 */
 	void RemoveSong(Song *song);
 
+	/**
+	 * Replace the tag of a song in this directory, and update the
+	 * statistics.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	void ReplaceSongTag(Song &song, Tag &&tag);
+
 	/**
 	 * Caller must lock the #db_mutex.
 	 */
@@ -46,6 +46,7 @@
 #endif
 
 #include <errno.h>
+#include <string.h>
 
 static constexpr Domain simple_db_domain("simple_db");
 
@@ -56,6 +57,7 @@ inline SimpleDatabase::SimpleDatabase()
 	 compress(true),
 #endif
 	 cache_path(AllocatedPath::Null()),
+	 mount_count(0),
 	 prefixed_light_song(nullptr) {}
 
 inline SimpleDatabase::SimpleDatabase(AllocatedPath &&_path,
@@ -70,6 +72,7 @@ inline SimpleDatabase::SimpleDatabase(AllocatedPath &&_path,
 	 compress(_compress),
 #endif
 	 cache_path(AllocatedPath::Null()),
+	 mount_count(0),
 	 prefixed_light_song(nullptr) {
 }
 
@@ -205,7 +208,8 @@ SimpleDatabase::Open(Error &error)
 {
 	assert(prefixed_light_song == nullptr);
 
-	root = Directory::NewRoot();
+	counters.Clear();
+	root = Directory::NewRoot(&counters);
 	mtime = 0;
 
 #ifndef NDEBUG
@@ -221,7 +225,8 @@ SimpleDatabase::Open(Error &error)
 		if (!Check(error))
 			return false;
 
-		root = Directory::NewRoot();
+		counters.Clear();
+		root = Directory::NewRoot(&counters);
 	}
 
 	return true;
@@ -235,12 +240,17 @@ SimpleDatabase::Close()
 	assert(borrowed_song_count == 0);
 
 	delete root;
+	counters.Clear();
+	mount_count = 0;
 }
 
 const LightSong *
 SimpleDatabase::GetSong(const char *uri, Error &error) const
 {
 	assert(root != nullptr);
+
+	borrow_mutex.lock();
+
 	assert(prefixed_light_song == nullptr);
 	assert(borrowed_song_count == 0);
 
@@ -252,19 +262,23 @@ SimpleDatabase::GetSong(const char *uri, Error &error) const
 		/* pass the request to the mounted database */
 		db_unlock();
 
-		const LightSong *song =
-			r.directory->mounted_database->GetSong(r.uri, error);
-		if (song == nullptr)
+		Database &mounted = *r.directory->mounted_database;
+		const LightSong *song = mounted.GetSong(r.uri, error);
+		if (song == nullptr) {
+			borrow_mutex.unlock();
 			return nullptr;
+		}
 
 		prefixed_light_song =
 			new PrefixedLightSong(*song, r.directory->GetPath());
+		mounted.ReturnSong(song);
 		return prefixed_light_song;
 	}
 
 	if (r.uri == nullptr) {
 		/* it's a directory */
 		db_unlock();
+		borrow_mutex.unlock();
 		error.Format(db_domain, DB_NOT_FOUND,
 			     "No such song: %s", uri);
 		return nullptr;
@@ -273,6 +287,7 @@ SimpleDatabase::GetSong(const char *uri, Error &error) const
 	if (strchr(r.uri, '/') != nullptr) {
 		/* refers to a URI "below" the actual song */
 		db_unlock();
+		borrow_mutex.unlock();
 		error.Format(db_domain, DB_NOT_FOUND,
 			     "No such song: %s", uri);
 		return nullptr;
@@ -281,6 +296,7 @@ SimpleDatabase::GetSong(const char *uri, Error &error) const
 	const Song *song = r.directory->FindSong(r.uri);
 	db_unlock();
 	if (song == nullptr) {
+		borrow_mutex.unlock();
 		error.Format(db_domain, DB_NOT_FOUND,
 			     "No such song: %s", uri);
 		return nullptr;
@@ -310,6 +326,8 @@ SimpleDatabase::ReturnSong(gcc_unused const LightSong *song) const
 		--borrowed_song_count;
 	}
 #endif
+
+	borrow_mutex.unlock();
 }
 
 bool
@@ -350,24 +368,135 @@ SimpleDatabase::Visit(const DatabaseSelection &selection,
 	return false;
 }
 
+/**
+ * Does the selection cover the whole database without a filter?
+ */
+gcc_pure
+static bool
+IsWholeDatabase(const DatabaseSelection &selection)
+{
+	return selection.recursive && selection.IsEmpty();
+}
+
+static void
+AddCounterValues(DatabaseCounters &counters, TagType tag_type,
+		 const Directory &directory)
+{
+	for (const Song &song : directory.songs)
+		counters.AddValues(tag_type, song.tag);
+
+	for (const Directory &child : directory.children)
+		AddCounterValues(counters, tag_type, child);
+}
+
+bool
+SimpleDatabase::PrepareCounters(const DatabaseSelection &selection,
+				TagType tag_type) const
+{
+	assert(holding_db_lock());
+
+	if (mount_count > 0 || !IsWholeDatabase(selection))
+		return false;
+
+	if (!counters.IsEnabled(tag_type)) {
+		/* first request for this tag type: count all songs
+		   once, the #Directory methods keep it up to date
+		   from now on */
+		counters.Enable(tag_type);
+		AddCounterValues(counters, tag_type, *root);
+	}
+
+	return true;
+}
+
 bool
 SimpleDatabase::VisitUniqueTags(const DatabaseSelection &selection,
 				TagType tag_type, uint32_t group_mask,
 				VisitTag visit_tag,
 				Error &error) const
 {
+	if (group_mask == 0) {
+		const ScopeDatabaseLock protect;
+
+		if (PrepareCounters(selection, tag_type))
+			return counters.VisitValues(tag_type, visit_tag,
+						    error);
+	}
+
 	return ::VisitUniqueTags(*this, selection, tag_type, group_mask,
 				 visit_tag,
 				 error);
 }
 
+bool
+SimpleDatabase::VisitTagCounts(const DatabaseSelection &selection,
+			       TagType tag_type,
+			       VisitTagCount visit_tag_count,
+			       Error &error) const
+{
+	{
+		const ScopeDatabaseLock protect;
+
+		if (PrepareCounters(selection, tag_type))
+			return counters.VisitCounts(tag_type, visit_tag_count,
+						    error);
+	}
+
+	return ::VisitTagCounts(*this, selection, tag_type, visit_tag_count,
+				error);
+}
+
 bool
 SimpleDatabase::GetStats(const DatabaseSelection &selection,
 			 DatabaseStats &stats, Error &error) const
 {
+	{
+		const ScopeDatabaseLock protect;
+
+		if (mount_count == 0 && IsWholeDatabase(selection)) {
+			/* the whole database: use the precomputed
+			   counters */
+			stats = counters.Get();
+			return true;
+		}
+	}
+
 	return ::GetStats(*this, selection, stats, error);
 }
 
+static void
+AddMemoryStats(const Directory &directory, SimpleDatabaseMemoryStats &stats)
+{
+	++stats.directories;
+	stats.directory_bytes += sizeof(directory) +
+		directory.path.length() + 1;
+
+	for (const Song &song : directory.songs) {
+		++stats.songs;
+		stats.song_bytes += sizeof(song) - sizeof(song.uri) +
+			strlen(song.uri) + 1;
+		stats.tag_items += song.tag.num_items;
+		stats.tag_bytes += song.tag.num_items * sizeof(*song.tag.items);
+	}
+
+	for (const Directory &child : directory.children)
+		AddMemoryStats(child, stats);
+}
+
+SimpleDatabaseMemoryStats
+SimpleDatabase::GetMemoryStats() const
+{
+	assert(root != nullptr);
+
+	SimpleDatabaseMemoryStats stats;
+	stats.directories = stats.songs = stats.tag_items = 0;
+	stats.directory_bytes = stats.song_bytes = stats.tag_bytes = 0;
+
+	const ScopeDatabaseLock protect;
+	AddMemoryStats(*root, stats);
+	return stats;
+}
+
 bool
 SimpleDatabase::Save(Error &error)
 {
@@ -456,6 +585,7 @@ SimpleDatabase::Mount(const char *uri, Database *db, Error &error)
 
 	Directory *mnt = r.directory->CreateChild(r.uri);
 	mnt->mounted_database = db;
+	++mount_count;
 	return true;
 }
 
@@ -519,6 +649,9 @@ SimpleDatabase::LockUmountSteal(const char *uri)
 	r.directory->mounted_database = nullptr;
 	r.directory->Delete();
 
+	assert(mount_count > 0);
+	--mount_count;
+
 	return db;
 }
 
@@ -536,6 +669,6 @@ SimpleDatabase::Unmount(const char *uri)
 
 const DatabasePlugin simple_db_plugin = {
 	"simple",
-	DatabasePlugin::FLAG_REQUIRE_STORAGE,
+	DatabasePlugin::FLAG_REQUIRE_STORAGE|DatabasePlugin::FLAG_THREAD_SAFE,
 	SimpleDatabase::Create,
 };
@@ -21,9 +21,11 @@
 #define MPD_SIMPLE_DATABASE_PLUGIN_HXX
 
 #include "check.h"
+#include "Counters.hxx"
 #include "db/Interface.hxx"
 #include "fs/AllocatedPath.hxx"
 #include "db/LightSong.hxx"
+#include "thread/Mutex.hxx"
 #include "Compiler.h"
 
 #include <cassert>
@@ -35,6 +37,30 @@ class EventLoop;
 class DatabaseListener;
 class PrefixedLightSong;
 
+/**
+ * An estimate of the memory occupied by a #SimpleDatabase, see
+ * SimpleDatabase::GetMemoryStats().
+ */
+struct SimpleDatabaseMemoryStats {
+	unsigned directories, songs, tag_items;
+
+	/**
+	 * The size of all #Directory objects including their paths.
+	 */
+	size_t directory_bytes;
+
+	/**
+	 * The size of all #Song objects including their URIs.
+	 */
+	size_t song_bytes;
+
+	/**
+	 * The size of the tag item arrays of all songs (not including
+	 * the values, which are owned by the tag pool).
+	 */
+	size_t tag_bytes;
+};
+
 class SimpleDatabase : public Database {
 	AllocatedPath path;
 	std::string path_utf8;
@@ -50,6 +76,19 @@ class SimpleDatabase : public Database {
 
 	Directory *root;
 
+	/**
+	 * Statistics about all songs below #root, maintained by
+	 * #Directory.  Protected by #db_mutex.  This is mutable
+	 * because tag types are enabled on demand by const methods.
+	 */
+	mutable DatabaseCounters counters;
+
+	/**
+	 * The number of databases mounted with Mount().  If this is
+	 * non-zero, #counters is incomplete.  Protected by #db_mutex.
+	 */
+	unsigned mount_count;
+
 	time_t mtime;
 
 	/**
@@ -63,6 +102,13 @@ class SimpleDatabase : public Database {
 	 */
 	mutable LightSong light_song;
 
+	/**
+	 * Protects #light_song and #prefixed_light_song while a song
+	 * is borrowed.  It is locked by GetSong() and unlocked by
+	 * ReturnSong(), because commands may run on a worker thread.
+	 */
+	mutable Mutex borrow_mutex;
+
 #ifndef NDEBUG
 	mutable unsigned borrowed_song_count;
 #endif
@@ -106,6 +152,12 @@ public:
 	gcc_nonnull_all
 	bool Unmount(const char *uri);
 
+	/**
+	 * Walk the whole tree (not including mounted databases) and
+	 * estimate how much memory it occupies.
+	 */
+	SimpleDatabaseMemoryStats GetMemoryStats() const;
+
 	/* virtual methods from class Database */
 	virtual bool Open(Error &error) override;
 	virtual void Close() override;
@@ -125,6 +177,11 @@ public:
 				     VisitTag visit_tag,
 				     Error &error) const override;
 
+	virtual bool VisitTagCounts(const DatabaseSelection &selection,
+				    TagType tag_type,
+				    VisitTagCount visit_tag_count,
+				    Error &error) const override;
+
 	virtual bool GetStats(const DatabaseSelection &selection,
 			      DatabaseStats &stats,
 			      Error &error) const override;
@@ -141,6 +198,15 @@ private:
 
 	bool Load(Error &error);
 
+	/**
+	 * Can the request be answered from #counters?  If yes, then
+	 * the specified tag type is enabled.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	bool PrepareCounters(const DatabaseSelection &selection,
+			     TagType tag_type) const;
+
 	Database *LockUmountSteal(const char *uri);
 };
 
@@ -35,6 +35,7 @@ struct LightSong;
 struct Directory;
 class DetachedSong;
 class Storage;
+class TagBuilder;
 
 /**
  * A song file inside the configured music directory.  Internal
@@ -109,6 +110,14 @@ struct Song {
 	void Free();
 
 	bool UpdateFile(Storage &storage);
+
+	/**
+	 * Read the tag of this song's file into the #TagBuilder
+	 * without modifying this object.  This does not need the
+	 * #db_mutex.
+	 */
+	bool ScanFile(Storage &storage, time_t &mtime_r,
+		      TagBuilder &tag_builder) const;
 	bool UpdateFileInArchive(const Storage &storage);
 
 	/**
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "config.h"
+#include "Cache.hxx"
+
+#include <assert.h>
+
+std::string
+UpnpCache::MakeKey(const std::string &server, Kind kind,
+		   const char *object_id)
+{
+	std::string key(server);
+	key.push_back('\n');
+	key.push_back(char(kind));
+	key.append(object_id);
+	return key;
+}
+
+void
+UpnpCache::Remove(EntryList::iterator i)
+{
+	assert(n_objects >= i->objects->size());
+
+	n_objects -= i->objects->size();
+	map.erase(i->key);
+	entries.erase(i);
+}
+
+UpnpObjectList
+UpnpCache::Get(const std::string &server, Kind kind,
+	       const char *object_id, unsigned now)
+{
+	if (!IsEnabled())
+		return nullptr;
+
+	const ScopeLock protect(mutex);
+
+	auto i = map.find(MakeKey(server, kind, object_id));
+	if (i == map.end()) {
+		++misses;
+		return nullptr;
+	}
+
+	auto e = i->second;
+	if (now - e->timestamp >= ttl) {
+		Remove(e);
+		++misses;
+		return nullptr;
+	}
+
+	/* move to the front of the LRU list */
+	entries.splice(entries.begin(), entries, e);
+
+	++hits;
+	return e->objects;
+}
+
+void
+UpnpCache::Put(const std::string &server, Kind kind,
+	       const char *object_id, UpnpObjectList objects,
+	       unsigned now)
+{
+	assert(objects != nullptr);
+
+	if (!IsEnabled() || objects->size() > max_objects)
+		return;
+
+	const ScopeLock protect(mutex);
+
+	std::string key = MakeKey(server, kind, object_id);
+	auto i = map.find(key);
+	if (i != map.end())
+		Remove(i->second);
+
+	/* evict the least recently used entries */
+	while (n_objects + objects->size() > max_objects) {
+		assert(!entries.empty());
+		Remove(std::prev(entries.end()));
+	}
+
+	n_objects += objects->size();
+	entries.emplace_front(std::move(key), now, std::move(objects));
+	map.insert(std::make_pair(entries.front().key, entries.begin()));
+}
+
+bool
+UpnpCache::IsUpdateCheckDue(const std::string &server, unsigned now) const
+{
+	if (!IsEnabled())
+		return false;
+
+	const ScopeLock protect(mutex);
+
+	auto i = servers.find(server);
+	return i == servers.end() || now - i->second.checked >= check_interval;
+}
+
+void
+UpnpCache::SetUpdateId(const std::string &server, unsigned update_id,
+		       unsigned now)
+{
+	const ScopeLock protect(mutex);
+
+	auto i = servers.find(server);
+	if (i == servers.end()) {
+		Server s;
+		s.update_id = update_id;
+		s.checked = now;
+		servers.insert(std::make_pair(server, s));
+		return;
+	}
+
+	if (i->second.update_id != update_id) {
+		/* the server's content has changed */
+		i->second.update_id = update_id;
+		FlushLocked(server);
+	}
+
+	i->second.checked = now;
+}
+
+void
+UpnpCache::FlushLocked(const std::string &server)
+{
+	std::string prefix(server);
+	prefix.push_back('\n');
+
+	for (auto i = map.lower_bound(prefix);
+	     i != map.end() && i->first.compare(0, prefix.length(),
+						prefix) == 0;) {
+		auto e = i->second;
+		++i;
+		Remove(e);
+	}
+}
+
+void
+UpnpCache::Flush(const std::string &server)
+{
+	const ScopeLock protect(mutex);
+	FlushLocked(server);
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MPD_UPNP_CACHE_HXX
+#define MPD_UPNP_CACHE_HXX
+
+#include "check.h"
+#include "Object.hxx"
+#include "thread/Mutex.hxx"
+#include "Compiler.h"
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <memory>
+
+/**
+ * A list of objects returned by a ContentDirectory "Browse" action.
+ * It is shared between the #UpnpCache and its users, so an entry may
+ * be evicted while it is still being used.
+ */
+typedef std::shared_ptr<const std::vector<UPnPDirObject>> UpnpObjectList;
+
+/**
+ * Caches the results of ContentDirectory "Browse" actions, keyed by
+ * server, browse flag and object id.  Entries expire after a
+ * configurable time, the least recently used ones are evicted when
+ * the cache is full, and all entries of a server are discarded when
+ * its "SystemUpdateID" changes.
+ *
+ * All times are in milliseconds of an arbitrary monotonic clock,
+ * passed by the caller.
+ *
+ * This object is thread-safe.
+ */
+class UpnpCache {
+public:
+	enum class Kind : char {
+		/**
+		 * The result of "BrowseDirectChildren".
+		 */
+		CHILDREN = 'c',
+
+		/**
+		 * The result of "BrowseMetadata".
+		 */
+		METADATA = 'm',
+	};
+
+private:
+	struct Entry {
+		std::string key;
+		unsigned timestamp;
+		UpnpObjectList objects;
+
+		Entry(std::string &&_key, unsigned _timestamp,
+		      UpnpObjectList &&_objects)
+			:key(std::move(_key)), timestamp(_timestamp),
+			 objects(std::move(_objects)) {}
+	};
+
+	typedef std::list<Entry> EntryList;
+
+	struct Server {
+		/**
+		 * The last known "SystemUpdateID".
+		 */
+		unsigned update_id;
+
+		/**
+		 * When was #update_id last obtained from the server?
+		 */
+		unsigned checked;
+	};
+
+	/**
+	 * Entries expire after this number of milliseconds.  Zero
+	 * disables the cache.
+	 */
+	const unsigned ttl;
+
+	/**
+	 * How often shall the "SystemUpdateID" be checked?
+	 */
+	const unsigned check_interval;
+
+	/**
+	 * The maximum number of objects in all entries.
+	 */
+	const size_t max_objects;
+
+	mutable Mutex mutex;
+
+	/**
+	 * All entries, the most recently used first.
+	 */
+	EntryList entries;
+
+	/**
+	 * Looks up #entries by key.  The key starts with the server
+	 * id, so all entries of one server are adjacent.
+	 */
+	std::map<std::string, EntryList::iterator> map;
+
+	std::map<std::string, Server> servers;
+
+	/**
+	 * The sum of all entries' sizes.
+	 */
+	size_t n_objects;
+
+	unsigned hits, misses;
+
+public:
+	UpnpCache(unsigned _ttl, unsigned _check_interval,
+		  size_t _max_objects)
+		:ttl(_ttl), check_interval(_check_interval),
+		 max_objects(_max_objects),
+		 n_objects(0), hits(0), misses(0) {}
+
+	UpnpCache(const UpnpCache &) = delete;
+	UpnpCache &operator=(const UpnpCache &) = delete;
+
+	bool IsEnabled() const {
+		return ttl > 0;
+	}
+
+	/**
+	 * Look up a cached result.
+	 *
+	 * @return the objects or nullptr if there is no valid entry
+	 */
+	UpnpObjectList Get(const std::string &server, Kind kind,
+			   const char *object_id, unsigned now);
+
+	void Put(const std::string &server, Kind kind,
+		 const char *object_id, UpnpObjectList objects,
+		 unsigned now);
+
+	/**
+	 * Shall the caller obtain the server's "SystemUpdateID" and
+	 * pass it to SetUpdateId()?
+	 */
+	gcc_pure
+	bool IsUpdateCheckDue(const std::string &server, unsigned now) const;
+
+	/**
+	 * Remember the server's current "SystemUpdateID".  If it has
+	 * changed, all entries of this server are discarded.
+	 */
+	void SetUpdateId(const std::string &server, unsigned update_id,
+			 unsigned now);
+
+	/**
+	 * Discard all entries of the specified server.
+	 */
+	void Flush(const std::string &server);
+
+	unsigned GetHits() const {
+		const ScopeLock protect(mutex);
+		return hits;
+	}
+
+	unsigned GetMisses() const {
+		const ScopeLock protect(mutex);
+		return misses;
+	}
+
+private:
+	static std::string MakeKey(const std::string &server, Kind kind,
+				   const char *object_id);
+
+	void Remove(EntryList::iterator i);
+	void FlushLocked(const std::string &server);
+};
+
+#endif
@@ -20,6 +20,7 @@
 #include "config.h"
 #include "UpnpDatabasePlugin.hxx"
 #include "Directory.hxx"
+#include "Cache.hxx"
 #include "Tags.hxx"
 #include "lib/upnp/Domain.hxx"
 #include "lib/upnp/ClientInit.hxx"
@@ -33,12 +34,14 @@
 #include "db/LightDirectory.hxx"
 #include "db/LightSong.hxx"
 #include "db/Stats.hxx"
+#include "db/Helpers.hxx"
 #include "config/ConfigData.hxx"
 #include "tag/TagBuilder.hxx"
 #include "tag/TagTable.hxx"
 #include "util/Error.hxx"
 #include "util/Domain.hxx"
 #include "fs/Traits.hxx"
+#include "system/Clock.hxx"
 #include "Log.hxx"
 #include "SongFilter.hxx"
 
@@ -51,6 +54,17 @@
 
 static const char *const rootid = "0";
 
+/**
+ * How often shall the "SystemUpdateID" of a server be checked?
+ * [ms]
+ */
+static constexpr unsigned UPNP_UPDATE_CHECK_INTERVAL = 10000;
+
+/**
+ * The maximum number of objects in the cache.
+ */
+static constexpr size_t UPNP_CACHE_MAX_OBJECTS = 100000;
+
 class UpnpSong : public LightSong {
 	std::string uri2, real_uri2;
 
@@ -74,8 +88,17 @@ class UpnpDatabase : public Database {
 	UpnpClient_Handle handle;
 	UPnPDeviceDirectory *discovery;
 
+	/**
+	 * Caches "Browse" results, because each client query walks
+	 * the path from the root container.
+	 */
+	mutable UpnpCache cache;
+
 public:
-	UpnpDatabase():Database(upnp_db_plugin) {}
+	explicit UpnpDatabase(unsigned cache_ttl)
+		:Database(upnp_db_plugin),
+		 cache(cache_ttl, UPNP_UPDATE_CHECK_INTERVAL,
+		       UPNP_CACHE_MAX_OBJECTS) {}
 
 	static Database *Create(EventLoop &loop, DatabaseListener &listener,
 				const config_param &param,
@@ -98,6 +121,11 @@ public:
 				     VisitTag visit_tag,
 				     Error &error) const override;
 
+	virtual bool VisitTagCounts(const DatabaseSelection &selection,
+				    TagType tag_type,
+				    VisitTagCount visit_tag_count,
+				    Error &error) const override;
+
 	virtual bool GetStats(const DatabaseSelection &selection,
 			      DatabaseStats &stats,
 			      Error &error) const override;
@@ -136,6 +164,21 @@ private:
 		   UPnPDirObject &dirent,
 		   Error &error) const;
 
+	/**
+	 * Check the server's "SystemUpdateID" if that is due, and
+	 * flush its cache entries if it has changed.
+	 */
+	void CheckCache(const ContentDirectoryService &server) const;
+
+	/**
+	 * Take server and objid, return the children of this
+	 * container.
+	 *
+	 * @return nullptr on error
+	 */
+	UpnpObjectList ReadDir(const ContentDirectoryService &server,
+			       const char *objid, Error &error) const;
+
 	/**
 	 * Take server and objid, return metadata.
 	 */
@@ -158,7 +201,10 @@ UpnpDatabase::Create(gcc_unused EventLoop &loop,
 		     gcc_unused DatabaseListener &listener,
 		     const config_param &param, Error &error)
 {
-	UpnpDatabase *db = new UpnpDatabase();
+	/* seconds; 0 disables the cache */
+	const unsigned cache_ttl = param.GetBlockValue("cache_ttl", 300u);
+
+	UpnpDatabase *db = new UpnpDatabase(cache_ttl * 1000);
 	if (!db->Configure(param, error)) {
 		delete db;
 		return nullptr;
@@ -422,25 +468,90 @@ UpnpDatabase::SearchSongs(const ContentDirectoryService &server,
 	return true;
 }
 
+void
+UpnpDatabase::CheckCache(const ContentDirectoryService &server) const
+{
+	const std::string uri = server.GetURI();
+	const unsigned now = MonotonicClockMS();
+	if (!cache.IsUpdateCheckDue(uri, now))
+		return;
+
+	unsigned update_id;
+	Error error;
+	if (!server.getSystemUpdateID(handle, update_id, error)) {
+		/* not supported by this server; rely on the cache's
+		   expiry time */
+		LogDebug(upnp_domain, error.GetMessage());
+		update_id = 0;
+	}
+
+	cache.SetUpdateId(uri, update_id, now);
+}
+
+UpnpObjectList
+UpnpDatabase::ReadDir(const ContentDirectoryService &server,
+		      const char *objid, Error &error) const
+{
+	CheckCache(server);
+
+	const std::string uri = server.GetURI();
+	auto objects = cache.Get(uri, UpnpCache::Kind::CHILDREN, objid,
+				 MonotonicClockMS());
+	if (objects != nullptr)
+		return objects;
+
+	UPnPDirContent dirbuf;
+	if (!server.readDir(handle, objid, dirbuf, error))
+		return nullptr;
+
+	objects = std::make_shared<std::vector<UPnPDirObject>>
+		(std::move(dirbuf.objects));
+	cache.Put(uri, UpnpCache::Kind::CHILDREN, objid, objects,
+		  MonotonicClockMS());
+	return objects;
+}
+
 bool
 UpnpDatabase::ReadNode(const ContentDirectoryService &server,
 		       const char *objid, UPnPDirObject &dirent,
 		       Error &error) const
 {
-	UPnPDirContent dirbuf;
-	if (!server.getMetadata(handle, objid, dirbuf, error))
-		return false;
+	CheckCache(server);
 
-	if (dirbuf.objects.size() == 1) {
-		dirent = std::move(dirbuf.objects.front());
-	} else {
-		error.Format(upnp_domain, "Bad resource");
-		return false;
+	const std::string uri = server.GetURI();
+	auto objects = cache.Get(uri, UpnpCache::Kind::METADATA, objid,
+				 MonotonicClockMS());
+	if (objects == nullptr) {
+		UPnPDirContent dirbuf;
+		if (!server.getMetadata(handle, objid, dirbuf, error))
+			return false;
+
+		if (dirbuf.objects.size() != 1) {
+			error.Format(upnp_domain, "Bad resource");
+			return false;
+		}
+
+		objects = std::make_shared<std::vector<UPnPDirObject>>
+		(std::move(dirbuf.objects));
+		cache.Put(uri, UpnpCache::Kind::METADATA, objid, objects,
+			  MonotonicClockMS());
 	}
 
+	dirent = UPnPDirObject(objects->front());
 	return true;
 }
 
+gcc_pure
+static const UPnPDirObject *
+FindObject(const std::vector<UPnPDirObject> &objects, const char *name)
+{
+	for (const auto &o : objects)
+		if (o.name == name)
+			return &o;
+
+	return nullptr;
+}
+
 bool
 UpnpDatabase::BuildPath(const ContentDirectoryService &server,
 			const UPnPDirObject& idirent,
@@ -486,12 +597,12 @@ UpnpDatabase::Namei(const ContentDirectoryService &server,
 
 	// Walk the path elements, read each directory and try to find the next one
 	for (auto i = vpath.begin(), last = std::prev(vpath.end());; ++i) {
-		UPnPDirContent dirbuf;
-		if (!server.readDir(handle, objid.c_str(), dirbuf, error))
+		const auto objects = ReadDir(server, objid.c_str(), error);
+		if (objects == nullptr)
 			return false;
 
 		// Look for the name in the sub-container list
-		UPnPDirObject *child = dirbuf.FindObject(i->c_str());
+		const UPnPDirObject *child = FindObject(*objects, i->c_str());
 		if (child == nullptr) {
 			error.Format(db_domain, DB_NOT_FOUND,
 				     "No such object");
@@ -499,7 +610,7 @@ UpnpDatabase::Namei(const ContentDirectoryService &server,
 		}
 
 		if (i == last) {
-			odirent = std::move(*child);
+			odirent = UPnPDirObject(*child);
 			return true;
 		}
 
@@ -509,7 +620,7 @@ UpnpDatabase::Namei(const ContentDirectoryService &server,
 			return false;
 		}
 
-		objid = std::move(child->m_id);
+		objid = child->m_id;
 	}
 }
 
@@ -657,12 +768,11 @@ UpnpDatabase::VisitServer(const ContentDirectoryService &server,
 	/* Target was a a container. Visit it. We could read slices
 	   and loop here, but it's not useful as mpd will only return
 	   data to the client when we're done anyway. */
-	UPnPDirContent dirbuf;
-	if (!server.readDir(handle, tdirent.m_id.c_str(), dirbuf,
-			    error))
+	const auto objects = ReadDir(server, tdirent.m_id.c_str(), error);
+	if (objects == nullptr)
 		return false;
 
-	for (auto &dirent : dirbuf.objects) {
+	for (const auto &dirent : *objects) {
 		const std::string uri = PathTraitsUTF8::Build(base_uri,
 							      dirent.name.c_str());
 		if (!VisitObject(dirent, uri.c_str(),
@@ -766,6 +876,16 @@ UpnpDatabase::VisitUniqueTags(const DatabaseSelection &selection,
 	return true;
 }
 
+bool
+UpnpDatabase::VisitTagCounts(const DatabaseSelection &selection,
+			     TagType tag_type,
+			     VisitTagCount visit_tag_count,
+			     Error &error) const
+{
+	return ::VisitTagCounts(*this, selection, tag_type, visit_tag_count,
+				error);
+}
+
 bool
 UpnpDatabase::GetStats(const DatabaseSelection &,
 		       DatabaseStats &stats, Error &) const
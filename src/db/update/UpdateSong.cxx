@@ -26,6 +26,7 @@
 #include "db/plugins/simple/Song.hxx"
 #include "decoder/DecoderList.hxx"
 #include "storage/FileInfo.hxx"
+#include "tag/TagBuilder.hxx"
 #include "Log.hxx"
 
 #include <unistd.h>
@@ -79,11 +80,21 @@ UpdateWalk::UpdateSongFile2(Directory &directory,
 	} else if (info.mtime != song->mtime || walk_discard) {
 		FormatDefault(update_domain, "updating %s/%s",
 			      directory.GetPath(), name);
-		if (!song->UpdateFile(storage)) {
+
+		/* scan without holding the lock, and replace the tag
+		   and update the statistics in one step */
+		TagBuilder tag_builder;
+		time_t new_mtime;
+		if (!song->ScanFile(storage, new_mtime, tag_builder)) {
 			FormatDebug(update_domain,
 				    "deleting unrecognized file %s/%s",
 				    directory.GetPath(), name);
 			editor.LockDeleteSong(directory, song);
+		} else {
+			db_lock();
+			song->mtime = new_mtime;
+			directory.ReplaceSongTag(*song, tag_builder.Commit());
+			db_unlock();
 		}
 
 		modified = true;
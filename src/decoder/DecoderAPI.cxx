@@ -29,11 +29,14 @@
 #include "DecoderControl.hxx"
 #include "DecoderInternal.hxx"
 #include "DetachedSong.hxx"
+#include "SeekIndex.hxx"
 #include "input/InputStream.hxx"
 #include "util/Error.hxx"
 #include "util/ConstBuffer.hxx"
 #include "Log.hxx"
 
+#include <algorithm>
+
 #include <assert.h>
 #include <string.h>
 #include <math.h>
@@ -251,6 +254,42 @@ void decoder_seek_error(Decoder & decoder)
 	decoder_command_finished(decoder);
 }
 
+bool
+decoder_seek_index_lookup(gcc_unused Decoder &decoder, InputStream &is,
+			  SongTime time, SeekPoint &result)
+{
+	return is.KnownSize() &&
+		seek_index_lookup(is.GetURI(), is.GetSize(),
+				  is.GetLastModified(), time, result);
+}
+
+void
+decoder_seek_index_add(gcc_unused Decoder &decoder, InputStream &is,
+		       SongTime time, offset_type offset)
+{
+	if (is.KnownSize())
+		seek_index_add(is.GetURI(), is.GetSize(),
+			       is.GetLastModified(), time, offset);
+}
+
+SignedSongTime
+decoder_seek_index_duration(gcc_unused Decoder &decoder, InputStream &is)
+{
+	return is.KnownSize()
+		? seek_index_get_duration(is.GetURI(), is.GetSize(),
+					  is.GetLastModified())
+		: SignedSongTime::Negative();
+}
+
+void
+decoder_seek_index_set_duration(gcc_unused Decoder &decoder,
+				InputStream &is, SignedSongTime duration)
+{
+	if (is.KnownSize())
+		seek_index_set_duration(is.GetURI(), is.GetSize(),
+					is.GetLastModified(), duration);
+}
+
 InputStream *
 decoder_open_uri(Decoder &decoder, const char *uri, Error &error)
 {
@@ -441,25 +480,24 @@ update_stream_tag(Decoder &decoder, InputStream *is)
 	return true;
 }
 
-DecoderCommand
-decoder_data(Decoder &decoder,
-	     InputStream *is,
-	     const void *data, size_t length,
-	     uint16_t kbit_rate)
+/**
+ * Checks the current command and sends pending stream tags.  This is
+ * the common prologue of decoder_data() and decoder_write_buffer().
+ */
+static DecoderCommand
+decoder_prepare_data(Decoder &decoder, InputStream *is)
 {
 	DecoderControl &dc = decoder.dc;
 	DecoderCommand cmd;
 
 	assert(dc.state == DecoderState::DECODE);
 	assert(dc.pipe != nullptr);
-	assert(length % dc.in_audio_format.GetFrameSize() == 0);
 
 	dc.Lock();
 	cmd = decoder_get_virtual_command(decoder);
 	dc.Unlock();
 
-	if (cmd == DecoderCommand::STOP || cmd == DecoderCommand::SEEK ||
-	    length == 0)
+	if (cmd == DecoderCommand::STOP || cmd == DecoderCommand::SEEK)
 		return cmd;
 
 	assert(!decoder.initial_seek_pending);
@@ -477,36 +515,50 @@ decoder_data(Decoder &decoder,
 		} else
 			/* send only the stream tag */
 			cmd = do_send_tag(decoder, *decoder.stream_tag);
-
-		if (cmd != DecoderCommand::NONE)
-			return cmd;
 	}
 
-	if (decoder.convert != nullptr) {
-		assert(dc.in_audio_format != dc.out_audio_format);
+	return cmd;
+}
 
-		Error error;
-		auto result = decoder.convert->Convert({data, length},
-						       error);
-		if (data == nullptr) {
-			/* the PCM conversion has failed - stop
-			   playback, since we have no better way to
-			   bail out */
-			LogError(error);
-			return DecoderCommand::STOP;
-		}
+/**
+ * Account for #length bytes which have been appended to the current
+ * chunk, and flush it if it is full.
+ */
+static DecoderCommand
+decoder_expand_chunk(Decoder &decoder, size_t length)
+{
+	DecoderControl &dc = decoder.dc;
 
-		data = result.data;
-		length = result.size;
-	} else {
-		assert(dc.in_audio_format == dc.out_audio_format);
-	}
+	assert(decoder.chunk != nullptr);
 
-	while (length > 0) {
-		MusicChunk *chunk;
-		bool full;
+	if (decoder.chunk->Expand(dc.out_audio_format, length))
+		/* the chunk is full, flush it */
+		decoder.FlushChunk();
+
+	decoder.timestamp += (double)length /
+		dc.out_audio_format.GetTimeToSize();
 
-		chunk = decoder.GetChunk();
+	if (dc.end_time.IsPositive() &&
+	    decoder.timestamp >= dc.end_time.ToDoubleS())
+		/* the end of this range has been reached:
+		   stop decoding */
+		return DecoderCommand::STOP;
+
+	return DecoderCommand::NONE;
+}
+
+/**
+ * Copy PCM data (already in the output audio format) into the
+ * #MusicPipe.
+ */
+static DecoderCommand
+decoder_push_data(Decoder &decoder, const void *data, size_t length,
+		  uint16_t kbit_rate)
+{
+	DecoderControl &dc = decoder.dc;
+
+	while (length > 0) {
+		MusicChunk *chunk = decoder.GetChunk();
 		if (chunk == nullptr) {
 			assert(dc.command != DecoderCommand::NONE);
 			return dc.command;
@@ -529,30 +581,132 @@ decoder_data(Decoder &decoder,
 
 		memcpy(dest.data, data, nbytes);
 
-		/* expand the music pipe chunk */
-
-		full = chunk->Expand(dc.out_audio_format, nbytes);
-		if (full) {
-			/* the chunk is full, flush it */
-			decoder.FlushChunk();
-		}
-
 		data = (const uint8_t *)data + nbytes;
 		length -= nbytes;
 
-		decoder.timestamp += (double)nbytes /
-			dc.out_audio_format.GetTimeToSize();
+		/* expand the music pipe chunk */
 
-		if (dc.end_time.IsPositive() &&
-		    decoder.timestamp >= dc.end_time.ToDoubleS())
-			/* the end of this range has been reached:
-			   stop decoding */
-			return DecoderCommand::STOP;
+		DecoderCommand cmd = decoder_expand_chunk(decoder, nbytes);
+		if (cmd != DecoderCommand::NONE)
+			return cmd;
 	}
 
 	return DecoderCommand::NONE;
 }
 
+/**
+ * Convert PCM data to the output audio format and pass it to
+ * decoder_push_data().
+ */
+static DecoderCommand
+decoder_convert_data(Decoder &decoder, const void *data, size_t length,
+		     uint16_t kbit_rate)
+{
+	assert(decoder.convert != nullptr);
+	assert(decoder.dc.in_audio_format != decoder.dc.out_audio_format);
+
+	Error error;
+	auto result = decoder.convert->Convert({data, length}, error);
+	if (result.IsNull()) {
+		/* the PCM conversion has failed - stop playback,
+		   since we have no better way to bail out */
+		LogError(error);
+		return DecoderCommand::STOP;
+	}
+
+	return decoder_push_data(decoder, result.data, result.size,
+				 kbit_rate);
+}
+
+DecoderCommand
+decoder_data(Decoder &decoder,
+	     InputStream *is,
+	     const void *data, size_t length,
+	     uint16_t kbit_rate)
+{
+	DecoderControl &dc = decoder.dc;
+
+	assert(length % dc.in_audio_format.GetFrameSize() == 0);
+
+	if (length == 0) {
+		dc.Lock();
+		DecoderCommand cmd = decoder_get_virtual_command(decoder);
+		dc.Unlock();
+		return cmd;
+	}
+
+	DecoderCommand cmd = decoder_prepare_data(decoder, is);
+	if (cmd != DecoderCommand::NONE)
+		return cmd;
+
+	if (decoder.convert != nullptr)
+		return decoder_convert_data(decoder, data, length, kbit_rate);
+
+	assert(dc.in_audio_format == dc.out_audio_format);
+	return decoder_push_data(decoder, data, length, kbit_rate);
+}
+
+WritableBuffer<void>
+decoder_write_buffer(Decoder &decoder, InputStream *is, uint16_t kbit_rate)
+{
+	DecoderControl &dc = decoder.dc;
+
+	if (decoder_prepare_data(decoder, is) != DecoderCommand::NONE)
+		return nullptr;
+
+	if (decoder.convert != nullptr) {
+		/* PCM conversion is needed; let the plugin decode
+		   into a temporary buffer, which will be converted by
+		   decoder_commit() */
+		const size_t frame_size = dc.in_audio_format.GetFrameSize();
+		const size_t size = std::max(CHUNK_SIZE / frame_size,
+					     size_t(1)) * frame_size;
+
+		decoder.write_kbit_rate = kbit_rate;
+		return { decoder.write_buffer.Get(size), size };
+	}
+
+	assert(dc.in_audio_format == dc.out_audio_format);
+
+	while (true) {
+		MusicChunk *chunk = decoder.GetChunk();
+		if (chunk == nullptr) {
+			assert(dc.command != DecoderCommand::NONE);
+			return nullptr;
+		}
+
+		const auto dest =
+			chunk->Write(dc.out_audio_format,
+				     SongTime::FromS(decoder.timestamp) -
+				     dc.song->GetStartTime(),
+				     kbit_rate);
+		if (!dest.IsEmpty())
+			return dest;
+
+		/* the chunk is full, flush it */
+		decoder.FlushChunk();
+	}
+}
+
+DecoderCommand
+decoder_commit(Decoder &decoder, size_t length)
+{
+	gcc_unused const DecoderControl &dc = decoder.dc;
+
+	assert(dc.state == DecoderState::DECODE);
+	assert(length % dc.in_audio_format.GetFrameSize() == 0);
+
+	if (length == 0)
+		return DecoderCommand::NONE;
+
+	if (decoder.convert != nullptr)
+		return decoder_convert_data(decoder,
+					    decoder.write_buffer.Get(length),
+					    length, decoder.write_kbit_rate);
+
+	return decoder_expand_chunk(decoder, length);
+}
+
 DecoderCommand
 decoder_tag(Decoder &decoder, InputStream *is,
 	    Tag &&tag)
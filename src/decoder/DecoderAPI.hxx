@@ -38,6 +38,9 @@
 #include "MixRampInfo.hxx"
 #include "config/ConfigData.hxx"
 #include "Chrono.hxx"
+#include "SeekIndex.hxx"
+#include "input/Offset.hxx"
+#include "util/WritableBuffer.hxx"
 
 // IWYU pragma: end_exports
 
@@ -111,6 +114,50 @@ decoder_seek_where_frame(Decoder &decoder);
 void
 decoder_seek_error(Decoder &decoder);
 
+/**
+ * Look up the persistent seek index of the stream: find the last
+ * known position at or before the given time.  Decoders should
+ * resume decoding at the returned offset and skip the remaining
+ * distance.
+ *
+ * @param decoder the decoder object
+ * @param is the input stream; its size must be known
+ * @return true if a position was found
+ */
+bool
+decoder_seek_index_lookup(Decoder &decoder, InputStream &is,
+			  SongTime time, SeekPoint &result);
+
+/**
+ * Record a position in the persistent seek index.  Call this
+ * regularly while decoding, with the time of the first sample which
+ * can be decoded after seeking to the given offset.  This is cheap;
+ * points which are too close to existing ones are ignored.
+ *
+ * @param decoder the decoder object
+ * @param is the input stream; its size must be known
+ */
+void
+decoder_seek_index_add(Decoder &decoder, InputStream &is,
+		       SongTime time, offset_type offset);
+
+/**
+ * Returns the song duration stored in the persistent seek index,
+ * e.g. if the decoder cannot determine it cheaply on a remote
+ * stream.
+ *
+ * @return the duration or a negative value if unknown
+ */
+SignedSongTime
+decoder_seek_index_duration(Decoder &decoder, InputStream &is);
+
+/**
+ * Store the song duration in the persistent seek index.
+ */
+void
+decoder_seek_index_set_duration(Decoder &decoder, InputStream &is,
+				SignedSongTime duration);
+
 /**
  * Open a new #InputStream and wait until it's ready.  Can get
  * cancelled by DecoderCommand::STOP (returns nullptr without setting
@@ -193,6 +240,48 @@ decoder_data(Decoder &decoder, InputStream &is,
 	return decoder_data(decoder, &is, data, length, kbit_rate);
 }
 
+/**
+ * Obtain a buffer for decoding PCM data directly into the
+ * #MusicPipe, avoiding the copy performed by decoder_data().  The
+ * plugin writes up to buffer.size bytes in the audio format passed to
+ * decoder_initialized() and then calls decoder_commit().  Between
+ * these two calls, only decoder_read(), decoder_read_full() and
+ * decoder_skip() may be called.
+ *
+ * If PCM conversion is active, the buffer is a temporary one, and
+ * decoder_commit() converts it.
+ *
+ * @param decoder the decoder object
+ * @param is an input stream which is buffering while we are waiting
+ * for the player
+ * @param kbit_rate the current bit rate of the source file
+ * @return a buffer whose size is a multiple of the frame size, or a
+ * "null" buffer if a command is pending (see decoder_get_command())
+ */
+WritableBuffer<void>
+decoder_write_buffer(Decoder &decoder, InputStream *is,
+		     uint16_t kbit_rate);
+
+static inline WritableBuffer<void>
+decoder_write_buffer(Decoder &decoder, InputStream &is,
+		     uint16_t kbit_rate)
+{
+	return decoder_write_buffer(decoder, &is, kbit_rate);
+}
+
+/**
+ * Submit data written to the buffer returned by
+ * decoder_write_buffer().
+ *
+ * @param decoder the decoder object
+ * @param length the number of bytes written; must be a multiple of
+ * the frame size, and may be 0
+ * @return the current command, or DecoderCommand::NONE if there is no
+ * command pending
+ */
+DecoderCommand
+decoder_commit(Decoder &decoder, size_t length);
+
 /**
  * This function is called by the decoder plugin when it has
  * successfully decoded a tag.
@@ -21,22 +21,43 @@
 #include "DecoderControl.hxx"
 #include "MusicPipe.hxx"
 #include "DetachedSong.hxx"
+#include "input/InputStream.hxx"
+#include "thread/Name.hxx"
+#include "fs/Traits.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "util/Error.hxx"
+#include "util/Domain.hxx"
+#include "Log.hxx"
 
 #include <assert.h>
 
+static constexpr Domain decoder_control_domain("decoder_control");
+
 DecoderControl::DecoderControl(Mutex &_mutex, Cond &_client_cond)
 	:mutex(_mutex), client_cond(_client_cond),
 	 state(DecoderState::STOP),
 	 command(DecoderCommand::NONE),
 	 client_is_waiting(false),
 	 song(nullptr),
+	 preload_is(nullptr), preload_serial(0),
+	 preload_pending(false), preload_quit(false),
 	 replay_gain_db(0), replay_gain_prev_db(0) {}
 
 DecoderControl::~DecoderControl()
 {
 	ClearError();
 
+	if (preload_thread.IsDefined()) {
+		Lock();
+		preload_quit = true;
+		preload_cond.signal();
+		Unlock();
+
+		preload_thread.Join();
+	}
+
 	delete song;
+	delete preload_is;
 }
 
 void
@@ -137,3 +158,136 @@ DecoderControl::CycleMixRamp()
 	previous_mix_ramp = std::move(mix_ramp);
 	mix_ramp.Clear();
 }
+
+void
+DecoderControl::Preload(const char *uri_utf8)
+{
+	/* use the same URI the decoder thread will open; see
+	   decoder_run() */
+	std::string uri;
+	if (PathTraitsUTF8::IsAbsolute(uri_utf8)) {
+		const auto path_fs = AllocatedPath::FromUTF8(uri_utf8,
+							     IgnoreError());
+		if (path_fs.IsNull()) {
+			CancelPreload();
+			return;
+		}
+
+		uri = path_fs.c_str();
+	} else
+		uri = uri_utf8;
+
+	Lock();
+	if (preload_uri == uri) {
+		/* already requested */
+		Unlock();
+		return;
+	}
+
+	InputStream *old = preload_is;
+	preload_is = nullptr;
+	preload_uri = std::move(uri);
+	++preload_serial;
+	preload_pending = true;
+	preload_cond.signal();
+	Unlock();
+
+	/* streams must be closed without holding the mutex, because
+	   some plugins need to synchronize with the I/O thread */
+	delete old;
+
+	if (!preload_thread.IsDefined()) {
+		Error error;
+		if (!preload_thread.Start(PreloadTask, this, error)) {
+			LogError(error);
+			CancelPreload();
+		}
+	}
+}
+
+void
+DecoderControl::CancelPreload()
+{
+	Lock();
+	InputStream *is = preload_is;
+	preload_is = nullptr;
+	preload_uri.clear();
+	++preload_serial;
+	preload_pending = false;
+	Unlock();
+
+	delete is;
+}
+
+inline void
+DecoderControl::PreloadTask()
+{
+	SetThreadName("preload");
+
+	Lock();
+
+	while (!preload_quit) {
+		if (!preload_pending) {
+			preload_cond.wait(mutex);
+			continue;
+		}
+
+		preload_pending = false;
+
+		const std::string uri = preload_uri;
+		const unsigned serial = preload_serial;
+		Unlock();
+
+		/* this may block (connect, HTTP request, spinning up
+		   a disk), which is why it runs in this thread */
+		Error error;
+		InputStream *is = InputStream::Open(uri.c_str(),
+						    mutex, cond, error);
+		if (is == nullptr && error.IsDefined())
+			FormatDebug(decoder_control_domain,
+				    "Failed to preload \"%s\": %s",
+				    uri.c_str(), error.GetMessage());
+
+		Lock();
+		if (serial == preload_serial) {
+			/* still wanted */
+			assert(preload_is == nullptr);
+			preload_is = is;
+			is = nullptr;
+		}
+
+		if (is != nullptr) {
+			/* the request was withdrawn or superseded
+			   meanwhile */
+			Unlock();
+			delete is;
+			Lock();
+		}
+	}
+
+	Unlock();
+}
+
+void
+DecoderControl::PreloadTask(void *ctx)
+{
+	DecoderControl &dc = *(DecoderControl *)ctx;
+	dc.PreloadTask();
+}
+
+InputStream *
+DecoderControl::StealPreloadLocked(const char *uri)
+{
+	if (preload_uri != uri)
+		return nullptr;
+
+	InputStream *is = preload_is;
+	preload_is = nullptr;
+	preload_uri.clear();
+
+	/* if the preload thread is still opening it, that stream will
+	   be discarded; the decoder thread opens its own */
+	++preload_serial;
+	preload_pending = false;
+	return is;
+}
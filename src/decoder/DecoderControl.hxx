@@ -29,6 +29,8 @@
 #include "Chrono.hxx"
 #include "util/Error.hxx"
 
+#include <string>
+
 #include <assert.h>
 #include <stdint.h>
 
@@ -38,6 +40,7 @@
 #endif
 
 class DetachedSong;
+class InputStream;
 class MusicBuffer;
 class MusicPipe;
 
@@ -153,6 +156,53 @@ struct DecoderControl {
 	 */
 	MusicPipe *pipe;
 
+	/**
+	 * The thread which opens #preload_uri.  It is started by the
+	 * first Preload() call.  InputStream::Open() may block, and
+	 * neither the player thread nor the I/O thread must wait for
+	 * it.
+	 */
+	Thread preload_thread;
+
+	/**
+	 * Wakes up #preload_thread.  Uses #mutex.
+	 */
+	Cond preload_cond;
+
+	/**
+	 * An #InputStream which was opened in advance by
+	 * #preload_thread after Preload(), while the previous song
+	 * was still being decoded.  The decoder thread takes
+	 * ownership when it is about to open #preload_uri.  Protected
+	 * by #mutex.
+	 */
+	InputStream *preload_is;
+
+	/**
+	 * The (file system or remote) URI requested by Preload().
+	 * #preload_is is nullptr while #preload_thread is still
+	 * opening it, or if that has failed.  Empty if there is no
+	 * request.
+	 */
+	std::string preload_uri;
+
+	/**
+	 * Incremented whenever #preload_uri changes, so
+	 * #preload_thread can detect that the stream it has just
+	 * opened is no longer wanted.
+	 */
+	unsigned preload_serial;
+
+	/**
+	 * Shall #preload_thread open #preload_uri?
+	 */
+	bool preload_pending;
+
+	/**
+	 * Shall #preload_thread exit?
+	 */
+	bool preload_quit;
+
 	float replay_gain_db;
 	float replay_gain_prev_db;
 
@@ -369,6 +419,44 @@ public:
 
 	void Quit();
 
+	/**
+	 * Ask #preload_thread to open the #InputStream of the given
+	 * song in advance, so its connection is established and its
+	 * buffer gets filled while the current song is still playing.
+	 * The next Start() for this song will pick it up.  Replaces
+	 * any previously preloaded stream.  This method does not
+	 * block.
+	 *
+	 * Caller must not lock the object.  Errors are ignored; the
+	 * decoder thread will retry and report them.
+	 *
+	 * @param uri_utf8 the song's "real" URI
+	 */
+	void Preload(const char *uri_utf8);
+
+	/**
+	 * Close the stream opened by Preload(), if any, or withdraw
+	 * the request.
+	 *
+	 * Caller must not lock the object.
+	 */
+	void CancelPreload();
+
+	/**
+	 * Take ownership of the stream opened by Preload(), but only
+	 * if it was opened with the given URI.
+	 *
+	 * Caller must lock the object.
+	 *
+	 * @return the stream or nullptr
+	 */
+	InputStream *StealPreloadLocked(const char *uri);
+
+private:
+	void PreloadTask();
+	static void PreloadTask(void *ctx);
+
+public:
 	const char *GetMixRampStart() const {
 		return mix_ramp.GetStart();
 	}
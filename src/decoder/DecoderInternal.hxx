@@ -21,8 +21,11 @@
 #define MPD_DECODER_INTERNAL_HXX
 
 #include "ReplayGainInfo.hxx"
+#include "pcm/PcmBuffer.hxx"
 #include "util/Error.hxx"
 
+#include <stdint.h>
+
 class PcmConvert;
 struct MusicChunk;
 struct DecoderControl;
@@ -79,6 +82,19 @@ struct Decoder {
 	/** the chunk currently being written to */
 	MusicChunk *chunk;
 
+	/**
+	 * The buffer returned by decoder_write_buffer() while PCM
+	 * conversion is active.  decoder_commit() converts its
+	 * contents into the #MusicPipe.
+	 */
+	PcmBuffer write_buffer;
+
+	/**
+	 * The bit rate passed to decoder_write_buffer(), used by
+	 * decoder_commit() when converting #write_buffer.
+	 */
+	uint16_t write_kbit_rate;
+
 	ReplayGainInfo replay_gain_info;
 
 	/**
@@ -102,6 +118,7 @@ struct Decoder {
 		 seeking(false),
 		 song_tag(_tag), stream_tag(nullptr), decoder_tag(nullptr),
 		 chunk(nullptr),
+		 write_kbit_rate(0),
 		 replay_gain_serial(0) {
 	}
 
@@ -74,7 +74,14 @@ decoder_input_stream_open(DecoderControl &dc, const char *uri)
 {
 	Error error;
 
-	InputStream *is = InputStream::Open(uri, dc.mutex, dc.cond, error);
+	/* the player thread may have opened this stream already
+	   while the previous song was playing */
+	dc.Lock();
+	InputStream *is = dc.StealPreloadLocked(uri);
+	dc.Unlock();
+
+	if (is == nullptr)
+		is = InputStream::Open(uri, dc.mutex, dc.cond, error);
 	if (is == nullptr) {
 		if (error.IsDefined())
 			LogError(error);
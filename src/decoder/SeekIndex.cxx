@@ -0,0 +1,352 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "SeekIndex.hxx"
+#include "thread/Mutex.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "fs/io/TextFile.hxx"
+#include "fs/io/FileOutputStream.hxx"
+#include "fs/io/BufferedOutputStream.hxx"
+#include "util/StringUtil.hxx"
+#include "util/Error.hxx"
+#include "util/Domain.hxx"
+#include "Log.hxx"
+
+#include <map>
+#include <string>
+#include <algorithm>
+
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define SEEK_INDEX_BEGIN "seek_index_begin: "
+#define SEEK_INDEX_SIZE "size: "
+#define SEEK_INDEX_MTIME "mtime: "
+#define SEEK_INDEX_DURATION "duration: "
+#define SEEK_INDEX_POINT "point: "
+#define SEEK_INDEX_END "seek_index_end"
+
+static constexpr Domain seek_index_domain("seek_index");
+
+constexpr SongTime SeekIndex::GRANULARITY;
+
+/**
+ * Do not index more files than this; when the limit is reached, the
+ * least recently used file is evicted.
+ */
+static constexpr size_t MAX_FILES = 16384;
+
+void
+SeekIndex::Add(SongTime time, offset_type offset)
+{
+	if (points.size() >= MAX_POINTS)
+		return;
+
+	const auto i = std::lower_bound(points.begin(), points.end(), time,
+					[](const SeekPoint &p, SongTime t){
+						return p.time < t;
+					});
+
+	if (i != points.end() && i->time - time < GRANULARITY)
+		return;
+
+	if (i != points.begin() && time - std::prev(i)->time < GRANULARITY)
+		return;
+
+	points.insert(i, SeekPoint{time, offset});
+}
+
+const SeekPoint *
+SeekIndex::Lookup(SongTime time) const
+{
+	const auto i = std::upper_bound(points.begin(), points.end(), time,
+					[](SongTime t, const SeekPoint &p){
+						return t < p.time;
+					});
+	if (i == points.begin())
+		return nullptr;
+
+	return &*std::prev(i);
+}
+
+struct SeekIndexEntry {
+	SeekIndex index;
+
+	/**
+	 * The value of #seek_index_clock when this entry was last
+	 * used.
+	 */
+	unsigned long last_used;
+
+	SeekIndexEntry(SeekIndex &&_index, unsigned long _last_used)
+		:index(std::move(_index)), last_used(_last_used) {}
+};
+
+static Mutex seek_index_mutex;
+static AllocatedPath seek_index_path = AllocatedPath::Null();
+static std::map<std::string, SeekIndexEntry> seek_index_map;
+static bool seek_index_modified;
+
+/**
+ * Incremented on each access; used to find the least recently used
+ * entry.
+ */
+static unsigned long seek_index_clock;
+
+static void
+seek_index_load(TextFile &file)
+{
+	const char *line;
+	while ((line = file.ReadLine()) != nullptr) {
+		if (!StringStartsWith(line, SEEK_INDEX_BEGIN))
+			continue;
+
+		std::string uri(line + sizeof(SEEK_INDEX_BEGIN) - 1);
+		SeekIndex index(0, std::string());
+
+		while ((line = file.ReadLine()) != nullptr &&
+		       strcmp(line, SEEK_INDEX_END) != 0) {
+			char *endptr;
+			if (StringStartsWith(line, SEEK_INDEX_SIZE)) {
+				index = SeekIndex(strtoull(line + sizeof(SEEK_INDEX_SIZE) - 1,
+							   nullptr, 10),
+						  std::string(index.GetModificationTime()));
+			} else if (StringStartsWith(line, SEEK_INDEX_MTIME)) {
+				index = SeekIndex(index.GetSize(),
+						  line + sizeof(SEEK_INDEX_MTIME) - 1);
+			} else if (StringStartsWith(line, SEEK_INDEX_DURATION)) {
+				unsigned long ms = strtoul(line + sizeof(SEEK_INDEX_DURATION) - 1,
+							   nullptr, 10);
+				index.SetDuration(SignedSongTime::FromMS(ms));
+			} else if (StringStartsWith(line, SEEK_INDEX_POINT)) {
+				unsigned long ms = strtoul(line + sizeof(SEEK_INDEX_POINT) - 1,
+							   &endptr, 10);
+				if (*endptr != ' ')
+					continue;
+
+				offset_type offset = strtoull(endptr + 1,
+							      nullptr, 10);
+				index.Add(SongTime::FromMS(ms), offset);
+			}
+		}
+
+		if (index.GetSize() > 0)
+			seek_index_map.insert(std::make_pair(std::move(uri),
+							     SeekIndexEntry(std::move(index),
+									    0)));
+	}
+}
+
+void
+seek_index_global_init(AllocatedPath &&path)
+{
+	assert(seek_index_path.IsNull());
+	assert(!path.IsNull());
+
+	seek_index_path = std::move(path);
+	seek_index_modified = false;
+
+	Error error;
+	TextFile file(seek_index_path, error);
+	if (file.HasFailed()) {
+		/* the file does not exist yet */
+		FormatDebug(seek_index_domain, "%s", error.GetMessage());
+		return;
+	}
+
+	seek_index_load(file);
+
+	FormatDebug(seek_index_domain, "Loaded seek index for %u files",
+		    unsigned(seek_index_map.size()));
+}
+
+static bool
+seek_index_save(OutputStream &os, Error &error)
+{
+	BufferedOutputStream bos(os);
+
+	for (const auto &i : seek_index_map) {
+		const SeekIndex &index = i.second.index;
+
+		bos.Format(SEEK_INDEX_BEGIN "%s\n", i.first.c_str());
+		bos.Format(SEEK_INDEX_SIZE "%llu\n",
+			   (unsigned long long)index.GetSize());
+		if (!index.GetModificationTime().empty())
+			bos.Format(SEEK_INDEX_MTIME "%s\n",
+				   index.GetModificationTime().c_str());
+		if (!index.GetDuration().IsNegative())
+			bos.Format(SEEK_INDEX_DURATION "%lu\n",
+				   (unsigned long)index.GetDuration().ToMS());
+
+		for (const auto &p : index.GetPoints())
+			bos.Format(SEEK_INDEX_POINT "%lu %llu\n",
+				   (unsigned long)p.time.ToMS(),
+				   (unsigned long long)p.offset);
+
+		bos.Write(SEEK_INDEX_END "\n");
+	}
+
+	return bos.Flush(error);
+}
+
+void
+seek_index_global_finish()
+{
+	if (seek_index_path.IsNull())
+		return;
+
+	if (seek_index_modified) {
+		Error error;
+		FileOutputStream fos(seek_index_path, error);
+		if (!fos.IsDefined() || !seek_index_save(fos, error) ||
+		    !fos.Commit(error))
+			LogError(error);
+	}
+
+	seek_index_map.clear();
+	seek_index_path = AllocatedPath::Null();
+}
+
+/**
+ * Find the index for the given file.  Caller must lock the mutex.
+ *
+ * @return nullptr if there is no valid index
+ */
+static SeekIndex *
+seek_index_find(const char *uri, offset_type size, const char *mtime)
+{
+	if (seek_index_path.IsNull())
+		return nullptr;
+
+	auto i = seek_index_map.find(uri);
+	if (i == seek_index_map.end())
+		return nullptr;
+
+	if (!i->second.index.Matches(size, mtime)) {
+		/* the file was modified */
+		seek_index_map.erase(i);
+		seek_index_modified = true;
+		return nullptr;
+	}
+
+	i->second.last_used = ++seek_index_clock;
+	return &i->second.index;
+}
+
+/**
+ * Remove the least recently used entry.  Caller must lock the
+ * mutex.
+ */
+static void
+seek_index_evict()
+{
+	auto lru = std::min_element(seek_index_map.begin(),
+				    seek_index_map.end(),
+				    [](const std::pair<const std::string, SeekIndexEntry> &a,
+				       const std::pair<const std::string, SeekIndexEntry> &b){
+					    return a.second.last_used < b.second.last_used;
+				    });
+	if (lru != seek_index_map.end()) {
+		seek_index_map.erase(lru);
+		seek_index_modified = true;
+	}
+}
+
+/**
+ * Find or create the index for the given file.  Caller must lock
+ * the mutex.
+ */
+static SeekIndex *
+seek_index_make(const char *uri, offset_type size, const char *mtime)
+{
+	SeekIndex *index = seek_index_find(uri, size, mtime);
+	if (index != nullptr || seek_index_path.IsNull())
+		return index;
+
+	if (seek_index_map.size() >= MAX_FILES)
+		seek_index_evict();
+
+	SeekIndex new_index(size, mtime != nullptr ? mtime : "");
+	auto i = seek_index_map.insert(std::make_pair(std::string(uri),
+						      SeekIndexEntry(std::move(new_index),
+								     ++seek_index_clock)));
+	return &i.first->second.index;
+}
+
+bool
+seek_index_lookup(const char *uri, offset_type size, const char *mtime,
+		  SongTime time, SeekPoint &result)
+{
+	const ScopeLock protect(seek_index_mutex);
+
+	const SeekIndex *index = seek_index_find(uri, size, mtime);
+	if (index == nullptr)
+		return false;
+
+	const SeekPoint *p = index->Lookup(time);
+	if (p == nullptr)
+		return false;
+
+	result = *p;
+	return true;
+}
+
+SignedSongTime
+seek_index_get_duration(const char *uri, offset_type size,
+			const char *mtime)
+{
+	const ScopeLock protect(seek_index_mutex);
+
+	const SeekIndex *index = seek_index_find(uri, size, mtime);
+	return index != nullptr
+		? index->GetDuration()
+		: SignedSongTime::Negative();
+}
+
+void
+seek_index_add(const char *uri, offset_type size, const char *mtime,
+	       SongTime time, offset_type offset)
+{
+	const ScopeLock protect(seek_index_mutex);
+
+	SeekIndex *index = seek_index_make(uri, size, mtime);
+	if (index == nullptr)
+		return;
+
+	const size_t old_size = index->GetPoints().size();
+	index->Add(time, offset);
+	if (index->GetPoints().size() != old_size)
+		seek_index_modified = true;
+}
+
+void
+seek_index_set_duration(const char *uri, offset_type size,
+			const char *mtime, SignedSongTime duration)
+{
+	const ScopeLock protect(seek_index_mutex);
+
+	SeekIndex *index = seek_index_make(uri, size, mtime);
+	if (index == nullptr || index->GetDuration() == duration)
+		return;
+
+	index->SetDuration(duration);
+	seek_index_modified = true;
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_SEEK_INDEX_HXX
+#define MPD_SEEK_INDEX_HXX
+
+#include "check.h"
+#include "Chrono.hxx"
+#include "input/Offset.hxx"
+#include "Compiler.h"
+
+#include <string>
+#include <vector>
+
+class Path;
+class AllocatedPath;
+
+/**
+ * One entry of a #SeekIndex: decoding may resume at byte #offset,
+ * and the first sample decoded from there is at #time.
+ */
+struct SeekPoint {
+	SongTime time;
+	offset_type offset;
+};
+
+/**
+ * A sparse time to byte offset table for one file.  Decoder
+ * plugins fill it while playing; later, seeks can jump directly
+ * to a nearby offset instead of bisecting or scanning the stream.
+ */
+class SeekIndex {
+	/**
+	 * The size of the file this index was built for.  It is
+	 * used to detect modified files.
+	 */
+	offset_type size;
+
+	/**
+	 * The modification time of the file this index was built
+	 * for, as reported by InputStream::GetLastModified(); empty
+	 * if unknown.  A re-encoded or retagged file may keep its
+	 * size, but not its modification time.
+	 */
+	std::string mtime;
+
+	/**
+	 * The duration of the song, if known.
+	 */
+	SignedSongTime duration;
+
+	/**
+	 * Sorted by #SeekPoint::time.
+	 */
+	std::vector<SeekPoint> points;
+
+public:
+	/**
+	 * The minimum distance between two points.
+	 */
+	static constexpr SongTime GRANULARITY = SongTime::FromS(1u);
+
+	/**
+	 * Do not record more points than this per file.
+	 */
+	static constexpr size_t MAX_POINTS = 8192;
+
+	SeekIndex(offset_type _size, std::string &&_mtime)
+		:size(_size), mtime(std::move(_mtime)),
+		 duration(SignedSongTime::Negative()) {}
+
+	offset_type GetSize() const {
+		return size;
+	}
+
+	const std::string &GetModificationTime() const {
+		return mtime;
+	}
+
+	/**
+	 * Was this index built for a file with the given size and
+	 * modification time?
+	 *
+	 * @param _mtime the modification time or nullptr if unknown
+	 */
+	gcc_pure
+	bool Matches(offset_type _size, const char *_mtime) const {
+		return _size == size &&
+			mtime == (_mtime != nullptr ? _mtime : "");
+	}
+
+	SignedSongTime GetDuration() const {
+		return duration;
+	}
+
+	void SetDuration(SignedSongTime _duration) {
+		duration = _duration;
+	}
+
+	bool IsEmpty() const {
+		return points.empty();
+	}
+
+	const std::vector<SeekPoint> &GetPoints() const {
+		return points;
+	}
+
+	/**
+	 * Add a point.  It is ignored if there is already a point
+	 * closer than #GRANULARITY.
+	 */
+	void Add(SongTime time, offset_type offset);
+
+	/**
+	 * Find the last point at or before the given time.
+	 *
+	 * @return nullptr if there is no such point
+	 */
+	gcc_pure
+	const SeekPoint *Lookup(SongTime time) const;
+};
+
+/**
+ * Load the persistent seek index from the given file.  After this,
+ * the other seek_index_*() functions are operational.
+ */
+void
+seek_index_global_init(AllocatedPath &&path);
+
+/**
+ * Save the seek index (if modified) and free all resources.
+ */
+void
+seek_index_global_finish();
+
+/**
+ * Look up the indexed #SeekPoint before the given time.
+ *
+ * @param uri the URI of the #InputStream
+ * @param size the size of the file
+ * @param mtime the modification time of the file (see
+ * InputStream::GetLastModified()) or nullptr if unknown; a
+ * mismatch of this or #size invalidates the stored index
+ * @return true if a point was found
+ */
+bool
+seek_index_lookup(const char *uri, offset_type size, const char *mtime,
+		  SongTime time, SeekPoint &result);
+
+/**
+ * @return the duration stored in the index, or a negative value
+ * if unknown
+ */
+SignedSongTime
+seek_index_get_duration(const char *uri, offset_type size,
+			const char *mtime);
+
+void
+seek_index_add(const char *uri, offset_type size, const char *mtime,
+	       SongTime time, offset_type offset);
+
+void
+seek_index_set_duration(const char *uri, offset_type size,
+			const char *mtime, SignedSongTime duration);
+
+#endif
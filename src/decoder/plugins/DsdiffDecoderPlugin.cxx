@@ -366,12 +366,8 @@ dsdiff_decode_chunk(Decoder &decoder, InputStream &is,
 {
 	const offset_type start_offset = is.GetOffset();
 
-	uint8_t buffer[8192];
-
-	const size_t sample_size = sizeof(buffer[0]);
+	const size_t sample_size = sizeof(uint8_t);
 	const size_t frame_size = channels * sample_size;
-	const unsigned buffer_frames = sizeof(buffer) / frame_size;
-	const size_t buffer_size = buffer_frames * frame_size;
 
 	auto cmd = decoder_get_command(decoder);
 	for (offset_type remaining_bytes = total_bytes;
@@ -392,9 +388,19 @@ dsdiff_decode_chunk(Decoder &decoder, InputStream &is,
 				decoder_seek_error(decoder);
 		}
 
+		/* read directly into the MusicChunk */
+		const auto dest = decoder_write_buffer(decoder, is,
+						       sample_rate / 1000);
+		if (dest.IsNull()) {
+			cmd = decoder_get_command(decoder);
+			continue;
+		}
+
+		uint8_t *const buffer = (uint8_t *)dest.data;
+
 		/* see how much aligned data from the remaining chunk
-		   fits into the local buffer */
-		size_t now_size = buffer_size;
+		   fits into the buffer */
+		size_t now_size = dest.size;
 		if (remaining_bytes < (offset_type)now_size) {
 			unsigned now_frames = remaining_bytes / frame_size;
 			now_size = now_frames * frame_size;
@@ -409,8 +415,7 @@ dsdiff_decode_chunk(Decoder &decoder, InputStream &is,
 		if (lsbitfirst)
 			bit_reverse_buffer(buffer, buffer + nbytes);
 
-		cmd = decoder_data(decoder, is, buffer, nbytes,
-				   sample_rate / 1000);
+		cmd = decoder_commit(decoder, nbytes);
 	}
 
 	return true;
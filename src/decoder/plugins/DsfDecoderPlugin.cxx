@@ -279,16 +279,31 @@ dsf_decode_chunk(Decoder &decoder, InputStream &is,
 				decoder_seek_error(decoder);
 		}
 
-		/* worst-case buffer size */
+		/* if the stream supports it (e.g. a memory-mapped
+		   file), interleave directly from its memory, else
+		   read into a buffer (worst-case size) first */
+		const uint8_t *src;
 		uint8_t buffer[MAX_CHANNELS * DSF_BLOCK_SIZE];
-		if (!decoder_read_full(&decoder, is, buffer, block_size))
-			return false;
-
-		if (bitreverse)
-			bit_reverse_buffer(buffer, buffer + block_size);
+		const auto peek = is.LockPeek();
+		if (peek.size >= block_size) {
+			src = (const uint8_t *)peek.data;
+		} else {
+			if (!decoder_read_full(&decoder, is,
+					       buffer, block_size))
+				return false;
+
+			src = buffer;
+		}
 
 		uint8_t interleaved_buffer[MAX_CHANNELS * DSF_BLOCK_SIZE];
-		InterleaveDsfBlock(interleaved_buffer, buffer, channels);
+		InterleaveDsfBlock(interleaved_buffer, src, channels);
+
+		if (src != buffer)
+			is.LockConsume(block_size);
+
+		if (bitreverse)
+			bit_reverse_buffer(interleaved_buffer,
+					   interleaved_buffer + block_size);
 
 		cmd = decoder_data(decoder, is,
 				   interleaved_buffer, block_size,
@@ -29,6 +29,8 @@
 #include "util/Error.hxx"
 #include "Log.hxx"
 
+#include <algorithm>
+
 flac_data::flac_data(Decoder &_decoder,
 		     InputStream &_input_stream)
 	:FlacInput(_input_stream, &_decoder),
@@ -153,28 +155,44 @@ flac_common_write(struct flac_data *data, const FLAC__Frame * frame,
 		  const FLAC__int32 *const buf[],
 		  FLAC__uint64 nbytes)
 {
-	void *buffer;
 	unsigned bit_rate;
 
 	if (!data->initialized && !flac_got_first_frame(data, &frame->header))
 		return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
 
-	size_t buffer_size = frame->header.blocksize * data->frame_size;
-	buffer = data->buffer.Get(buffer_size);
-
-	flac_convert(buffer, frame->header.channels,
-		     data->audio_format.format, buf,
-		     0, frame->header.blocksize);
+	const unsigned blocksize = frame->header.blocksize;
 
 	if (nbytes > 0)
 		bit_rate = nbytes * 8 * frame->header.sample_rate /
-			(1000 * frame->header.blocksize);
+			(1000 * blocksize);
 	else
 		bit_rate = 0;
 
-	auto cmd = decoder_data(data->decoder, data->input_stream,
-				buffer, buffer_size,
-				bit_rate);
+	/* convert directly into MusicChunk memory, as many frames
+	   at a time as fit */
+
+	DecoderCommand cmd = DecoderCommand::NONE;
+	for (unsigned position = 0; position < blocksize;) {
+		const auto dest = decoder_write_buffer(data->decoder,
+						       data->input_stream,
+						       bit_rate);
+		if (dest.IsNull()) {
+			cmd = decoder_get_command(data->decoder);
+			break;
+		}
+
+		const unsigned n = std::min<unsigned>(dest.size / data->frame_size,
+						      blocksize - position);
+		flac_convert(dest.data, frame->header.channels,
+			     data->audio_format.format, buf,
+			     position, position + n);
+		position += n;
+
+		cmd = decoder_commit(data->decoder, n * data->frame_size);
+		if (cmd != DecoderCommand::NONE)
+			break;
+	}
+
 	data->next_frame += frame->header.blocksize;
 	switch (cmd) {
 	case DecoderCommand::NONE:
@@ -125,6 +125,13 @@ struct MadDecoder {
 	SignedSongTime total_time;
 	SongTime elapsed_time;
 	SongTime seek_time;
+
+	/**
+	 * The next point in time which shall be recorded in the
+	 * persistent seek index.
+	 */
+	SongTime index_time;
+
 	enum muteframe mute_frame;
 	long *frame_offsets;
 	mad_timer_t *times;
@@ -147,6 +154,17 @@ struct MadDecoder {
 	~MadDecoder();
 
 	bool Seek(long offset);
+
+	/**
+	 * Jump to a position beyond #highest_frame with the help of
+	 * the persistent seek index.  On success, the remaining
+	 * distance to the given time is skipped with
+	 * #MUTEFRAME_SEEK.
+	 *
+	 * @return false if the index did not help
+	 */
+	bool SeekIndexed(SongTime t);
+
 	bool FillBuffer();
 	void ParseId3(size_t tagsize, Tag **mpd_tag);
 	enum mp3_action DecodeNextFrameHeader(Tag **tag);
@@ -168,6 +186,7 @@ struct MadDecoder {
 	gcc_pure
 	long TimeToFrame(SongTime t) const;
 
+	void AddSeekIndexPoint(long offset);
 	void UpdateTimerNextFrame();
 
 	/**
@@ -186,7 +205,8 @@ struct MadDecoder {
 
 MadDecoder::MadDecoder(Decoder *_decoder,
 		       InputStream &_input_stream)
-	:mute_frame(MUTEFRAME_NONE),
+	:index_time(SongTime::zero()),
+	 mute_frame(MUTEFRAME_NONE),
 	 frame_offsets(nullptr),
 	 times(nullptr),
 	 highest_frame(0), max_frames(0), current_frame(0),
@@ -217,6 +237,59 @@ MadDecoder::Seek(long offset)
 	return true;
 }
 
+bool
+MadDecoder::SeekIndexed(SongTime t)
+{
+	if (!input_stream.KnownSize() || highest_frame == 0)
+		return false;
+
+	/* without the index, decoding would resume here: at the
+	   current position if the target is ahead, or else at the
+	   end of the frame table */
+	SongTime scan_start = ToSongTime(times[highest_frame - 1]);
+	if (elapsed_time <= t && elapsed_time > scan_start)
+		scan_start = elapsed_time;
+
+	SeekPoint point;
+	if (!decoder_seek_index_lookup(*decoder, input_stream, t, point) ||
+	    point.time <= scan_start)
+		/* not worth it */
+		return false;
+
+	/* all frames of a MP3 file have the same duration, so the
+	   frame number can be calculated from the time */
+	const long duration_us = mad_timer_count(frame.header.duration,
+						 MAD_UNITS_MICROSECONDS);
+	if (duration_us <= 0)
+		return false;
+
+	const unsigned long f = (uint64_t(point.time.ToMS()) * 1000
+				 + duration_us / 2) / duration_us;
+	if (f <= highest_frame || f >= max_frames ||
+	    point.offset <= offset_type(frame_offsets[highest_frame - 1]))
+		return false;
+
+	if (!Seek(point.offset))
+		return false;
+
+	/* the offsets of the frames in between are unknown; the
+	   frame table keeps covering only the frames which were
+	   actually parsed, and UpdateTimerNextFrame() does not
+	   record frames beyond this gap */
+	current_frame = f;
+	timer = frame.header.duration;
+	mad_timer_multiply(&timer, f);
+	elapsed_time = ToSongTime(timer);
+	index_time = elapsed_time + SeekIndex::GRANULARITY;
+
+	if (elapsed_time < t) {
+		seek_time = t;
+		mute_frame = MUTEFRAME_SEEK;
+	}
+
+	return true;
+}
+
 inline bool
 MadDecoder::FillBuffer()
 {
@@ -858,6 +931,20 @@ mad_decoder_total_file_time(InputStream &is)
 		: std::make_pair(false, SignedSongTime::Negative());
 }
 
+inline void
+MadDecoder::AddSeekIndexPoint(long offset)
+{
+	if (decoder == nullptr || !input_stream.KnownSize())
+		return;
+
+	const auto frame_time = ToSongTime(timer);
+	if (frame_time >= index_time) {
+		decoder_seek_index_add(*decoder, input_stream,
+				       frame_time, offset);
+		index_time = frame_time + SeekIndex::GRANULARITY;
+	}
+}
+
 long
 MadDecoder::TimeToFrame(SongTime t) const
 {
@@ -875,7 +962,13 @@ MadDecoder::TimeToFrame(SongTime t) const
 void
 MadDecoder::UpdateTimerNextFrame()
 {
-	if (current_frame >= highest_frame) {
+	if (current_frame > highest_frame) {
+		/* beyond the gap left by SeekIndexed(): this frame
+		   cannot be recorded in frame_offsets */
+		bit_rate = frame.header.bitrate;
+		AddSeekIndexPoint(ThisFrameOffset());
+		mad_timer_add(&timer, frame.header.duration);
+	} else if (current_frame == highest_frame) {
 		/* record this frame's properties in frame_offsets
 		   (for seeking) and times */
 		bit_rate = frame.header.bitrate;
@@ -887,6 +980,7 @@ MadDecoder::UpdateTimerNextFrame()
 			highest_frame++;
 
 		frame_offsets[current_frame] = ThisFrameOffset();
+		AddSeekIndexPoint(frame_offsets[current_frame]);
 
 		mad_timer_add(&timer, frame.header.duration);
 		times[current_frame] = timer;
@@ -1007,7 +1101,20 @@ MadDecoder::Read()
 					decoder_command_finished(*decoder);
 				} else
 					decoder_seek_error(*decoder);
+			} else if (SeekIndexed(decoder_seek_time(*decoder))) {
+				decoder_command_finished(*decoder);
+			} else if (decoder_seek_time(*decoder) < elapsed_time &&
+				   !Seek(frame_offsets[highest_frame - 1])) {
+				decoder_seek_error(*decoder);
 			} else {
+				if (decoder_seek_time(*decoder) < elapsed_time)
+					/* the target is behind the
+					   current position, but beyond
+					   the frame table (after
+					   SeekIndexed()): decode from the
+					   end of the table */
+					current_frame = highest_frame - 1;
+
 				seek_time = decoder_seek_time(*decoder);
 				mute_frame = MUTEFRAME_SEEK;
 				decoder_command_finished(*decoder);
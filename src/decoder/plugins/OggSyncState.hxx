@@ -22,6 +22,7 @@
 
 #include "check.h"
 #include "OggUtil.hxx"
+#include "input/InputStream.hxx"
 
 #include <ogg/ogg.h>
 
@@ -50,6 +51,17 @@ public:
 		ogg_sync_reset(&oy);
 	}
 
+	/**
+	 * Determine the stream offset where the given page begins.
+	 * It must be the page most recently returned by
+	 * ExpectPage().
+	 */
+	gcc_pure
+	offset_type GetPageOffset(const ogg_page &page) const {
+		return is.GetOffset() - (oy.fill - oy.returned)
+			- page.header_len - page.body_len;
+	}
+
 	bool Feed(size_t size) {
 		return OggFeed(oy, decoder, is, size);
 	}
@@ -35,6 +35,8 @@
 #include <opus.h>
 #include <ogg/ogg.h>
 
+#include <algorithm>
+
 #include <string.h>
 #include <stdio.h>
 
@@ -79,6 +81,24 @@ class MPDOpusDecoder {
 
 	ogg_int64_t eos_granulepos;
 
+	/**
+	 * The granule position of the previous page, i.e. the
+	 * position of the first sample in the current page.
+	 */
+	ogg_int64_t page_granulepos;
+
+	/**
+	 * The next point in time which shall be recorded in the
+	 * persistent seek index.
+	 */
+	SongTime index_time;
+
+	/**
+	 * The number of frames to be discarded after a seek to a
+	 * position found in the seek index.
+	 */
+	uint64_t skip_frames;
+
 	size_t frame_size;
 
 public:
@@ -87,7 +107,9 @@ public:
 		:decoder(_decoder), input_stream(_input_stream),
 		 opus_decoder(nullptr),
 		 output_buffer(nullptr), output_size(0),
-		 os_initialized(false), found_opus(false) {}
+		 os_initialized(false), found_opus(false),
+		 page_granulepos(-1), index_time(SongTime::zero()),
+		 skip_frames(0) {}
 	~MPDOpusDecoder();
 
 	bool ReadFirstPage(OggSyncState &oy);
@@ -138,6 +160,23 @@ MPDOpusDecoder::ReadNextPage(OggSyncState &oy)
 	if (page_serialno != os.serialno)
 		ogg_stream_reset_serialno(&os, page_serialno);
 
+	if (found_opus && page_granulepos > 0 &&
+	    input_stream.KnownSize()) {
+		/* decoding can resume at this page with the sample
+		   following the previous page's granule position */
+		const auto page_time =
+			SongTime::FromScale<uint64_t>(page_granulepos,
+						      opus_sample_rate);
+		if (page_time >= index_time) {
+			decoder_seek_index_add(decoder, input_stream,
+					       page_time,
+					       oy.GetPageOffset(page));
+			index_time = page_time + SeekIndex::GRANULARITY;
+		}
+	}
+
+	page_granulepos = ogg_page_granulepos(&page);
+
 	ogg_stream_pagein(&os, &page);
 	return true;
 }
@@ -253,15 +292,28 @@ MPDOpusDecoder::HandleBOS(const ogg_packet &packet)
 
 	eos_granulepos = LoadEOSGranulePos(input_stream, &decoder,
 					   opus_serialno);
-	const auto duration = eos_granulepos >= 0
+	auto duration = eos_granulepos >= 0
 		? SignedSongTime::FromScale<uint64_t>(eos_granulepos,
 						      opus_sample_rate)
 		: SignedSongTime::Negative();
 
+	bool seekable = eos_granulepos > 0;
+	if (seekable)
+		decoder_seek_index_set_duration(decoder, input_stream,
+						duration);
+	else if (input_stream.IsSeekable()) {
+		/* finding the EOS packet on a remote file is too
+		   expensive, but maybe we have played this file
+		   before */
+		duration = decoder_seek_index_duration(decoder,
+						       input_stream);
+		seekable = duration.IsPositive();
+	}
+
 	const AudioFormat audio_format(opus_sample_rate,
 				       SampleFormat::S16, channels);
 	decoder_initialized(decoder, audio_format,
-			    eos_granulepos > 0, duration);
+			    seekable, duration);
 	frame_size = audio_format.GetFrameSize();
 
 	/* allocate an output buffer for 16 bit PCM samples big enough
@@ -311,10 +363,20 @@ MPDOpusDecoder::HandleAudio(const ogg_packet &packet)
 		return DecoderCommand::STOP;
 	}
 
+	const opus_int16 *data = output_buffer;
+	if (skip_frames > 0) {
+		/* discard the head of the data to land exactly at
+		   the seek position */
+		const unsigned n = std::min<uint64_t>(nframes, skip_frames);
+		skip_frames -= n;
+		nframes -= n;
+		data += n * (frame_size / sizeof(*data));
+	}
+
 	if (nframes > 0) {
 		const size_t nbytes = nframes * frame_size;
 		auto cmd = decoder_data(decoder, input_stream,
-					output_buffer, nbytes,
+					data, nbytes,
 					0);
 		if (cmd != DecoderCommand::NONE)
 			return cmd;
@@ -331,12 +393,39 @@ MPDOpusDecoder::HandleAudio(const ogg_packet &packet)
 bool
 MPDOpusDecoder::Seek(OggSyncState &oy, uint64_t where_frame)
 {
-	assert(eos_granulepos > 0);
 	assert(input_stream.IsSeekable());
 	assert(input_stream.KnownSize());
 
 	const ogg_int64_t where_granulepos(where_frame);
 
+	skip_frames = 0;
+
+	SeekPoint point;
+	if (decoder_seek_index_lookup(decoder, input_stream,
+				      decoder_seek_time(decoder), point)) {
+		const uint64_t point_frame =
+			point.time.ToScale<uint64_t>(opus_sample_rate);
+		const uint64_t max_distance = 2 *
+			SeekIndex::GRANULARITY.ToScale<uint64_t>(opus_sample_rate);
+		if (eos_granulepos <= 0 ||
+		    where_frame - point_frame <= max_distance) {
+			/* the indexed page is close enough: go there
+			   and skip the remaining distance */
+			if (!OggSeekPageAtOffset(oy, os, input_stream,
+						 point.offset))
+				return false;
+
+			skip_frames = where_frame - point_frame;
+			page_granulepos = -1;
+			return true;
+		}
+	}
+
+	if (eos_granulepos <= 0)
+		return false;
+
+	page_granulepos = -1;
+
 	/* interpolate the file offset where we expect to find the
 	   given granule position */
 	/* TODO: implement binary search */
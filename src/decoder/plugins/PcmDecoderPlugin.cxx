@@ -52,13 +52,28 @@ pcm_stream_decode(Decoder &decoder, InputStream &is)
 
 	DecoderCommand cmd;
 	do {
-		char buffer[4096];
-
-		size_t nbytes = decoder_read(decoder, is,
-					     buffer, sizeof(buffer));
-
-		if (nbytes == 0 && is.LockIsEOF())
-			break;
+		/* read directly into the MusicChunk */
+		const auto dest = decoder_write_buffer(decoder, is, 0);
+		uint8_t *const buffer = (uint8_t *)dest.data;
+		size_t nbytes = 0;
+
+		if (!dest.IsNull()) {
+			nbytes = decoder_read(decoder, is, buffer, dest.size);
+			if (nbytes == 0 && is.LockIsEOF())
+				break;
+
+			/* complete a partial frame, or discard it if
+			   that is not possible */
+			const size_t partial = nbytes % frame_size;
+			if (partial > 0) {
+				if (decoder_read_full(&decoder, is,
+						      buffer + nbytes,
+						      frame_size - partial))
+					nbytes += frame_size - partial;
+				else
+					nbytes -= partial;
+			}
+		}
 
 		if (reverse_endian)
 			/* make sure we deliver samples in host byte order */
@@ -67,8 +82,7 @@ pcm_stream_decode(Decoder &decoder, InputStream &is)
 					 (uint16_t *)(buffer + nbytes));
 
 		cmd = nbytes > 0
-			? decoder_data(decoder, is,
-				       buffer, nbytes, 0)
+			? decoder_commit(decoder, nbytes)
 			: decoder_get_command(decoder);
 		if (cmd == DecoderCommand::SEEK) {
 			uint64_t frame = decoder_seek_where_frame(decoder);
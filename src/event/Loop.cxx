@@ -30,6 +30,7 @@
 
 EventLoop::EventLoop()
 	:SocketMonitor(*this),
+	 timers(::MonotonicClockMS()),
 	 now_ms(::MonotonicClockMS()),
 	 quit(false), busy(true),
 #ifndef NDEBUG
@@ -44,7 +45,7 @@ EventLoop::EventLoop()
 EventLoop::~EventLoop()
 {
 	assert(idle.empty());
-	assert(timers.empty());
+	assert(timers.IsEmpty());
 
 	/* this is necessary to get a well-defined destruction
 	   order */
@@ -104,7 +105,7 @@ EventLoop::AddTimer(TimeoutMonitor &t, unsigned ms)
 	   modifies the timeout during avahi_client_free() */
 	assert(IsInsideOrNull());
 
-	timers.insert(TimerRecord(t, now_ms + ms));
+	timers.Insert(t, now_ms + ms);
 	again = true;
 }
 
@@ -113,12 +114,7 @@ EventLoop::CancelTimer(TimeoutMonitor &t)
 {
 	assert(IsInsideOrNull());
 
-	for (auto i = timers.begin(), end = timers.end(); i != end; ++i) {
-		if (&i->timer == &t) {
-			timers.erase(i);
-			return;
-		}
-	}
+	timers.Remove(t);
 }
 
 void
@@ -142,27 +138,16 @@ EventLoop::Run()
 
 		/* invoke timers */
 
-		int timeout_ms;
-		while (true) {
-			auto i = timers.begin();
-			if (i == timers.end()) {
-				timeout_ms = -1;
-				break;
-			}
-
-			timeout_ms = i->due_ms - now_ms;
-			if (timeout_ms > 0)
-				break;
-
-			TimeoutMonitor &m = i->timer;
-			timers.erase(i);
-
-			m.Run();
+		TimeoutMonitor *t;
+		while ((t = timers.PopDue(now_ms)) != nullptr) {
+			t->Run();
 
 			if (quit)
 				return;
 		}
 
+		const int timeout_ms = timers.GetTimeout();
+
 		/* invoke idle */
 
 		while (!idle.empty()) {
@@ -28,9 +28,9 @@
 #include "thread/Mutex.hxx"
 #include "WakeFD.hxx"
 #include "SocketMonitor.hxx"
+#include "TimerWheel.hxx"
 
 #include <list>
-#include <set>
 
 class TimeoutMonitor;
 class IdleMonitor;
@@ -50,31 +50,9 @@ class SocketMonitor;
  */
 class EventLoop final : SocketMonitor
 {
-	struct TimerRecord {
-		/**
-		 * Projected monotonic_clock_ms() value when this
-		 * timer is due.
-		 */
-		const unsigned due_ms;
-
-		TimeoutMonitor &timer;
-
-		constexpr TimerRecord(TimeoutMonitor &_timer,
-				      unsigned _due_ms)
-			:due_ms(_due_ms), timer(_timer) {}
-
-		bool operator<(const TimerRecord &other) const {
-			return due_ms < other.due_ms;
-		}
-
-		bool IsDue(unsigned _now_ms) const {
-			return _now_ms >= due_ms;
-		}
-	};
-
 	WakeFD wake_fd;
 
-	std::multiset<TimerRecord> timers;
+	TimerWheel timers;
 	std::list<IdleMonitor *> idle;
 
 	Mutex mutex;
@@ -22,7 +22,19 @@
 
 #include "check.h"
 
+#include <boost/intrusive/list_hook.hpp>
+
+#include <stdint.h>
+
 class EventLoop;
+class TimeoutMonitor;
+
+/**
+ * The hook which links a #TimeoutMonitor into a #TimerWheel slot.
+ * It is tagged, because subclasses may have their own list hooks.
+ */
+typedef boost::intrusive::list_base_hook<boost::intrusive::tag<TimeoutMonitor>,
+					 boost::intrusive::link_mode<boost::intrusive::auto_unlink>> TimeoutMonitorHook;
 
 /**
  * This class monitors a timeout.  Use Schedule() to begin the timeout
@@ -32,11 +44,23 @@ class EventLoop;
  * thread that runs the #EventLoop, except where explicitly documented
  * as thread-safe.
  */
-class TimeoutMonitor {
+class TimeoutMonitor : public TimeoutMonitorHook {
 	friend class EventLoop;
+	friend class TimerWheel;
 
 	EventLoop &loop;
 
+	/**
+	 * Projected MonotonicClockMS() value when this timer is due.
+	 * Only valid while #active.
+	 */
+	unsigned due_ms;
+
+	/**
+	 * The #TimerWheel level this object is linked into.
+	 */
+	uint8_t level;
+
 	bool active;
 
 public:
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "config.h"
+#include "TimerWheel.hxx"
+
+#include <algorithm>
+
+#include <assert.h>
+
+TimerWheel::TimerWheel(unsigned now_ms)
+	:current(now_ms)
+{
+	std::fill_n(counts, LEVELS, 0u);
+}
+
+bool
+TimerWheel::IsEmpty() const
+{
+	for (unsigned level = 0; level < LEVELS; ++level)
+		if (counts[level] > 0)
+			return false;
+
+	return true;
+}
+
+void
+TimerWheel::Insert(TimeoutMonitor &t, unsigned due_ms)
+{
+	assert(!t.is_linked());
+
+	t.due_ms = due_ms;
+
+	unsigned delta = due_ms - current;
+	unsigned slot_time = due_ms;
+	if (int(delta) < 0) {
+		/* already due: add to the slot being processed */
+		delta = 0;
+		slot_time = current;
+	}
+
+	unsigned level = 0;
+	while (level + 1 < LEVELS && delta >= GetSpan(level))
+		++level;
+
+	if (delta >= GetSpan(level))
+		/* too far away: park it in the last slot of the top
+		   level; it will be re-inserted from there */
+		slot_time = current + GetSpan(level) - 1;
+
+	t.level = level;
+	slots[level][(slot_time >> GetShift(level)) & GetMask(level)].push_back(t);
+	++counts[level];
+}
+
+void
+TimerWheel::Remove(TimeoutMonitor &t)
+{
+	assert(t.is_linked());
+	assert(t.level < LEVELS);
+	assert(counts[t.level] > 0);
+
+	t.unlink();
+	--counts[t.level];
+}
+
+void
+TimerWheel::Cascade(unsigned level, unsigned index)
+{
+	List &slot = slots[level][index];
+	while (!slot.empty()) {
+		TimeoutMonitor &t = slot.front();
+		slot.pop_front();
+		--counts[level];
+
+		Insert(t, t.due_ms);
+	}
+}
+
+void
+TimerWheel::Advance()
+{
+	++current;
+
+	for (unsigned level = 1; level < LEVELS; ++level) {
+		const unsigned shift = GetShift(level);
+		if ((current & ((1u << shift) - 1)) != 0)
+			/* not at a slot boundary of this level */
+			break;
+
+		Cascade(level, (current >> shift) & GetMask(level));
+	}
+}
+
+TimeoutMonitor *
+TimerWheel::PopDue(unsigned now_ms)
+{
+	while (true) {
+		List &slot = slots[0][current & GetMask(0)];
+		if (!slot.empty()) {
+			TimeoutMonitor &t = slot.front();
+			slot.pop_front();
+			--counts[0];
+			return &t;
+		}
+
+		if (int(now_ms - current) <= 0)
+			return nullptr;
+
+		if (counts[0] > 0) {
+			Advance();
+			continue;
+		}
+
+		/* level 0 is empty: skip to the next slot boundary of
+		   the lowest level which contains timers */
+
+		unsigned level = 1;
+		while (level < LEVELS && counts[level] == 0)
+			++level;
+
+		if (level == LEVELS) {
+			/* no timers at all */
+			current = now_ms;
+			return nullptr;
+		}
+
+		const unsigned next = (current | ((1u << GetShift(level)) - 1)) + 1;
+		if (int(next - now_ms) > 0) {
+			current = now_ms;
+			return nullptr;
+		}
+
+		current = next - 1;
+		Advance();
+	}
+}
+
+int
+TimerWheel::GetTimeout() const
+{
+	int timeout = -1;
+
+	if (counts[0] > 0) {
+		for (unsigned k = 0; k < LEVEL0_SIZE; ++k) {
+			if (!slots[0][(current + k) & GetMask(0)].empty()) {
+				timeout = k;
+				break;
+			}
+		}
+
+		assert(timeout >= 0);
+
+		if (timeout == 0)
+			return 0;
+	}
+
+	/* a higher level may need to be cascaded before the next
+	   level 0 timer is due */
+
+	for (unsigned level = 1; level < LEVELS; ++level) {
+		if (counts[level] == 0)
+			continue;
+
+		const unsigned shift = GetShift(level);
+		const unsigned mask = GetMask(level);
+		const unsigned index = current >> shift;
+
+		for (unsigned k = 1; k <= mask + 1; ++k) {
+			if (!slots[level][(index + k) & mask].empty()) {
+				/* this slot will be cascaded when the
+				   clock reaches its start */
+				const int t = ((index + k) << shift) - current;
+				if (timeout < 0 || t < timeout)
+					timeout = t;
+				break;
+			}
+		}
+	}
+
+	return timeout;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MPD_TIMER_WHEEL_HXX
+#define MPD_TIMER_WHEEL_HXX
+
+#include "check.h"
+#include "TimeoutMonitor.hxx"
+#include "Compiler.h"
+
+#include <boost/intrusive/list.hpp>
+
+/**
+ * A hierarchical timer wheel which manages #TimeoutMonitor
+ * instances.  Inserting and removing a timer costs O(1); timers are
+ * moved to a lower level ("cascaded") when their time comes closer.
+ *
+ * Level 0 has one slot per millisecond and covers 256 ms; each of
+ * the higher levels has 64 slots, each as wide as a full revolution
+ * of the level below.  Timers which are farther away than the top
+ * level covers are parked in its last slot and re-inserted later.
+ *
+ * This class is not thread-safe.
+ */
+class TimerWheel {
+	static constexpr unsigned LEVELS = 4;
+
+	static constexpr unsigned LEVEL0_BITS = 8;
+	static constexpr unsigned LEVEL_BITS = 6;
+
+	static constexpr unsigned LEVEL0_SIZE = 1u << LEVEL0_BITS;
+
+	typedef boost::intrusive::list<TimeoutMonitor,
+				       boost::intrusive::base_hook<TimeoutMonitorHook>,
+				       boost::intrusive::constant_time_size<false>> List;
+
+	/**
+	 * The slots of all levels.  Level 0 uses all #LEVEL0_SIZE
+	 * slots, the others only the first (1 << #LEVEL_BITS).
+	 */
+	List slots[LEVELS][LEVEL0_SIZE];
+
+	/**
+	 * The number of timers in each level.
+	 */
+	unsigned counts[LEVELS];
+
+	/**
+	 * The time [MonotonicClockMS()] of the slot being processed.
+	 * All timers which were due before this have been returned
+	 * by PopDue().
+	 */
+	unsigned current;
+
+public:
+	explicit TimerWheel(unsigned now_ms);
+
+	~TimerWheel() {
+		assert(IsEmpty());
+	}
+
+	TimerWheel(const TimerWheel &) = delete;
+	TimerWheel &operator=(const TimerWheel &) = delete;
+
+	gcc_pure
+	bool IsEmpty() const;
+
+	void Insert(TimeoutMonitor &t, unsigned due_ms);
+
+	void Remove(TimeoutMonitor &t);
+
+	/**
+	 * Remove and return the next timer which is due at the
+	 * specified time.
+	 *
+	 * @return the timer or nullptr if no timer is due
+	 */
+	TimeoutMonitor *PopDue(unsigned now_ms);
+
+	/**
+	 * Determine how long the caller may sleep until the next
+	 * call to PopDue().  This may be earlier than the next timer
+	 * is due, because timers on the higher levels need to be
+	 * cascaded; it is never later than the next timer.  Call
+	 * this after PopDue() has returned nullptr.
+	 *
+	 * @return the timeout in milliseconds, or -1 if there are
+	 * no timers
+	 */
+	gcc_pure
+	int GetTimeout() const;
+
+private:
+	static constexpr unsigned GetShift(unsigned level) {
+		return level == 0
+			? 0
+			: LEVEL0_BITS + (level - 1) * LEVEL_BITS;
+	}
+
+	static constexpr unsigned GetMask(unsigned level) {
+		return level == 0
+			? LEVEL0_SIZE - 1
+			: (1u << LEVEL_BITS) - 1;
+	}
+
+	/**
+	 * The maximum distance (exclusive) of a timer in the given
+	 * level from #current.
+	 */
+	static constexpr unsigned GetSpan(unsigned level) {
+		return 1u << (LEVEL0_BITS + level * LEVEL_BITS);
+	}
+
+	/**
+	 * Move to the next millisecond, and cascade higher levels
+	 * whose slot boundary has been reached.
+	 */
+	void Advance();
+
+	/**
+	 * Re-insert all timers of the specified slot.
+	 */
+	void Cascade(unsigned level, unsigned index);
+};
+
+#endif
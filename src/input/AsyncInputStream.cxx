@@ -23,31 +23,218 @@
 #include "event/Call.hxx"
 #include "thread/Cond.hxx"
 #include "IOThread.hxx"
+#include "config/ConfigData.hxx"
+#include "system/Clock.hxx"
 #include "util/HugeAllocator.hxx"
+#include "util/Domain.hxx"
+#include "Log.hxx"
 
 #include <assert.h>
 #include <string.h>
 
+static constexpr Domain async_input_domain("async_input");
+
+/**
+ * The length of the window used to measure the consumer's data rate
+ * [ms].
+ */
+static constexpr unsigned READ_RATE_WINDOW_MS = 1000;
+
+/**
+ * The adaptive buffer shall be able to bridge this many times the
+ * longest recently observed stall.
+ */
+static constexpr unsigned STALL_SAFETY_FACTOR = 2;
+
+typedef boost::intrusive::list<AsyncInputStream,
+			       boost::intrusive::constant_time_size<false>> AsyncInputStreamList;
+
+/**
+ * All #AsyncInputStream instances, for VisitStats().  Protected by
+ * #async_input_streams_mutex.
+ */
+static AsyncInputStreamList async_input_streams;
+static Mutex async_input_streams_mutex;
+
+bool
+AsyncInputStreamConfig::Configure(const config_param &param, Error &error)
+{
+	buffer_size = param.GetBlockValue("buffer_size",
+					  unsigned(buffer_size / 1024)) * 1024;
+	if (buffer_size < 16 * 1024) {
+		error.Format(async_input_domain,
+			     "buffer_size is too small in line %d",
+			     param.line);
+		return false;
+	}
+
+	high_watermark = param.GetBlockValue("high_watermark",
+					     high_watermark);
+	low_watermark = param.GetBlockValue("low_watermark", low_watermark);
+	if (high_watermark > 100 || low_watermark >= high_watermark) {
+		error.Format(async_input_domain,
+			     "Invalid buffer watermarks in line %d",
+			     param.line);
+		return false;
+	}
+
+	if (param.GetBlockValue("adaptive_buffer", false)) {
+		max_buffer_size = param.GetBlockValue("max_buffer_size",
+						      8192u) * 1024;
+		if (max_buffer_size <= buffer_size) {
+			error.Format(async_input_domain,
+				     "max_buffer_size must be larger than buffer_size in line %d",
+				     param.line);
+			return false;
+		}
+	} else
+		max_buffer_size = 0;
+
+	return true;
+}
+
 AsyncInputStream::AsyncInputStream(const char *_url,
 				   Mutex &_mutex, Cond &_cond,
-				   void *_buffer, size_t _buffer_size,
-				   size_t _resume_at)
+				   void *_buffer,
+				   const AsyncInputStreamConfig &_config)
 	:InputStream(_url, _mutex, _cond), DeferredMonitor(io_thread_get()),
-	 buffer((uint8_t *)_buffer, _buffer_size),
-	 resume_at(_resume_at),
+	 config(_config),
+	 buffer((uint8_t *)_buffer, _config.buffer_size),
+	 grow_to(0),
+	 last_append_ms(0), stall_ms(0),
+	 read_window_start_ms(0), read_window_bytes(0), read_rate(0),
+	 stats_capacity(_config.buffer_size), stats_fill(0),
+	 stats_underruns(0),
 	 open(true),
 	 paused(false),
 	 seek_state(SeekState::NONE),
-	 tag(nullptr) {}
+	 tag(nullptr)
+{
+	UpdateWatermarks();
+
+	const ScopeLock protect(async_input_streams_mutex);
+	async_input_streams.push_back(*this);
+}
 
 AsyncInputStream::~AsyncInputStream()
 {
+	{
+		const ScopeLock protect(async_input_streams_mutex);
+		async_input_streams.erase(async_input_streams.iterator_to(*this));
+	}
+
 	delete tag;
 
 	buffer.Clear();
 	HugeFree(buffer.Write().data, buffer.GetCapacity());
 }
 
+void
+AsyncInputStream::VisitStats(std::function<void(const AsyncInputStreamStats &)> f)
+{
+	AsyncInputStreamStats stats;
+
+	const ScopeLock protect(async_input_streams_mutex);
+	for (const auto &i : async_input_streams) {
+		stats.uri = i.GetURI();
+		stats.buffer_size = i.stats_capacity.load(std::memory_order_relaxed);
+		stats.buffer_fill = i.stats_fill.load(std::memory_order_relaxed);
+		stats.underruns = i.stats_underruns.load(std::memory_order_relaxed);
+		f(stats);
+	}
+}
+
+void
+AsyncInputStream::UpdateWatermarks()
+{
+	const size_t capacity = buffer.GetCapacity();
+
+	/* one cell of the CircularBuffer cannot be used */
+	pause_at = std::min(capacity / 100 * config.high_watermark,
+			    capacity - 1);
+	resume_at = capacity / 100 * config.low_watermark;
+}
+
+inline void
+AsyncInputStream::ScheduleGrow(size_t new_capacity)
+{
+	new_capacity = std::min(new_capacity, config.max_buffer_size);
+	if (new_capacity <= buffer.GetCapacity() || new_capacity <= grow_to)
+		return;
+
+	grow_to = new_capacity;
+	DeferredMonitor::Schedule();
+}
+
+void
+AsyncInputStream::Grow(size_t new_capacity)
+{
+	assert(io_thread_inside());
+
+	/* allocate outside of the mutex, this may be expensive */
+	void *new_data = HugeAllocate(new_capacity);
+	if (new_data == nullptr)
+		return;
+
+	const ScopeLock protect(mutex);
+
+	const size_t old_capacity = buffer.GetCapacity();
+	if (new_capacity <= old_capacity || seek_state != SeekState::NONE) {
+		HugeFree(new_data, new_capacity);
+		return;
+	}
+
+	uint8_t *old_data = buffer.Relocate((uint8_t *)new_data, new_capacity);
+	HugeFree(old_data, old_capacity);
+
+	UpdateWatermarks();
+	stats_capacity.store(new_capacity, std::memory_order_relaxed);
+
+	FormatDebug(async_input_domain, "Buffer of %s grown to %zu kB",
+		    GetURI(), new_capacity / 1024);
+}
+
+inline void
+AsyncInputStream::UpdateReadRate(size_t nbytes)
+{
+	const unsigned now = MonotonicClockMS();
+	if (read_window_start_ms == 0) {
+		read_window_start_ms = now;
+		read_window_bytes = 0;
+		return;
+	}
+
+	read_window_bytes += nbytes;
+
+	const unsigned elapsed = now - read_window_start_ms;
+	if (elapsed < READ_RATE_WINDOW_MS)
+		return;
+
+	const size_t rate = uint64_t(read_window_bytes) * 1000 / elapsed;
+	read_rate = read_rate == 0
+		? rate
+		: (read_rate * 3 + rate) / 4;
+
+	read_window_start_ms = now;
+	read_window_bytes = 0;
+
+	if (config.IsAdaptive()) {
+		/* the buffer must be large enough to bridge the
+		   longest recent stall of the producer */
+		const size_t wanted = uint64_t(read_rate) * stall_ms
+			* STALL_SAFETY_FACTOR / 1000;
+		if (wanted > pause_at) {
+			size_t new_capacity = buffer.GetCapacity();
+			while (new_capacity < wanted)
+				new_capacity *= 2;
+			ScheduleGrow(new_capacity);
+		}
+	}
+
+	/* let old stalls fade out */
+	stall_ms -= stall_ms / 8;
+}
+
 void
 AsyncInputStream::SetTag(Tag *_tag)
 {
@@ -61,6 +248,7 @@ AsyncInputStream::Pause()
 	assert(io_thread_inside());
 
 	paused = true;
+	last_append_ms = 0;
 }
 
 void
@@ -100,24 +288,15 @@ bool
 AsyncInputStream::IsEOF()
 {
 	return (KnownSize() && offset >= size) ||
-		(!open && buffer.IsEmpty());
+		(seek_state == SeekState::NONE &&
+		 !open && buffer.IsEmpty());
 }
 
-bool
-AsyncInputStream::Seek(offset_type new_offset, Error &error)
+inline bool
+AsyncInputStream::FastForward(offset_type new_offset)
 {
-	assert(IsReady());
 	assert(seek_state == SeekState::NONE);
 
-	if (new_offset == offset)
-		/* no-op */
-		return true;
-
-	if (!IsSeekable())
-		return false;
-
-	/* check if we can fast-forward the buffer */
-
 	while (new_offset > offset) {
 		auto r = buffer.Read();
 		if (r.IsEmpty())
@@ -132,7 +311,30 @@ AsyncInputStream::Seek(offset_type new_offset, Error &error)
 		offset += nbytes;
 	}
 
+	UpdateFillStats();
+
+	return new_offset == offset;
+}
+
+bool
+AsyncInputStream::Seek(offset_type new_offset, Error &error)
+{
+	assert(IsReady());
+
+	/* finish a seek started by SeekAsync() first */
+	while (seek_state != SeekState::NONE)
+		cond.wait(mutex);
+
 	if (new_offset == offset)
+		/* no-op */
+		return true;
+
+	if (!IsSeekable())
+		return false;
+
+	/* check if we can fast-forward the buffer */
+
+	if (FastForward(new_offset))
 		return true;
 
 	/* no: ask the implementation to seek */
@@ -151,6 +353,40 @@ AsyncInputStream::Seek(offset_type new_offset, Error &error)
 	return true;
 }
 
+bool
+AsyncInputStream::SeekAsync(offset_type new_offset)
+{
+	assert(IsReady());
+
+	if (seek_state == SeekState::SCHEDULED) {
+		/* not yet started: change the destination */
+		seek_offset = offset = new_offset;
+		return true;
+	}
+
+	if (seek_state != SeekState::NONE)
+		/* already talking to the server */
+		return false;
+
+	if (new_offset == offset)
+		return true;
+
+	if (!IsSeekable())
+		return false;
+
+	if (FastForward(new_offset))
+		return true;
+
+	/* the implementation sets the same offset in DoSeek(); it is
+	   set here already, so GetOffset() shows where the stream is
+	   heading */
+	seek_offset = offset = new_offset;
+	seek_state = SeekState::SCHEDULED;
+
+	DeferredMonitor::Schedule();
+	return true;
+}
+
 void
 AsyncInputStream::SeekDone()
 {
@@ -174,7 +410,7 @@ AsyncInputStream::IsAvailable()
 {
 	return postponed_error.IsDefined() ||
 		IsEOF() ||
-		!buffer.IsEmpty();
+		(seek_state == SeekState::NONE && !buffer.IsEmpty());
 }
 
 size_t
@@ -184,13 +420,28 @@ AsyncInputStream::Read(void *ptr, size_t read_size, Error &error)
 
 	/* wait for data */
 	CircularBuffer<uint8_t>::Range r;
+	bool underrun = false;
 	while (true) {
 		if (!Check(error))
 			return 0;
 
-		r = buffer.Read();
-		if (!r.IsEmpty() || IsEOF())
-			break;
+		/* the buffer belongs to the old position until a
+		   seek started by SeekAsync() is finished */
+		if (seek_state == SeekState::NONE) {
+			r = buffer.Read();
+			if (!r.IsEmpty() || IsEOF())
+				break;
+		}
+
+		if (!underrun && seek_state == SeekState::NONE && !paused) {
+			underrun = true;
+
+			/* the producer didn't keep up */
+			stats_underruns.fetch_add(1, std::memory_order_relaxed);
+
+			if (config.IsAdaptive())
+				ScheduleGrow(buffer.GetCapacity() * 2);
+		}
 
 		cond.wait(mutex);
 	}
@@ -198,9 +449,12 @@ AsyncInputStream::Read(void *ptr, size_t read_size, Error &error)
 	const size_t nbytes = std::min(read_size, r.size);
 	memcpy(ptr, r.data, nbytes);
 	buffer.Consume(nbytes);
+	UpdateFillStats();
 
 	offset += (offset_type)nbytes;
 
+	UpdateReadRate(nbytes);
+
 	if (paused && buffer.GetSize() < resume_at)
 		DeferredMonitor::Schedule();
 
@@ -227,6 +481,13 @@ AsyncInputStream::AppendToBuffer(const void *data, size_t append_size)
 		buffer.Append(remaining);
 	}
 
+	UpdateFillStats();
+
+	const unsigned now = MonotonicClockMS();
+	if (last_append_ms != 0 && !paused)
+		stall_ms = std::max(stall_ms, now - last_append_ms);
+	last_append_ms = now;
+
 	if (!IsReady())
 		SetReady();
 	else
@@ -236,14 +497,27 @@ AsyncInputStream::AppendToBuffer(const void *data, size_t append_size)
 void
 AsyncInputStream::RunDeferred()
 {
+	mutex.lock();
+	const size_t new_capacity = grow_to;
+	grow_to = 0;
+	mutex.unlock();
+
+	if (new_capacity > 0)
+		Grow(new_capacity);
+
 	const ScopeLock protect(mutex);
 
-	Resume();
+	if (new_capacity == 0 || buffer.GetSize() < resume_at ||
+	    seek_state == SeekState::SCHEDULED)
+		Resume();
 
 	if (seek_state == SeekState::SCHEDULED) {
 		seek_state = SeekState::PENDING;
 		buffer.Clear();
+		UpdateFillStats();
 		paused = false;
+		last_append_ms = 0;
+		read_window_start_ms = 0;
 		DoSeek(seek_offset);
 	}
 }
@@ -25,19 +25,143 @@
 #include "util/CircularBuffer.hxx"
 #include "util/Error.hxx"
 
+#include <boost/intrusive/list.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <string>
+
+struct config_param;
+
+/**
+ * Buffer settings for an #AsyncInputStream.  Each plugin has its own
+ * defaults, which may be overridden in its "input" block.
+ */
+struct AsyncInputStreamConfig {
+	/**
+	 * The initial buffer size in bytes.
+	 */
+	size_t buffer_size;
+
+	/**
+	 * Pause the stream when the buffer is filled above this
+	 * percentage.
+	 */
+	unsigned high_watermark;
+
+	/**
+	 * Resume the stream when the buffer has drained below this
+	 * percentage.
+	 */
+	unsigned low_watermark;
+
+	/**
+	 * The maximum buffer size in bytes the adaptive mode may grow
+	 * to.  If this is not larger than #buffer_size, the buffer
+	 * size is fixed.
+	 */
+	size_t max_buffer_size;
+
+	constexpr AsyncInputStreamConfig(size_t _buffer_size,
+					 unsigned _low_watermark)
+		:buffer_size(_buffer_size),
+		 high_watermark(100), low_watermark(_low_watermark),
+		 max_buffer_size(0) {}
+
+	/**
+	 * Load settings from the plugin's configuration block.
+	 */
+	bool Configure(const config_param &param, Error &error);
+
+	bool IsAdaptive() const {
+		return max_buffer_size > buffer_size;
+	}
+};
+
+/**
+ * A snapshot of an #AsyncInputStream's buffer state, see
+ * AsyncInputStream::VisitStats().
+ */
+struct AsyncInputStreamStats {
+	std::string uri;
+
+	size_t buffer_size;
+
+	size_t buffer_fill;
+
+	/**
+	 * How often did a reader find the buffer empty and had to
+	 * wait?
+	 */
+	unsigned underruns;
+};
+
 /**
  * Helper class for moving asynchronous (non-blocking) InputStream
  * implementations to the I/O thread.  Data is being read into a ring
  * buffer, and that buffer is then consumed by another thread using
  * the regular #InputStream API.
  */
-class AsyncInputStream : public InputStream, private DeferredMonitor {
+class AsyncInputStream
+	: public InputStream, private DeferredMonitor,
+	  public boost::intrusive::list_base_hook<boost::intrusive::link_mode<boost::intrusive::normal_link>> {
 	enum class SeekState : uint8_t {
 		NONE, SCHEDULED, PENDING
 	};
 
+	const AsyncInputStreamConfig config;
+
 	CircularBuffer<uint8_t> buffer;
-	const size_t resume_at;
+
+	/**
+	 * Pause the stream when the buffer contains more than this
+	 * number of bytes.  Derived from the buffer capacity and
+	 * AsyncInputStreamConfig::high_watermark.
+	 */
+	size_t pause_at;
+
+	/**
+	 * Resume the stream when the buffer contains less than this
+	 * number of bytes.
+	 */
+	size_t resume_at;
+
+	/**
+	 * If non-zero, the buffer shall be grown to this size by the
+	 * I/O thread.
+	 */
+	size_t grow_to;
+
+	/**
+	 * The time stamp [MonotonicClockMS()] of the last
+	 * AppendToBuffer() call, or 0 if the next call shall not be
+	 * used to measure the gap (e.g. after pausing).
+	 */
+	unsigned last_append_ms;
+
+	/**
+	 * The longest gap between two AppendToBuffer() calls while
+	 * the stream was not paused.  This slowly decays.
+	 */
+	unsigned stall_ms;
+
+	/**
+	 * Measurement window for the consumer's data rate.
+	 */
+	unsigned read_window_start_ms;
+	size_t read_window_bytes;
+
+	/**
+	 * The consumer's data rate [bytes per second], averaged over
+	 * the past few windows.
+	 */
+	size_t read_rate;
+
+	/* statistics which may be read without holding the mutex, see
+	   VisitStats() */
+	std::atomic_size_t stats_capacity, stats_fill;
+	std::atomic_uint stats_underruns;
 
 	bool open;
 
@@ -62,17 +186,29 @@ protected:
 	Error postponed_error;
 
 public:
+	/**
+	 * @param _buffer a buffer allocated with HugeAllocate() of
+	 * the size specified in the #AsyncInputStreamConfig; this
+	 * object takes over ownership
+	 */
 	AsyncInputStream(const char *_url,
 			 Mutex &_mutex, Cond &_cond,
-			 void *_buffer, size_t _buffer_size,
-			 size_t _resume_at);
+			 void *_buffer, const AsyncInputStreamConfig &_config);
 
 	virtual ~AsyncInputStream();
 
+	/**
+	 * Invoke the given function with the buffer statistics of
+	 * each #AsyncInputStream instance.  This method is
+	 * thread-safe.
+	 */
+	static void VisitStats(std::function<void(const AsyncInputStreamStats &)> f);
+
 	/* virtual methods from InputStream */
 	bool Check(Error &error) final;
 	bool IsEOF() final;
 	bool Seek(offset_type new_offset, Error &error) final;
+	bool SeekAsync(offset_type new_offset) final;
 	Tag *ReadTag() final;
 	bool IsAvailable() final;
 	size_t Read(void *ptr, size_t read_size, Error &error) final;
@@ -112,11 +248,16 @@ protected:
 	}
 
 	/**
-	 * Determine how many bytes can be added to the buffer.
+	 * Determine how many bytes can be added to the buffer before
+	 * the high watermark is reached.
 	 */
 	gcc_pure
 	size_t GetBufferSpace() const {
-		return buffer.GetSpace();
+		const size_t fill = buffer.GetSize();
+		const size_t space = buffer.GetSpace();
+		return fill >= pause_at
+			? 0
+			: std::min(space, pause_at - fill);
 	}
 
 	/**
@@ -151,6 +292,37 @@ protected:
 private:
 	void Resume();
 
+	/**
+	 * Skip buffered data up to the given offset.
+	 *
+	 * @return true if the offset was reached
+	 */
+	bool FastForward(offset_type new_offset);
+
+	void UpdateWatermarks();
+
+	/**
+	 * Update the consumer data rate after Read() has consumed
+	 * data, and decide whether the buffer should grow.
+	 */
+	void UpdateReadRate(size_t nbytes);
+
+	/**
+	 * Ask the I/O thread to grow the buffer to the given size
+	 * (clipped to the configured maximum).
+	 */
+	void ScheduleGrow(size_t new_capacity);
+
+	/**
+	 * Called by the I/O thread to replace the buffer with a
+	 * larger one.  The mutex must not be locked.
+	 */
+	void Grow(size_t new_capacity);
+
+	void UpdateFillStats() {
+		stats_fill.store(buffer.GetSize(), std::memory_order_relaxed);
+	}
+
 	/* virtual methods from DeferredMonitor */
 	void RunDeferred() final;
 };
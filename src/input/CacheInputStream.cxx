@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "CacheInputStream.hxx"
+#include "InputCache.hxx"
+#include "util/Error.hxx"
+#include "util/Domain.hxx"
+#include "Log.hxx"
+
+#include <assert.h>
+#include <unistd.h>
+
+static constexpr Domain cache_input_domain("cache_input");
+
+CompleteCacheInputStream::CompleteCacheInputStream(InputCache &_cache,
+						   InputCacheEntry &_entry,
+						   int _fd,
+						   Mutex &_mutex, Cond &_cond)
+	:InputStream(_entry.uri.c_str(), _mutex, _cond),
+	 cache(_cache), entry(_entry), fd(_fd)
+{
+	if (!entry.mime.empty())
+		SetMimeType(entry.mime.c_str());
+
+	if (!entry.etag.empty())
+		SetETag(std::string(entry.etag));
+
+	if (!entry.last_modified.empty())
+		SetLastModified(std::string(entry.last_modified));
+
+	size = entry.size;
+	seekable = true;
+	SetReady();
+}
+
+CompleteCacheInputStream::~CompleteCacheInputStream()
+{
+	cache.Release(entry, fd);
+}
+
+bool
+CompleteCacheInputStream::IsEOF()
+{
+	return offset >= size;
+}
+
+bool
+CompleteCacheInputStream::Seek(offset_type new_offset, Error &error)
+{
+	if (new_offset > size) {
+		error.Set(cache_input_domain, "Seek beyond end of file");
+		return false;
+	}
+
+	offset = new_offset;
+	return true;
+}
+
+size_t
+CompleteCacheInputStream::Read(void *ptr, size_t read_size, Error &error)
+{
+	ssize_t nbytes = pread(fd, ptr, read_size, offset);
+	if (nbytes < 0) {
+		error.SetErrno("Failed to read from cache");
+		return 0;
+	}
+
+	offset += nbytes;
+	return (size_t)nbytes;
+}
+
+CachingInputStream::CachingInputStream(InputCache &_cache,
+				       InputStream *_input)
+	:ProxyInputStream(_input),
+	 cache(_cache), entry(nullptr), fd(-1), writing(false)
+{
+	if (input.IsReady())
+		Update();
+}
+
+CachingInputStream::~CachingInputStream()
+{
+	if (entry != nullptr) {
+		if (writing)
+			cache.EndWrite(*entry);
+
+		cache.Release(*entry, fd);
+	}
+}
+
+inline void
+CachingInputStream::OnReady()
+{
+	assert(input.IsReady());
+	assert(!IsReady());
+
+	CopyAttributes();
+
+	if (!input.KnownSize() || !input.IsSeekable() ||
+	    input.GetOffset() != 0)
+		/* pass through */
+		return;
+
+	entry = cache.Acquire(GetURI(), input.GetSize(),
+			      input.GetMimeType(),
+			      input.GetETag(), input.GetLastModified(),
+			      fd);
+	if (entry != nullptr)
+		writing = cache.BeginWrite(*entry);
+}
+
+void
+CachingInputStream::Update()
+{
+	if (IsReady()) {
+		if (entry == nullptr)
+			ProxyInputStream::Update();
+		return;
+	}
+
+	input.Update();
+	if (input.IsReady())
+		OnReady();
+}
+
+bool
+CachingInputStream::Seek(offset_type new_offset, Error &error)
+{
+	if (entry == nullptr)
+		return ProxyInputStream::Seek(new_offset, error);
+
+	if (new_offset > size) {
+		error.Set(cache_input_domain, "Seek beyond end of file");
+		return false;
+	}
+
+	/* the underlying stream will be moved only when we need
+	   data which is not in the cache */
+	offset = new_offset;
+	return true;
+}
+
+bool
+CachingInputStream::IsEOF()
+{
+	if (entry == nullptr)
+		return ProxyInputStream::IsEOF();
+
+	return offset >= size;
+}
+
+bool
+CachingInputStream::IsAvailable()
+{
+	if (entry == nullptr)
+		return ProxyInputStream::IsAvailable();
+
+	if (cache.GetAvailable(*entry, offset) > 0)
+		return true;
+
+	/* don't let Read() seek the underlying stream, because that
+	   would block while the server responds; seek in the
+	   background and report "available" when the data arrives */
+	if (input.GetOffset() != offset && !input.SeekAsync(offset))
+		/* a blocking stream; its Read() blocks anyway */
+		return true;
+
+	return input.IsAvailable();
+}
+
+inline size_t
+CachingInputStream::ReadFromInput(void *ptr, size_t read_size, Error &error)
+{
+	if (input.GetOffset() != offset && !input.Seek(offset, error))
+		return 0;
+
+	size_t nbytes = input.Read(ptr, read_size, error);
+	if (nbytes == 0 || !writing)
+		return nbytes;
+
+	if (pwrite(fd, ptr, nbytes, offset) != (ssize_t)nbytes) {
+		FormatErrno(cache_input_domain,
+			    "Failed to write to cache file");
+		cache.EndWrite(*entry);
+		writing = false;
+	} else if (!cache.Written(*entry, offset, offset + nbytes))
+		writing = false;
+
+	return nbytes;
+}
+
+size_t
+CachingInputStream::Read(void *ptr, size_t read_size, Error &error)
+{
+	if (entry == nullptr)
+		return ProxyInputStream::Read(ptr, read_size, error);
+
+	size_t nbytes;
+
+	const size_t available = cache.GetAvailable(*entry, offset);
+	if (available > 0) {
+		if (read_size > available)
+			read_size = available;
+
+		ssize_t result = pread(fd, ptr, read_size, offset);
+		if (result < 0) {
+			error.SetErrno("Failed to read from cache");
+			return 0;
+		}
+
+		nbytes = result;
+	} else
+		nbytes = ReadFromInput(ptr, read_size, error);
+
+	offset += nbytes;
+	return nbytes;
+}
+
+InputStream *
+input_cache_open(const char *uri, Mutex &mutex, Cond &cond)
+{
+	if (input_cache == nullptr || !InputCache::IsCacheable(uri))
+		return nullptr;
+
+	InputStream *is = input_cache->OpenComplete(uri, mutex, cond);
+	if (is != nullptr)
+		FormatDebug(cache_input_domain, "Cache hit: %s", uri);
+
+	return is;
+}
+
+InputStream *
+input_cache_wrap(InputStream *is)
+{
+	assert(is != nullptr);
+
+	if (input_cache == nullptr || !InputCache::IsCacheable(is->GetURI()))
+		return is;
+
+	return new CachingInputStream(*input_cache, is);
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_CACHE_INPUT_STREAM_HXX
+#define MPD_CACHE_INPUT_STREAM_HXX
+
+#include "check.h"
+#include "ProxyInputStream.hxx"
+
+class InputCache;
+struct InputCacheEntry;
+
+/**
+ * Reads a file which is completely present in the #InputCache; the
+ * server is not contacted.
+ */
+class CompleteCacheInputStream final : public InputStream {
+	InputCache &cache;
+	InputCacheEntry &entry;
+	const int fd;
+
+public:
+	CompleteCacheInputStream(InputCache &_cache, InputCacheEntry &_entry,
+				 int _fd, Mutex &_mutex, Cond &_cond);
+	~CompleteCacheInputStream();
+
+	/* virtual methods from InputStream */
+	bool IsEOF() override;
+	bool Seek(offset_type new_offset, Error &error) override;
+	size_t Read(void *ptr, size_t read_size, Error &error) override;
+};
+
+/**
+ * Wraps a remote #InputStream.  Data which was read before is served
+ * from the #InputCache, and new data is added to it.  Seeking is
+ * deferred until data which is not in the cache is needed.
+ *
+ * Streams with an unknown size or which cannot seek are passed
+ * through.
+ */
+class CachingInputStream final : public ProxyInputStream {
+	InputCache &cache;
+
+	/**
+	 * The cache entry; nullptr if the stream is passed through
+	 * (or if it is not yet ready).
+	 */
+	InputCacheEntry *entry;
+
+	int fd;
+
+	/**
+	 * Is this object adding data to the #entry?
+	 */
+	bool writing;
+
+public:
+	CachingInputStream(InputCache &_cache, InputStream *_input);
+	~CachingInputStream();
+
+	/* virtual methods from InputStream */
+	void Update() override;
+	bool Seek(offset_type new_offset, Error &error) override;
+	bool IsEOF() override;
+	bool IsAvailable() override;
+	size_t Read(void *ptr, size_t read_size, Error &error) override;
+
+private:
+	/**
+	 * Called when the underlying stream has become ready.
+	 */
+	void OnReady();
+
+	size_t ReadFromInput(void *ptr, size_t read_size, Error &error);
+};
+
+/**
+ * Open a completely cached file, if the cache is enabled.
+ *
+ * @return nullptr if the file is not in the cache
+ */
+InputStream *
+input_cache_open(const char *uri, Mutex &mutex, Cond &cond);
+
+/**
+ * Wrap a newly opened #InputStream in a #CachingInputStream if the
+ * cache is enabled and the URI is eligible.
+ */
+InputStream *
+input_cache_wrap(InputStream *is);
+
+#endif
@@ -27,12 +27,21 @@
 #include "config/ConfigData.hxx"
 #include "Log.hxx"
 
+#ifndef WIN32
+#include "InputCache.hxx"
+#endif
+
 #include <assert.h>
 #include <string.h>
 
 bool
 input_stream_global_init(Error &error)
 {
+#ifndef WIN32
+	if (!input_cache_global_init(error))
+		return false;
+#endif
+
 	const config_param empty;
 
 	for (unsigned i = 0; input_plugins[i] != nullptr; ++i) {
@@ -84,4 +93,8 @@ void input_stream_global_finish(void)
 	input_plugins_for_each_enabled(plugin)
 		if (plugin->finish != nullptr)
 			plugin->finish();
+
+#ifndef WIN32
+	input_cache_global_finish();
+#endif
 }
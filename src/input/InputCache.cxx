@@ -0,0 +1,592 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "InputCache.hxx"
+#include "CacheInputStream.hxx"
+#include "config/ConfigGlobal.hxx"
+#include "config/ConfigOption.hxx"
+#include "fs/FileSystem.hxx"
+#include "fs/io/TextFile.hxx"
+#include "fs/io/FileOutputStream.hxx"
+#include "fs/io/BufferedOutputStream.hxx"
+#include "system/fd_util.h"
+#include "event/DeferredMonitor.hxx"
+#include "event/TimeoutMonitor.hxx"
+#include "event/Call.hxx"
+#include "IOThread.hxx"
+#include "util/StringUtil.hxx"
+#include "util/Error.hxx"
+#include "util/Domain.hxx"
+#include "Log.hxx"
+
+#include <algorithm>
+#include <iterator>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define INDEX_NAME "index"
+
+static constexpr Domain input_cache_domain("input_cache");
+
+/**
+ * The default value for "input_cache_size" [MB].
+ */
+static constexpr unsigned DEFAULT_INPUT_CACHE_SIZE = 256;
+
+/**
+ * The default value for "input_cache_ttl" [seconds].
+ */
+static constexpr unsigned DEFAULT_INPUT_CACHE_TTL = 3600;
+
+/**
+ * How long [seconds] after a modification is the index saved?
+ */
+static constexpr unsigned INPUT_CACHE_SAVE_DELAY = 60;
+
+InputCache *input_cache;
+
+bool
+InputCacheEntry::Matches(offset_type _size, const char *_etag,
+			 const char *_last_modified) const
+{
+	/* without validators from the server, the size is all we
+	   can compare */
+	return _size == size &&
+		(_etag == nullptr || etag == _etag) &&
+		(_last_modified == nullptr ||
+		 last_modified == _last_modified);
+}
+
+size_t
+InputCacheEntry::GetAvailable(offset_type offset) const
+{
+	auto i = ranges.upper_bound(offset);
+	if (i == ranges.begin())
+		return 0;
+
+	--i;
+	if (i->second <= offset)
+		return 0;
+
+	const offset_type available = i->second - offset;
+	return available < (offset_type)SIZE_MAX
+		? (size_t)available
+		: SIZE_MAX;
+}
+
+offset_type
+InputCacheEntry::AddRange(offset_type start, offset_type end)
+{
+	assert(start < end);
+
+	/* merge with all overlapping or adjacent ranges */
+	auto i = ranges.upper_bound(start);
+	if (i != ranges.begin() && std::prev(i)->second >= start)
+		--i;
+
+	offset_type removed = 0;
+	while (i != ranges.end() && i->first <= end) {
+		if (i->first < start)
+			start = i->first;
+		if (i->second > end)
+			end = i->second;
+
+		removed += i->second - i->first;
+		i = ranges.erase(i);
+	}
+
+	ranges.emplace(start, end);
+
+	const offset_type added = (end - start) - removed;
+	cached += added;
+	return added;
+}
+
+/**
+ * Saves the index of an #InputCache some time after it has been
+ * modified.  Schedule() may be called from any thread; the timer
+ * runs in the #EventLoop.
+ */
+class InputCacheSaver final : DeferredMonitor, TimeoutMonitor {
+	InputCache &cache;
+
+public:
+	InputCacheSaver(EventLoop &_loop, InputCache &_cache)
+		:DeferredMonitor(_loop), TimeoutMonitor(_loop),
+		 cache(_cache) {}
+
+	using DeferredMonitor::Schedule;
+
+	/**
+	 * Cancel the timer.  May be called from any thread.
+	 */
+	void Stop() {
+		DeferredMonitor::Cancel();
+		BlockingCall(DeferredMonitor::GetEventLoop(), [this](){
+				TimeoutMonitor::Cancel();
+			});
+	}
+
+private:
+	/* virtual methods from DeferredMonitor */
+	void RunDeferred() override {
+		if (!TimeoutMonitor::IsActive())
+			TimeoutMonitor::ScheduleSeconds(INPUT_CACHE_SAVE_DELAY);
+	}
+
+	/* virtual methods from TimeoutMonitor */
+	void OnTimeout() override {
+		cache.Save();
+	}
+};
+
+InputCache::InputCache(AllocatedPath &&_directory, offset_type _max_size,
+		       unsigned _ttl)
+	:directory(std::move(_directory)), max_size(_max_size), ttl(_ttl),
+	 saver(nullptr),
+	 total_size(0), modified(false)
+{
+}
+
+InputCache::~InputCache()
+{
+	assert(saver == nullptr);
+	assert(std::all_of(entries.begin(), entries.end(),
+			   [](const InputCacheEntry &e){
+				   return e.users == 0;
+			   }));
+}
+
+void
+InputCache::EnableSaver(EventLoop &loop)
+{
+	assert(saver == nullptr);
+
+	saver = new InputCacheSaver(loop, *this);
+}
+
+void
+InputCache::DisableSaver()
+{
+	if (saver == nullptr)
+		return;
+
+	saver->Stop();
+	delete saver;
+	saver = nullptr;
+}
+
+void
+InputCache::SetModified()
+{
+	if (modified)
+		return;
+
+	modified = true;
+	if (saver != nullptr)
+		saver->Schedule();
+}
+
+bool
+InputCache::IsCacheable(const char *uri)
+{
+	return StringStartsWith(uri, "http://") ||
+		StringStartsWith(uri, "https://") ||
+		StringStartsWith(uri, "nfs://") ||
+		StringStartsWith(uri, "smb://");
+}
+
+AllocatedPath
+InputCache::GetDataPath(const InputCacheEntry &entry) const
+{
+	return AllocatedPath::Build(directory, entry.name.c_str());
+}
+
+std::string
+InputCache::MakeName(const char *uri) const
+{
+	/* FNV-1a */
+	uint64_t hash = 14695981039346656037ULL;
+	for (const char *p = uri; *p != 0; ++p) {
+		hash ^= (unsigned char)*p;
+		hash *= 1099511628211ULL;
+	}
+
+	for (unsigned n = 0;; ++n) {
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), "%016llx-%u",
+			 (unsigned long long)hash, n);
+
+		if (std::none_of(entries.begin(), entries.end(),
+				 [&buffer](const InputCacheEntry &e){
+					 return e.name == buffer;
+				 }))
+			return buffer;
+	}
+}
+
+InputCacheEntry *
+InputCache::Find(const char *uri)
+{
+	auto i = index.find(uri);
+	if (i == index.end())
+		return nullptr;
+
+	/* move to the end of the LRU list; splice() does not
+	   invalidate the iterator */
+	entries.splice(entries.end(), entries, i->second);
+	return &entries.back();
+}
+
+InputCacheEntry &
+InputCache::Add(const char *uri, offset_type size)
+{
+	entries.emplace_back(uri, MakeName(uri), size);
+	index.insert(std::make_pair(std::string(uri),
+				    std::prev(entries.end())));
+	SetModified();
+	return entries.back();
+}
+
+void
+InputCache::Remove(EntryList::iterator i)
+{
+	assert(i->users == 0);
+
+	RemoveFile(GetDataPath(*i));
+	total_size -= i->cached;
+	index.erase(i->uri);
+	entries.erase(i);
+	SetModified();
+}
+
+bool
+InputCache::MakeRoom(offset_type needed)
+{
+	for (auto i = entries.begin();
+	     total_size + needed > max_size && i != entries.end();) {
+		if (i->users > 0) {
+			++i;
+			continue;
+		}
+
+		FormatDebug(input_cache_domain, "Evicting %s", i->uri.c_str());
+
+		auto next = std::next(i);
+		Remove(i);
+		i = next;
+	}
+
+	return total_size + needed <= max_size;
+}
+
+InputStream *
+InputCache::OpenComplete(const char *uri, Mutex &_mutex, Cond &_cond)
+{
+	const ScopeLock protect(mutex);
+
+	InputCacheEntry *entry = Find(uri);
+	if (entry == nullptr || !entry->IsComplete())
+		return nullptr;
+
+	const time_t now = time(nullptr);
+	if (now < entry->validated ||
+	    now >= entry->validated + time_t(ttl))
+		/* let the caller open the remote file; Acquire()
+		   will then compare its validators with this entry,
+		   and the cached data is still used if they match */
+		return nullptr;
+
+	int fd = open_cloexec(GetDataPath(*entry).c_str(), O_RDONLY, 0);
+	if (fd < 0) {
+		/* the data file has vanished */
+		entry->ranges.clear();
+		total_size -= entry->cached;
+		entry->cached = 0;
+		SetModified();
+		return nullptr;
+	}
+
+	++entry->users;
+	return new CompleteCacheInputStream(*this, *entry, fd, _mutex, _cond);
+}
+
+InputCacheEntry *
+InputCache::Acquire(const char *uri, offset_type size, const char *mime,
+		    const char *etag, const char *last_modified,
+		    int &fd_r)
+{
+	const ScopeLock protect(mutex);
+
+	InputCacheEntry *entry = Find(uri);
+	if (entry != nullptr && entry->users == 0 &&
+	    !entry->Matches(size, etag, last_modified)) {
+		/* the remote file has been modified */
+		Remove(std::prev(entries.end()));
+		entry = nullptr;
+	}
+
+	if (entry == nullptr)
+		entry = &Add(uri, size);
+	else if (!entry->Matches(size, etag, last_modified))
+		/* modified, but still in use */
+		return nullptr;
+
+	/* the server has just confirmed that the file is
+	   unmodified */
+	entry->validated = time(nullptr);
+	SetModified();
+
+	if (mime != nullptr)
+		entry->mime = mime;
+
+	if (etag != nullptr)
+		entry->etag = etag;
+
+	if (last_modified != nullptr)
+		entry->last_modified = last_modified;
+
+	const auto path = GetDataPath(*entry);
+	int fd = open_cloexec(path.c_str(), O_RDWR|O_CREAT, 0666);
+	if (fd < 0) {
+		FormatErrno(input_cache_domain, "Failed to open %s",
+			    path.c_str());
+		if (entry->users == 0)
+			Remove(std::prev(entries.end()));
+		return nullptr;
+	}
+
+	++entry->users;
+	fd_r = fd;
+	return entry;
+}
+
+void
+InputCache::Release(InputCacheEntry &entry, int fd)
+{
+	close(fd);
+
+	const ScopeLock protect(mutex);
+
+	assert(entry.users > 0);
+	--entry.users;
+
+	if (entry.users == 0 && entry.cached == 0) {
+		/* nothing was cached; don't clutter the index */
+		auto i = index.find(entry.uri);
+		assert(i != index.end());
+		assert(&*i->second == &entry);
+		Remove(i->second);
+	}
+}
+
+bool
+InputCache::BeginWrite(InputCacheEntry &entry)
+{
+	const ScopeLock protect(mutex);
+
+	if (entry.writing)
+		return false;
+
+	entry.writing = true;
+	return true;
+}
+
+void
+InputCache::EndWrite(InputCacheEntry &entry)
+{
+	const ScopeLock protect(mutex);
+
+	assert(entry.writing);
+	entry.writing = false;
+}
+
+bool
+InputCache::Written(InputCacheEntry &entry,
+		    offset_type start, offset_type end)
+{
+	const ScopeLock protect(mutex);
+
+	assert(entry.writing);
+
+	const offset_type added = entry.AddRange(start, end);
+	total_size += added;
+	SetModified();
+
+	if (!MakeRoom(0)) {
+		/* the cache is full of files which are in use */
+		entry.writing = false;
+		return false;
+	}
+
+	return true;
+}
+
+void
+InputCache::Load()
+{
+	const auto path = AllocatedPath::Build(directory, INDEX_NAME);
+
+	Error error;
+	TextFile file(path, error);
+	if (file.HasFailed())
+		return;
+
+	InputCacheEntry *entry = nullptr;
+	const char *line;
+	while ((line = file.ReadLine()) != nullptr) {
+		if (StringStartsWith(line, "entry: ")) {
+			entries.emplace_back(std::string(), line + 7, 0);
+			entry = &entries.back();
+		} else if (entry == nullptr) {
+			continue;
+		} else if (StringStartsWith(line, "uri: ")) {
+			entry->uri = line + 5;
+		} else if (StringStartsWith(line, "mime: ")) {
+			entry->mime = line + 6;
+		} else if (StringStartsWith(line, "etag: ")) {
+			entry->etag = line + 6;
+		} else if (StringStartsWith(line, "last_modified: ")) {
+			entry->last_modified = line + 15;
+		} else if (StringStartsWith(line, "size: ")) {
+			entry->size = strtoull(line + 6, nullptr, 10);
+		} else if (StringStartsWith(line, "validated: ")) {
+			entry->validated = strtoll(line + 11, nullptr, 10);
+		} else if (StringStartsWith(line, "range: ")) {
+			char *endptr;
+			offset_type start = strtoull(line + 7, &endptr, 10);
+			offset_type end = strtoull(endptr, nullptr, 10);
+			if (start < end && end <= entry->size)
+				total_size += entry->AddRange(start, end);
+		}
+	}
+
+	/* discard entries whose data file has vanished, and
+	   duplicates */
+	for (auto i = entries.begin(); i != entries.end();) {
+		auto next = std::next(i);
+		if (i->uri.empty() || !FileExists(GetDataPath(*i)) ||
+		    !index.insert(std::make_pair(i->uri, i)).second) {
+			total_size -= i->cached;
+			entries.erase(i);
+		}
+
+		i = next;
+	}
+
+	MakeRoom(0);
+
+	FormatDebug(input_cache_domain, "Loaded %u entries (%llu bytes)",
+		    unsigned(entries.size()), (unsigned long long)total_size);
+}
+
+void
+InputCache::Save()
+{
+	const ScopeLock protect(mutex);
+
+	if (!modified)
+		return;
+
+	const auto path = AllocatedPath::Build(directory, INDEX_NAME);
+
+	Error error;
+	FileOutputStream fos(path, error);
+	if (!fos.IsDefined()) {
+		LogError(error);
+		return;
+	}
+
+	BufferedOutputStream bos(fos);
+	for (const auto &entry : entries) {
+		if (entry.cached == 0)
+			continue;
+
+		bos.Format("entry: %s\n", entry.name.c_str());
+		bos.Format("uri: %s\n", entry.uri.c_str());
+		if (!entry.mime.empty())
+			bos.Format("mime: %s\n", entry.mime.c_str());
+		if (!entry.etag.empty())
+			bos.Format("etag: %s\n", entry.etag.c_str());
+		if (!entry.last_modified.empty())
+			bos.Format("last_modified: %s\n",
+				   entry.last_modified.c_str());
+		bos.Format("size: %llu\n", (unsigned long long)entry.size);
+		bos.Format("validated: %lld\n", (long long)entry.validated);
+		for (const auto &range : entry.ranges)
+			bos.Format("range: %llu %llu\n",
+				   (unsigned long long)range.first,
+				   (unsigned long long)range.second);
+	}
+
+	if (!bos.Flush(error) || !fos.Commit(error)) {
+		LogError(error);
+		return;
+	}
+
+	modified = false;
+}
+
+bool
+input_cache_global_init(Error &error)
+{
+	assert(input_cache == nullptr);
+
+	auto directory = config_get_path(CONF_INPUT_CACHE_DIRECTORY, error);
+	if (directory.IsNull())
+		return !error.IsDefined();
+
+	if (!DirectoryExists(directory)) {
+		error.Format(input_cache_domain,
+			     "Input cache directory does not exist: %s",
+			     directory.c_str());
+		return false;
+	}
+
+	const offset_type max_size =
+		offset_type(config_get_positive(CONF_INPUT_CACHE_SIZE,
+						DEFAULT_INPUT_CACHE_SIZE))
+		* 1024 * 1024;
+
+	const unsigned ttl = config_get_unsigned(CONF_INPUT_CACHE_TTL,
+						 DEFAULT_INPUT_CACHE_TTL);
+
+	input_cache = new InputCache(std::move(directory), max_size, ttl);
+	input_cache->Load();
+	input_cache->EnableSaver(io_thread_get());
+	return true;
+}
+
+void
+input_cache_global_finish()
+{
+	if (input_cache == nullptr)
+		return;
+
+	input_cache->DisableSaver();
+	input_cache->Save();
+	delete input_cache;
+	input_cache = nullptr;
+}
@@ -0,0 +1,297 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_INPUT_CACHE_HXX
+#define MPD_INPUT_CACHE_HXX
+
+#include "check.h"
+#include "Offset.hxx"
+#include "thread/Mutex.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "Compiler.h"
+
+#include <string>
+#include <list>
+#include <map>
+
+#include <time.h>
+
+class Error;
+class Cond;
+class InputStream;
+class EventLoop;
+class InputCacheSaver;
+
+/**
+ * One file in the #InputCache.
+ */
+struct InputCacheEntry {
+	std::string uri;
+
+	/**
+	 * The name of the data file in the cache directory.
+	 */
+	std::string name;
+
+	std::string mime;
+
+	/**
+	 * The size of the remote file.
+	 */
+	offset_type size;
+
+	/**
+	 * The "ETag" and "Last-Modified" values of the remote file;
+	 * empty if the server did not send them.
+	 */
+	std::string etag, last_modified;
+
+	/**
+	 * The time [time()] when the server has last confirmed that
+	 * the file is unmodified.  Complete entries are served
+	 * without contacting the server only for a while after that.
+	 */
+	time_t validated;
+
+	/**
+	 * The byte ranges which are present in the data file.  Maps
+	 * start offset to end offset; adjacent ranges are merged.
+	 */
+	std::map<offset_type, offset_type> ranges;
+
+	/**
+	 * The sum of all #ranges.
+	 */
+	offset_type cached;
+
+	/**
+	 * The number of #InputStream objects using this entry.  It
+	 * must not be evicted while this is non-zero.
+	 */
+	unsigned users;
+
+	/**
+	 * Is an #InputStream currently adding data to this entry?
+	 * Only one may do that at a time.
+	 */
+	bool writing;
+
+	InputCacheEntry(const std::string &_uri, std::string &&_name,
+			offset_type _size)
+		:uri(_uri), name(std::move(_name)), size(_size),
+		 validated(0), cached(0), users(0), writing(false) {}
+
+	bool IsComplete() const {
+		return cached == size;
+	}
+
+	/**
+	 * Does this entry still describe the remote file?  The
+	 * "ETag" and "Last-Modified" values are compared if the
+	 * server sent them; only if it sent neither, a matching
+	 * size is enough.
+	 *
+	 * @param _etag the current "ETag" or nullptr
+	 * @param _last_modified the current "Last-Modified" or
+	 * nullptr
+	 */
+	gcc_pure
+	bool Matches(offset_type _size, const char *_etag,
+		     const char *_last_modified) const;
+
+	/**
+	 * How many bytes starting at the given offset are cached?
+	 */
+	gcc_pure
+	size_t GetAvailable(offset_type offset) const;
+
+	/**
+	 * Mark a range as cached.
+	 *
+	 * @return the number of bytes which were not cached before
+	 */
+	offset_type AddRange(offset_type start, offset_type end);
+};
+
+/**
+ * A size-bounded cache for remote files on the local disk.  Files
+ * are cached as they are read, and partially cached files can be
+ * used for all ranges which have been read before.  The least
+ * recently used files are evicted first.
+ *
+ * This object is thread-safe.
+ */
+class InputCache {
+	typedef std::list<InputCacheEntry> EntryList;
+
+	const AllocatedPath directory;
+	const offset_type max_size;
+
+	/**
+	 * How long [seconds] is a complete entry served without
+	 * asking the server whether the file has been modified?
+	 */
+	const unsigned ttl;
+
+	mutable Mutex mutex;
+
+	/**
+	 * All entries, the least recently used first.
+	 */
+	EntryList entries;
+
+	/**
+	 * Look up #entries by URI.
+	 */
+	std::map<std::string, EntryList::iterator> index;
+
+	/**
+	 * Writes the index file after it has been modified; nullptr
+	 * if the index is saved only at shutdown.
+	 */
+	InputCacheSaver *saver;
+
+	/**
+	 * The sum of all InputCacheEntry::cached.
+	 */
+	offset_type total_size;
+
+	bool modified;
+
+public:
+	InputCache(AllocatedPath &&_directory, offset_type _max_size,
+		   unsigned _ttl);
+	~InputCache();
+
+	/**
+	 * Save the index file periodically from a timer in the
+	 * given #EventLoop after it has been modified.
+	 */
+	void EnableSaver(EventLoop &loop);
+
+	/**
+	 * Stop the timer started by EnableSaver().
+	 */
+	void DisableSaver();
+
+	InputCache(const InputCache &) = delete;
+	InputCache &operator=(const InputCache &) = delete;
+
+	/**
+	 * Is this URI eligible for caching?
+	 */
+	gcc_pure
+	static bool IsCacheable(const char *uri);
+
+	void Load();
+	void Save();
+
+	/**
+	 * Open a stream which reads a completely cached file, without
+	 * contacting the server.
+	 *
+	 * @return nullptr if the file is not completely cached, or if
+	 * the entry needs to be revalidated by the server
+	 */
+	InputStream *OpenComplete(const char *uri, Mutex &mutex, Cond &cond);
+
+	/**
+	 * Obtain the entry for the given file, creating it if
+	 * necessary.  Call Release() when done.
+	 *
+	 * @param size the size of the remote file
+	 * @param etag the "ETag" of the remote file or nullptr
+	 * @param last_modified the "Last-Modified" value of the
+	 * remote file or nullptr
+	 * @param fd_r the data file opened for reading and writing
+	 * @return the entry or nullptr on error
+	 *
+	 * If the old entry does not match (see
+	 * InputCacheEntry::Matches()), it is discarded.
+	 */
+	InputCacheEntry *Acquire(const char *uri, offset_type size,
+				 const char *mime,
+				 const char *etag, const char *last_modified,
+				 int &fd_r);
+
+	void Release(InputCacheEntry &entry, int fd);
+
+	/**
+	 * Try to become the writer of the given entry.
+	 */
+	bool BeginWrite(InputCacheEntry &entry);
+
+	void EndWrite(InputCacheEntry &entry);
+
+	/**
+	 * Data has been written to the data file.  Evicts other
+	 * entries if the cache has become too large.
+	 *
+	 * @return false if the caller shall stop writing because
+	 * there is not enough room; EndWrite() has been called
+	 * implicitly then
+	 */
+	bool Written(InputCacheEntry &entry,
+		     offset_type start, offset_type end);
+
+	gcc_pure
+	size_t GetAvailable(const InputCacheEntry &entry,
+			    offset_type offset) const {
+		const ScopeLock protect(mutex);
+		return entry.GetAvailable(offset);
+	}
+
+private:
+	InputCacheEntry *Find(const char *uri);
+
+	AllocatedPath GetDataPath(const InputCacheEntry &entry) const;
+
+	std::string MakeName(const char *uri) const;
+
+	InputCacheEntry &Add(const char *uri, offset_type size);
+
+	void Remove(EntryList::iterator i);
+
+	/**
+	 * The index has been modified; schedule saving it.  Caller
+	 * must lock the mutex.
+	 */
+	void SetModified();
+
+	/**
+	 * Evict unused entries until there is room for the given
+	 * number of additional bytes.
+	 *
+	 * @return true if there is enough room now
+	 */
+	bool MakeRoom(offset_type needed);
+};
+
+/**
+ * The global #InputCache instance; nullptr if the cache is disabled.
+ */
+extern InputCache *input_cache;
+
+bool
+input_cache_global_init(Error &error);
+
+void
+input_cache_global_finish();
+
+#endif
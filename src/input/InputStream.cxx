@@ -23,6 +23,7 @@
 #include "util/StringUtil.hxx"
 
 #include <assert.h>
+#include <stdio.h>
 
 InputStream::~InputStream()
 {
@@ -93,6 +94,20 @@ InputStream::Seek(gcc_unused offset_type new_offset,
 	return false;
 }
 
+void
+InputStream::SetModificationTime(time_t mtime)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%lld", (long long)mtime);
+	SetLastModified(buffer);
+}
+
+bool
+InputStream::SeekAsync(gcc_unused offset_type new_offset)
+{
+	return false;
+}
+
 bool
 InputStream::LockSeek(offset_type _offset, Error &error)
 {
@@ -136,3 +151,31 @@ InputStream::LockIsEOF()
 	return IsEOF();
 }
 
+ConstBuffer<void>
+InputStream::Peek()
+{
+	return nullptr;
+}
+
+void
+InputStream::Consume(gcc_unused size_t nbytes)
+{
+	/* Peek() is not implemented, so this must not be called */
+	assert(false);
+	gcc_unreachable();
+}
+
+ConstBuffer<void>
+InputStream::LockPeek()
+{
+	const ScopeLock protect(mutex);
+	return Peek();
+}
+
+void
+InputStream::LockConsume(size_t nbytes)
+{
+	const ScopeLock protect(mutex);
+	Consume(nbytes);
+}
+
@@ -23,12 +23,14 @@
 #include "check.h"
 #include "Offset.hxx"
 #include "thread/Mutex.hxx"
+#include "util/ConstBuffer.hxx"
 #include "Compiler.h"
 
 #include <string>
 
 #include <assert.h>
 #include <stdint.h>
+#include <time.h>
 
 class Cond;
 class Error;
@@ -95,6 +97,19 @@ private:
 	 */
 	std::string mime;
 
+	/**
+	 * An opaque version identifier of the resource (e.g. the
+	 * HTTP "ETag"), or empty if unknown.
+	 */
+	std::string etag;
+
+	/**
+	 * The modification time of the resource as reported by the
+	 * server (e.g. the HTTP "Last-Modified" header), or empty if
+	 * unknown.
+	 */
+	std::string last_modified;
+
 public:
 	InputStream(const char *_uri, Mutex &_mutex, Cond &_cond)
 		:uri(_uri),
@@ -213,6 +228,39 @@ public:
 		mime = std::move(_mime);
 	}
 
+	gcc_pure
+	const char *GetETag() const {
+		assert(ready);
+
+		return etag.empty() ? nullptr : etag.c_str();
+	}
+
+	void SetETag(std::string &&_etag) {
+		assert(!ready);
+
+		etag = std::move(_etag);
+	}
+
+	gcc_pure
+	const char *GetLastModified() const {
+		assert(ready);
+
+		return last_modified.empty() ? nullptr : last_modified.c_str();
+	}
+
+	void SetLastModified(std::string &&_last_modified) {
+		assert(!ready);
+
+		last_modified = std::move(_last_modified);
+	}
+
+	/**
+	 * Set the "Last-Modified" value from a file modification
+	 * time.  Like all "Last-Modified" values, it is only compared
+	 * for equality.
+	 */
+	void SetModificationTime(time_t mtime);
+
 	gcc_nonnull_all
 	void OverrideMimeType(const char *_mime) {
 		assert(ready);
@@ -279,6 +327,21 @@ public:
 	 */
 	virtual bool Seek(offset_type offset, Error &error);
 
+	/**
+	 * Begin seeking to the specified position without waiting
+	 * for the server.  Until data from the new position has
+	 * arrived, IsAvailable() returns false.  Errors are reported
+	 * by the next Read() call.
+	 *
+	 * The default implementation returns false; the caller must
+	 * then use Seek(), which may block.
+	 *
+	 * The caller must lock the mutex.
+	 *
+	 * @return true if seeking has begun (or is already finished)
+	 */
+	virtual bool SeekAsync(offset_type offset);
+
 	/**
 	 * Wrapper for Seek() which locks and unlocks the mutex; the
 	 * caller must not be holding it already.
@@ -360,6 +423,43 @@ public:
 	 */
 	gcc_nonnull_all
 	size_t LockRead(void *ptr, size_t size, Error &error);
+
+	/**
+	 * Returns a pointer to the data at the current offset, without
+	 * copying it.  Only some implementations support this (e.g.
+	 * memory-mapped files); the others return an empty buffer,
+	 * and the caller must fall back to Read().
+	 *
+	 * The returned pointer is valid until the next call on this
+	 * object.  Advance the offset with Consume().
+	 *
+	 * The caller must lock the mutex.
+	 */
+	gcc_pure
+	virtual ConstBuffer<void> Peek();
+
+	/**
+	 * Mark data returned by Peek() as consumed.
+	 *
+	 * The caller must lock the mutex.
+	 *
+	 * @param nbytes the number of bytes, must not be larger than
+	 * the size returned by Peek()
+	 */
+	virtual void Consume(size_t nbytes);
+
+	/**
+	 * Wrapper for Peek() which locks and unlocks the mutex; the
+	 * caller must not be holding it already.
+	 */
+	gcc_pure
+	ConstBuffer<void> LockPeek();
+
+	/**
+	 * Wrapper for Consume() which locks and unlocks the mutex;
+	 * the caller must not be holding it already.
+	 */
+	void LockConsume(size_t nbytes);
 };
 
 #endif
@@ -22,6 +22,11 @@
 #include "Registry.hxx"
 #include "InputPlugin.hxx"
 #include "plugins/RewindInputPlugin.hxx"
+
+#ifndef WIN32
+#include "CacheInputStream.hxx"
+#endif
+
 #include "util/Error.hxx"
 #include "util/Domain.hxx"
 
@@ -32,11 +37,20 @@ InputStream::Open(const char *url,
 		  Mutex &mutex, Cond &cond,
 		  Error &error)
 {
+#ifndef WIN32
+	InputStream *cached = input_cache_open(url, mutex, cond);
+	if (cached != nullptr)
+		return cached;
+#endif
+
 	input_plugins_for_each_enabled(plugin) {
 		InputStream *is;
 
 		is = plugin->open(url, mutex, cond, error);
 		if (is != nullptr) {
+#ifndef WIN32
+			is = input_cache_wrap(is);
+#endif
 			is = input_rewind_open(is);
 
 			return is;
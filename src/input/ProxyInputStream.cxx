@@ -40,6 +40,12 @@ ProxyInputStream::CopyAttributes()
 			if (input.HasMimeType())
 				SetMimeType(input.GetMimeType());
 
+			if (input.GetETag() != nullptr)
+				SetETag(input.GetETag());
+
+			if (input.GetLastModified() != nullptr)
+				SetLastModified(input.GetLastModified());
+
 			size = input.KnownSize()
 				? input.GetSize()
 				: UNKNOWN_SIZE;
@@ -22,10 +22,15 @@
 #include "thread/Name.hxx"
 #include "util/CircularBuffer.hxx"
 #include "util/HugeAllocator.hxx"
+#include "util/Domain.hxx"
+
+#include <algorithm>
 
 #include <assert.h>
 #include <string.h>
 
+static constexpr Domain thread_input_domain("thread_input");
+
 ThreadInputStream::~ThreadInputStream()
 {
 	Lock();
@@ -81,28 +86,62 @@ ThreadInputStream::ThreadFunc()
 	while (!close) {
 		assert(!postponed_error.IsDefined());
 
+		if (seek) {
+			buffer->Clear();
+			eof = false;
+
+			Unlock();
+
+			Error error;
+			const bool success = ThreadSeek(seek_offset, error);
+
+			Lock();
+
+			if (success)
+				seek_error.Clear();
+			else
+				seek_error = std::move(error);
+			seek = false;
+			cond.broadcast();
+			continue;
+		}
+
 		auto w = buffer->Write();
-		if (w.IsEmpty()) {
+		if (w.IsEmpty() || eof) {
+			/* wait until the buffer has room, or until
+			   the client seeks back from the end */
 			wake_cond.wait(mutex);
 		} else {
 			Unlock();
 
 			Error error;
-			size_t nbytes = Read(w.data, w.size, error);
+			size_t nbytes = ThreadRead(w.data, w.size, error);
 
 			Lock();
 			cond.broadcast();
 
 			if (nbytes == 0) {
 				eof = true;
-				postponed_error = std::move(error);
-				break;
+				if (error.IsDefined()) {
+					postponed_error = std::move(error);
+					break;
+				}
+
+				continue;
 			}
 
 			buffer->Append(nbytes);
 		}
 	}
 
+	if (seek) {
+		/* the thread is about to exit; fail the pending
+		   seek */
+		seek_error.Set(thread_input_domain, "Stream closed");
+		seek = false;
+		cond.broadcast();
+	}
+
 	Unlock();
 
 	Close();
@@ -158,8 +197,64 @@ ThreadInputStream::Read(void *ptr, size_t read_size, Error &error)
 	}
 }
 
+bool
+ThreadInputStream::ThreadSeek(gcc_unused offset_type new_offset,
+			      Error &error)
+{
+	error.Set(thread_input_domain, "Not seekable");
+	return false;
+}
+
+bool
+ThreadInputStream::Seek(offset_type new_offset, Error &error)
+{
+	assert(seekable);
+
+	if (new_offset == offset)
+		return true;
+
+	if (new_offset > offset) {
+		/* skip forward inside the buffer without bothering
+		   the thread */
+		offset_type skip = new_offset - offset;
+		if (skip <= buffer->GetSize()) {
+			while (skip > 0) {
+				auto r = buffer->Read();
+				const size_t n = std::min<offset_type>(skip,
+								       r.size);
+				buffer->Consume(n);
+				skip -= n;
+			}
+
+			wake_cond.broadcast();
+			offset = new_offset;
+			return true;
+		}
+	}
+
+	if (postponed_error.IsDefined()) {
+		error = std::move(postponed_error);
+		return false;
+	}
+
+	seek_offset = new_offset;
+	seek = true;
+	wake_cond.broadcast();
+
+	while (seek)
+		cond.wait(mutex);
+
+	if (seek_error.IsDefined()) {
+		error = std::move(seek_error);
+		return false;
+	}
+
+	offset = new_offset;
+	return true;
+}
+
 bool
 ThreadInputStream::IsEOF()
 {
-	return eof;
+	return eof && buffer->IsEmpty();
 }
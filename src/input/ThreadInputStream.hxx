@@ -37,7 +37,9 @@ template<typename T> class CircularBuffer;
  * another thread using the regular #InputStream API.  This class
  * manages the thread and the buffer.
  *
- * This works only for "streams": unknown length, no seeking, no tags.
+ * By default, this works only for "streams": unknown length, no
+ * seeking, no tags.  Implementations which set the "seekable" flag
+ * must implement ThreadSeek().
  */
 class ThreadInputStream : public InputStream {
 	const char *const plugin;
@@ -66,6 +68,19 @@ class ThreadInputStream : public InputStream {
 	 */
 	bool eof;
 
+	/**
+	 * Shall the thread seek to #seek_offset?  It clears this
+	 * flag and signals #cond when done.
+	 */
+	bool seek;
+
+	offset_type seek_offset;
+
+	/**
+	 * The error of the last ThreadSeek() call.
+	 */
+	Error seek_error;
+
 public:
 	ThreadInputStream(const char *_plugin,
 			  const char *_uri, Mutex &_mutex, Cond &_cond,
@@ -74,7 +89,7 @@ public:
 		 plugin(_plugin),
 		 buffer_size(_buffer_size),
 		 buffer(nullptr),
-		 close(false), eof(false) {}
+		 close(false), eof(false), seek(false) {}
 
 	virtual ~ThreadInputStream();
 
@@ -90,6 +105,7 @@ public:
 	bool IsEOF() override final;
 	bool IsAvailable() override final;
 	size_t Read(void *ptr, size_t size, Error &error) override final;
+	bool Seek(offset_type offset, Error &error) override final;
 
 protected:
 	void SetMimeType(const char *_mime) {
@@ -121,6 +137,16 @@ protected:
 	 */
 	virtual size_t ThreadRead(void *ptr, size_t size, Error &error) = 0;
 
+	/**
+	 * Seek the backend to the given position.  Only called if
+	 * the "seekable" flag has been set.
+	 *
+	 * The #InputStream is not locked.
+	 *
+	 * @return false on error
+	 */
+	virtual bool ThreadSeek(offset_type offset, Error &error);
+
 	/**
 	 * Optional deinitialization before leaving the thread.
 	 *
@@ -49,16 +49,12 @@
 #endif
 
 /**
- * Do not buffer more than this number of bytes.  It should be a
- * reasonable limit that doesn't make low-end machines suffer too
- * much, but doesn't cause stuttering on high-latency lines.
+ * The buffer settings.  By default, do not buffer more than 512 kB
+ * (a reasonable limit that doesn't make low-end machines suffer too
+ * much, but doesn't cause stuttering on high-latency lines), and
+ * resume the stream at 75% after it has been paused.
  */
-static const size_t CURL_MAX_BUFFERED = 512 * 1024;
-
-/**
- * Resume the stream at this number of bytes after it has been paused.
- */
-static const size_t CURL_RESUME_AT = 384 * 1024;
+static AsyncInputStreamConfig curl_buffer_config(512 * 1024, 75);
 
 struct CurlInputStream final : public AsyncInputStream {
 	/* some buffers which were passed to libcurl, which we have
@@ -78,8 +74,7 @@ struct CurlInputStream final : public AsyncInputStream {
 	CurlInputStream(const char *_url, Mutex &_mutex, Cond &_cond,
 			void *_buffer)
 		:AsyncInputStream(_url, _mutex, _cond,
-				  _buffer, CURL_MAX_BUFFERED,
-				  CURL_RESUME_AT),
+				  _buffer, curl_buffer_config),
 		 request_headers(nullptr),
 		 icy(new IcyInputStream(this)) {}
 
@@ -530,6 +525,9 @@ CurlMulti::OnTimeout()
 static InputPlugin::InitResult
 input_curl_init(const config_param &param, Error &error)
 {
+	if (!curl_buffer_config.Configure(param, error))
+		return InputPlugin::InitResult::ERROR;
+
 	CURLcode code = curl_global_init(CURL_GLOBAL_ALL);
 	if (code != CURLE_OK) {
 		error.Format(curl_domain, code,
@@ -612,6 +610,10 @@ CurlInputStream::HeaderReceived(const char *name, std::string &&value)
 		size = offset + ParseUint64(value.c_str());
 	} else if (StringEqualsCaseASCII(name, "content-type")) {
 		SetMimeType(std::move(value));
+	} else if (StringEqualsCaseASCII(name, "etag")) {
+		SetETag(std::move(value));
+	} else if (StringEqualsCaseASCII(name, "last-modified")) {
+		SetLastModified(std::move(value));
 	} else if (StringEqualsCaseASCII(name, "icy-name") ||
 		   StringEqualsCaseASCII(name, "ice-name") ||
 		   StringEqualsCaseASCII(name, "x-audiocast-name")) {
@@ -811,7 +813,7 @@ inline InputStream *
 CurlInputStream::Open(const char *url, Mutex &mutex, Cond &cond,
 		      Error &error)
 {
-	void *buffer = HugeAllocate(CURL_MAX_BUFFERED);
+	void *buffer = HugeAllocate(curl_buffer_config.buffer_size);
 	if (buffer == nullptr) {
 		error.Set(curl_domain, "Out of memory");
 		return nullptr;
@@ -20,28 +20,94 @@
 #include "config.h" /* must be first for large file support */
 #include "FileInputPlugin.hxx"
 #include "../InputStream.hxx"
+#include "../ThreadInputStream.hxx"
 #include "../InputPlugin.hxx"
+#include "config/ConfigData.hxx"
 #include "util/Error.hxx"
 #include "util/Domain.hxx"
 #include "fs/Traits.hxx"
 #include "system/fd_util.h"
 #include "open.h"
 
+#include <algorithm>
+
 #include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
+#include <string.h>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
 
 static constexpr Domain file_domain("file");
 
+/**
+ * The size of the read-ahead buffer in bytes.  0 means read-ahead is
+ * disabled, and the decoder thread reads directly from the file.
+ */
+static size_t read_ahead_size;
+
+#ifndef WIN32
+
+/**
+ * Map files into memory instead of read()ing them?
+ */
+static bool use_mmap;
+
+/**
+ * After seeking, ask the kernel to read this many bytes ahead.
+ */
+static constexpr size_t MMAP_WILLNEED_SIZE = 1024 * 1024;
+
+/**
+ * A variant of #FileInputStream which maps the whole file into
+ * memory.  Read() copies from the mapping instead of calling read(),
+ * and Peek() allows decoders to consume the data in place.
+ */
+class MmapFileInputStream final : public InputStream {
+	const uint8_t *const data;
+
+public:
+	MmapFileInputStream(const char *path, const void *_data,
+			    const struct stat &st,
+			    Mutex &_mutex, Cond &_cond)
+		:InputStream(path, _mutex, _cond),
+		 data((const uint8_t *)_data) {
+		size = st.st_size;
+		seekable = true;
+		SetModificationTime(st.st_mtime);
+		SetReady();
+	}
+
+	~MmapFileInputStream() {
+		munmap(const_cast<uint8_t *>(data), size);
+	}
+
+	/* virtual methods from InputStream */
+
+	bool IsEOF() override {
+		return GetOffset() >= GetSize();
+	}
+
+	size_t Read(void *ptr, size_t size, Error &error) override;
+	bool Seek(offset_type offset, Error &error) override;
+	ConstBuffer<void> Peek() override;
+	void Consume(size_t nbytes) override;
+};
+
+#endif
+
 struct FileInputStream final : public InputStream {
 	int fd;
 
-	FileInputStream(const char *path, int _fd, off_t _size,
+	FileInputStream(const char *path, int _fd, const struct stat &st,
 			Mutex &_mutex, Cond &_cond)
 		:InputStream(path, _mutex, _cond),
 		 fd(_fd) {
-		size = _size;
+		size = st.st_size;
 		seekable = true;
+		SetModificationTime(st.st_mtime);
 		SetReady();
 	}
 
@@ -59,6 +125,46 @@ struct FileInputStream final : public InputStream {
 	bool Seek(offset_type offset, Error &error) override;
 };
 
+/**
+ * A variant of #FileInputStream which reads from the file in a
+ * separate thread, so the decoder thread consumes from memory and
+ * is not blocked by slow (or spinning up) disks.
+ */
+class ReadAheadFileInputStream final : public ThreadInputStream {
+	int fd;
+
+public:
+	ReadAheadFileInputStream(const char *path, int _fd,
+				 const struct stat &st,
+				 Mutex &_mutex, Cond &_cond)
+		:ThreadInputStream("file", path, _mutex, _cond,
+				   read_ahead_size),
+		 fd(_fd) {
+		size = st.st_size;
+		seekable = true;
+		SetModificationTime(st.st_mtime);
+	}
+
+protected:
+	/* virtual methods from ThreadInputStream */
+	size_t ThreadRead(void *ptr, size_t size, Error &error) override;
+	bool ThreadSeek(offset_type offset, Error &error) override;
+
+	void Close() override {
+		::close(fd);
+	}
+};
+
+static InputPlugin::InitResult
+input_file_init(const config_param &param, gcc_unused Error &error)
+{
+	read_ahead_size = param.GetBlockValue("read_ahead_size", 0u) * 1024;
+#ifndef WIN32
+	use_mmap = param.GetBlockValue("mmap", false);
+#endif
+	return InputPlugin::InitResult::SUCCESS;
+}
+
 static InputStream *
 input_file_open(const char *filename,
 		Mutex &mutex, Cond &cond,
@@ -95,7 +201,40 @@ input_file_open(const char *filename,
 	posix_fadvise(fd, (off_t)0, st.st_size, POSIX_FADV_SEQUENTIAL);
 #endif
 
-	return new FileInputStream(filename, fd, st.st_size, mutex, cond);
+#ifndef WIN32
+	if (use_mmap && st.st_size > 0 &&
+	    (uintmax_t)st.st_size <= (uintmax_t)SIZE_MAX) {
+		void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED,
+			       fd, 0);
+		if (p != MAP_FAILED) {
+			/* the mapping keeps the file referenced */
+			close(fd);
+
+#ifdef MADV_SEQUENTIAL
+			madvise(p, st.st_size, MADV_SEQUENTIAL);
+#endif
+
+			return new MmapFileInputStream(filename, p, st,
+						       mutex, cond);
+		}
+
+		/* fall back to read() */
+	}
+#endif
+
+	if (read_ahead_size > 0) {
+		auto *ra = new ReadAheadFileInputStream(filename, fd, st,
+							mutex, cond);
+		auto *is = ra->Start(error);
+		if (is == nullptr) {
+			delete ra;
+			close(fd);
+		}
+
+		return is;
+	}
+
+	return new FileInputStream(filename, fd, st, mutex, cond);
 }
 
 bool
@@ -124,9 +263,87 @@ FileInputStream::Read(void *ptr, size_t read_size, Error &error)
 	return (size_t)nbytes;
 }
 
+size_t
+ReadAheadFileInputStream::ThreadRead(void *ptr, size_t read_size,
+				     Error &error)
+{
+	ssize_t nbytes = read(fd, ptr, read_size);
+	if (nbytes < 0) {
+		error.SetErrno("Failed to read");
+		return 0;
+	}
+
+	return (size_t)nbytes;
+}
+
+bool
+ReadAheadFileInputStream::ThreadSeek(offset_type new_offset, Error &error)
+{
+	if (lseek(fd, (off_t)new_offset, SEEK_SET) < 0) {
+		error.SetErrno("Failed to seek");
+		return false;
+	}
+
+	return true;
+}
+
+#ifndef WIN32
+
+size_t
+MmapFileInputStream::Read(void *ptr, size_t read_size,
+			  gcc_unused Error &error)
+{
+	const auto src = Peek();
+	const size_t nbytes = std::min(read_size, src.size);
+	memcpy(ptr, src.data, nbytes);
+	offset += nbytes;
+	return nbytes;
+}
+
+bool
+MmapFileInputStream::Seek(offset_type new_offset, Error &error)
+{
+	if (new_offset > size) {
+		error.Set(file_domain, "Seek beyond end of file");
+		return false;
+	}
+
+#ifdef MADV_WILLNEED
+	/* the access pattern is not sequential anymore; prefetch the
+	   area around the new position */
+	static const long page_size = sysconf(_SC_PAGESIZE);
+	if (page_size > 0 && new_offset < size) {
+		const offset_type start = new_offset / page_size * page_size;
+		const size_t length = std::min<offset_type>(size - start,
+							    MMAP_WILLNEED_SIZE);
+		madvise(const_cast<uint8_t *>(data + start), length,
+			MADV_WILLNEED);
+	}
+#endif
+
+	offset = new_offset;
+	return true;
+}
+
+ConstBuffer<void>
+MmapFileInputStream::Peek()
+{
+	return ConstBuffer<void>(data + offset, size - offset);
+}
+
+void
+MmapFileInputStream::Consume(size_t nbytes)
+{
+	assert(nbytes <= size - offset);
+
+	offset += nbytes;
+}
+
+#endif
+
 const InputPlugin input_plugin_file = {
 	"file",
-	nullptr,
+	input_file_init,
 	nullptr,
 	input_file_open,
 };
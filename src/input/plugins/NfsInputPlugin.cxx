@@ -24,6 +24,7 @@
 #include "lib/nfs/Domain.hxx"
 #include "lib/nfs/Glue.hxx"
 #include "lib/nfs/FileReader.hxx"
+#include "config/ConfigData.hxx"
 #include "util/HugeAllocator.hxx"
 #include "util/StringUtil.hxx"
 #include "util/Error.hxx"
@@ -37,16 +38,20 @@ extern "C" {
 #include <fcntl.h>
 
 /**
- * Do not buffer more than this number of bytes.  It should be a
- * reasonable limit that doesn't make low-end machines suffer too
- * much, but doesn't cause stuttering on high-latency lines.
+ * The buffer settings.  By default, do not buffer more than 512 kB
+ * (a reasonable limit that doesn't make low-end machines suffer too
+ * much, but doesn't cause stuttering on high-latency lines), and
+ * resume the stream at 75% after it has been paused.
  */
-static const size_t NFS_MAX_BUFFERED = 512 * 1024;
+static AsyncInputStreamConfig nfs_buffer_config(512 * 1024, 75);
 
 /**
- * Resume the stream at this number of bytes after it has been paused.
+ * The read-ahead settings: the number of concurrent read requests
+ * and the size of each.  Keeping several requests in flight hides
+ * the round-trip time of the NFS server.
  */
-static const size_t NFS_RESUME_AT = 384 * 1024;
+static unsigned nfs_read_requests = 4;
+static size_t nfs_read_size = 32768;
 
 class NfsInputStream final : public AsyncInputStream, NfsFileReader {
 	uint64_t next_offset;
@@ -58,8 +63,8 @@ public:
 		       Mutex &_mutex, Cond &_cond,
 		       void *_buffer)
 		:AsyncInputStream(_uri, _mutex, _cond,
-				  _buffer, NFS_MAX_BUFFERED,
-				  NFS_RESUME_AT),
+				  _buffer, nfs_buffer_config),
+		 NfsFileReader(nfs_read_requests, nfs_read_size),
 		 reconnect_on_resume(false), reconnecting(false) {}
 
 	virtual ~NfsInputStream() {
@@ -82,7 +87,7 @@ protected:
 
 private:
 	/* virtual methods from NfsFileReader */
-	void OnNfsFileOpen(uint64_t size) override;
+	void OnNfsFileOpen(uint64_t size, time_t mtime) override;
 	void OnNfsFileRead(const void *data, size_t size) override;
 	void OnNfsFileError(Error &&error) override;
 };
@@ -90,24 +95,11 @@ private:
 bool
 NfsInputStream::DoRead()
 {
-	assert(NfsFileReader::IsIdle());
-
-	int64_t remaining = size - next_offset;
-	if (remaining <= 0)
-		return true;
-
 	const size_t buffer_space = GetBufferSpace();
-	if (buffer_space == 0) {
-		Pause();
-		return true;
-	}
-
-	size_t nbytes = std::min<size_t>(std::min<uint64_t>(remaining, 32768),
-					 buffer_space);
 
 	mutex.unlock();
 	Error error;
-	bool success = NfsFileReader::Read(next_offset, nbytes, error);
+	bool success = NfsFileReader::Read(buffer_space, error);
 	mutex.lock();
 
 	if (!success) {
@@ -115,6 +107,11 @@ NfsInputStream::DoRead()
 		return false;
 	}
 
+	if (NfsFileReader::IsIdle() && next_offset < size)
+		/* no request could be submitted: the buffer is
+		   full */
+		Pause();
+
 	return true;
 }
 
@@ -152,7 +149,7 @@ void
 NfsInputStream::DoSeek(offset_type new_offset)
 {
 	mutex.unlock();
-	NfsFileReader::CancelRead();
+	NfsFileReader::Rewind(new_offset);
 	mutex.lock();
 
 	next_offset = offset = new_offset;
@@ -161,7 +158,7 @@ NfsInputStream::DoSeek(offset_type new_offset)
 }
 
 void
-NfsInputStream::OnNfsFileOpen(uint64_t _size)
+NfsInputStream::OnNfsFileOpen(uint64_t _size, time_t mtime)
 {
 	const ScopeLock protect(mutex);
 
@@ -169,6 +166,7 @@ NfsInputStream::OnNfsFileOpen(uint64_t _size)
 		/* reconnect has succeeded */
 
 		reconnecting = false;
+		NfsFileReader::Rewind(next_offset);
 		DoRead();
 		return;
 	}
@@ -176,6 +174,9 @@ NfsInputStream::OnNfsFileOpen(uint64_t _size)
 	size = _size;
 	seekable = true;
 	next_offset = 0;
+
+	SetModificationTime(mtime);
+
 	SetReady();
 	DoRead();
 }
@@ -185,7 +186,6 @@ NfsInputStream::OnNfsFileRead(const void *data, size_t data_size)
 {
 	const ScopeLock protect(mutex);
 	assert(!IsBufferFull());
-	assert(IsBufferFull() == (GetBufferSpace() == 0));
 	AppendToBuffer(data, data_size);
 
 	next_offset += data_size;
@@ -225,8 +225,22 @@ NfsInputStream::OnNfsFileError(Error &&error)
  */
 
 static InputPlugin::InitResult
-input_nfs_init(const config_param &, Error &)
+input_nfs_init(const config_param &param, Error &error)
 {
+	if (!nfs_buffer_config.Configure(param, error))
+		return InputPlugin::InitResult::ERROR;
+
+	nfs_read_requests = param.GetBlockValue("read_requests",
+						nfs_read_requests);
+	nfs_read_size = param.GetBlockValue("read_size",
+					    unsigned(nfs_read_size / 1024)) * 1024;
+	if (nfs_read_requests == 0 || nfs_read_size == 0) {
+		error.Format(nfs_domain,
+			     "Invalid read-ahead settings in line %d",
+			     param.line);
+		return InputPlugin::InitResult::ERROR;
+	}
+
 	nfs_init();
 	return InputPlugin::InitResult::SUCCESS;
 }
@@ -245,7 +259,7 @@ input_nfs_open(const char *uri,
 	if (!StringStartsWith(uri, "nfs://"))
 		return nullptr;
 
-	void *buffer = HugeAllocate(NFS_MAX_BUFFERED);
+	void *buffer = HugeAllocate(nfs_buffer_config.buffer_size);
 	if (buffer == nullptr) {
 		error.Set(nfs_domain, "Out of memory");
 		return nullptr;
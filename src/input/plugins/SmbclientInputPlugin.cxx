@@ -40,6 +40,8 @@ public:
 		 ctx(_ctx), fd(_fd) {
 		seekable = true;
 		size = st.st_size;
+		SetModificationTime(st.st_mtime);
+
 		SetReady();
 	}
 
@@ -33,9 +33,13 @@
 #include <string.h>
 #include <fcntl.h>
 
-NfsFileReader::NfsFileReader()
-	:DeferredMonitor(io_thread_get()), state(State::INITIAL)
+NfsFileReader::NfsFileReader(unsigned max_reads, size_t read_size)
+	:DeferredMonitor(io_thread_get()), state(State::INITIAL),
+	 window(max_reads, read_size)
 {
+	read_callbacks.reserve(max_reads);
+	for (unsigned i = 0; i < max_reads; ++i)
+		read_callbacks.emplace_back(*this, i);
 }
 
 NfsFileReader::~NfsFileReader()
@@ -59,6 +63,8 @@ NfsFileReader::Close()
 
 	if (state > State::MOUNT && state != State::IDLE)
 		connection->Cancel(*this);
+	else if (state == State::IDLE)
+		CancelReads();
 
 	if (state > State::OPEN)
 		connection->Close(fh);
@@ -108,24 +114,41 @@ NfsFileReader::Open(const char *uri, Error &error)
 }
 
 bool
-NfsFileReader::Read(uint64_t offset, size_t size, Error &error)
+NfsFileReader::Read(size_t space, Error &error)
 {
 	assert(state == State::IDLE);
 
-	if (!connection->Read(fh, offset, size, *this, error))
-		return false;
+	NfsReadWindow::Request request;
+	while (window.Next(space, request)) {
+		if (!connection->Read(fh, request.offset, request.size,
+				      read_callbacks[request.slot], error)) {
+			window.Unsubmit(request.slot);
+			return false;
+		}
+	}
 
-	state = State::READ;
 	return true;
 }
 
 void
-NfsFileReader::CancelRead()
+NfsFileReader::CancelReads()
 {
-	if (state == State::READ) {
-		connection->Cancel(*this);
-		state = State::IDLE;
-	}
+	assert(state == State::IDLE);
+
+	window.ForEachPending([this](unsigned slot){
+			connection->Cancel(read_callbacks[slot]);
+		});
+	window.Reset(window.GetOffset(), file_size);
+}
+
+void
+NfsFileReader::Rewind(uint64_t offset)
+{
+	if (state != State::IDLE)
+		return;
+
+	CancelReads();
+	window.Reset(offset, file_size);
 }
 
 void
@@ -196,12 +219,67 @@ NfsFileReader::StatCallback(const struct stat *st)
 	}
 
 	state = State::IDLE;
+	file_size = st->st_size;
+	window.Reset(0, file_size);
 
-	OnNfsFileOpen(st->st_size);
+	OnNfsFileOpen(st->st_size, st->st_mtime);
+}
+
+inline void
+NfsFileReader::ReadDone(unsigned slot, const void *data, size_t length)
+{
+	assert(state == State::IDLE);
+
+	if (length == 0) {
+		/* the file has been truncated meanwhile */
+		window.Unsubmit(slot);
+		CancelReads();
+		OnNfsFileError(Error(nfs_domain, "Unexpected end of file"));
+		return;
+	}
+
+	if (!window.IsHead(slot)) {
+		/* an earlier request is still pending; keep this
+		   response until it is this one's turn */
+		window.Store(slot, data, length);
+		return;
+	}
+
+	window.Consume(length);
+	OnNfsFileRead(data, length);
+
+	/* now hand out the responses which have arrived before
+	   this one */
+	while (state == State::IDLE && window.GetReady(data, length)) {
+		window.Consume(length);
+		OnNfsFileRead(data, length);
+	}
+}
+
+inline void
+NfsFileReader::ReadFailed(unsigned slot, Error &&error)
+{
+	assert(state == State::IDLE);
+
+	window.Unsubmit(slot);
+	CancelReads();
+	OnNfsFileError(std::move(error));
 }
 
 void
-NfsFileReader::OnNfsCallback(unsigned status, void *data)
+NfsFileReader::ReadCallback::OnNfsCallback(unsigned status, void *data)
+{
+	reader.ReadDone(slot, data, status);
+}
+
+void
+NfsFileReader::ReadCallback::OnNfsError(Error &&error)
+{
+	reader.ReadFailed(slot, std::move(error));
+}
+
+void
+NfsFileReader::OnNfsCallback(gcc_unused unsigned status, void *data)
 {
 	switch (state) {
 	case State::INITIAL:
@@ -218,11 +296,6 @@ NfsFileReader::OnNfsCallback(unsigned status, void *data)
 	case State::STAT:
 		StatCallback((const struct stat *)data);
 		break;
-
-	case State::READ:
-		state = State::IDLE;
-		OnNfsFileRead(data, status);
-		break;
 	}
 }
 
@@ -23,9 +23,11 @@
 #include "check.h"
 #include "Lease.hxx"
 #include "Callback.hxx"
+#include "ReadWindow.hxx"
 #include "event/DeferredMonitor.hxx"
 
 #include <string>
+#include <vector>
 
 #include <stdint.h>
 #include <stddef.h>
@@ -41,10 +43,27 @@ class NfsFileReader : NfsLease, NfsCallback, DeferredMonitor {
 		MOUNT,
 		OPEN,
 		STAT,
-		READ,
 		IDLE,
 	};
 
+	/**
+	 * The #NfsCallback for one slot of the #NfsReadWindow.  Each
+	 * concurrent read needs its own callback object, because
+	 * #NfsConnection allows only one operation per callback.
+	 */
+	class ReadCallback final : public NfsCallback {
+		NfsFileReader &reader;
+		const unsigned slot;
+
+	public:
+		ReadCallback(NfsFileReader &_reader, unsigned _slot)
+			:reader(_reader), slot(_slot) {}
+
+		/* virtual methods from NfsCallback */
+		void OnNfsCallback(unsigned status, void *data) override;
+		void OnNfsError(Error &&error) override;
+	};
+
 	State state;
 
 	std::string server, export_name;
@@ -54,23 +73,51 @@ class NfsFileReader : NfsLease, NfsCallback, DeferredMonitor {
 
 	nfsfh *fh;
 
+	uint64_t file_size;
+
+	NfsReadWindow window;
+	std::vector<ReadCallback> read_callbacks;
+
 public:
-	NfsFileReader();
+	/**
+	 * @param max_reads the maximum number of concurrent read
+	 * requests
+	 * @param read_size the maximum size of one read request
+	 */
+	NfsFileReader(unsigned max_reads=1, size_t read_size=32768);
 	~NfsFileReader();
 
 	void Close();
 	void DeferClose();
 
 	bool Open(const char *uri, Error &error);
-	bool Read(uint64_t offset, size_t size, Error &error);
-	void CancelRead();
 
+	/**
+	 * Submit read requests for the data following the previous
+	 * ones, until the read-ahead window is full.  The responses
+	 * are passed to OnNfsFileRead() in file order.
+	 *
+	 * @param space the number of bytes the caller is able to
+	 * accept, including the data which has been requested
+	 * already but not yet passed to OnNfsFileRead()
+	 */
+	bool Read(size_t space, Error &error);
+
+	/**
+	 * Cancel all pending read requests and continue reading at
+	 * the specified offset.
+	 */
+	void Rewind(uint64_t offset);
+
+	/**
+	 * Is the file open, and no read request is pending?
+	 */
 	bool IsIdle() const {
-		return state == State::IDLE;
+		return state == State::IDLE && window.IsEmpty();
 	}
 
 protected:
-	virtual void OnNfsFileOpen(uint64_t size) = 0;
+	virtual void OnNfsFileOpen(uint64_t size, time_t mtime) = 0;
 	virtual void OnNfsFileRead(const void *data, size_t size) = 0;
 	virtual void OnNfsFileError(Error &&error) = 0;
 
@@ -78,6 +125,10 @@ private:
 	void OpenCallback(nfsfh *_fh);
 	void StatCallback(const struct stat *st);
 
+	void CancelReads();
+	void ReadDone(unsigned slot, const void *data, size_t length);
+	void ReadFailed(unsigned slot, Error &&error);
+
 	/* virtual methods from NfsLease */
 	void OnNfsConnectionReady() final;
 	void OnNfsConnectionFailed(const Error &error) final;
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "ReadWindow.hxx"
+
+#include <algorithm>
+
+#include <assert.h>
+#include <string.h>
+
+NfsReadWindow::NfsReadWindow(unsigned max_requests, size_t _max_size)
+	:max_size(_max_size), slots(max_requests),
+	 head(0), n_active(0),
+	 next_offset(0), end_offset(0), reserved(0)
+{
+	assert(max_requests > 0);
+	assert(max_size > 0);
+}
+
+void
+NfsReadWindow::Reset(uint64_t offset, uint64_t end)
+{
+	head = 0;
+	n_active = 0;
+	next_offset = offset;
+	end_offset = end;
+	reserved = 0;
+}
+
+bool
+NfsReadWindow::Next(size_t space, Request &request)
+{
+	/* first resubmit the rest of a short read; its space has
+	   already been reserved */
+	for (unsigned i = 0; i < n_active; ++i) {
+		const unsigned slot = (head + i) % slots.size();
+		Slot &s = slots[slot];
+		if (s.state == SlotState::QUEUED) {
+			s.state = SlotState::PENDING;
+			request.slot = slot;
+			request.offset = s.offset;
+			request.size = s.size;
+			return true;
+		}
+	}
+
+	if (n_active == slots.size() || next_offset >= end_offset ||
+	    reserved >= space)
+		return false;
+
+	const size_t size = std::min<uint64_t>(std::min(max_size,
+							space - reserved),
+					       end_offset - next_offset);
+
+	const unsigned slot = (head + n_active) % slots.size();
+	Slot &s = slots[slot];
+	s.offset = next_offset;
+	s.size = size;
+	s.state = SlotState::PENDING;
+
+	++n_active;
+	next_offset += size;
+	reserved += size;
+
+	request.slot = slot;
+	request.offset = s.offset;
+	request.size = size;
+	return true;
+}
+
+void
+NfsReadWindow::Unsubmit(unsigned slot)
+{
+	assert(slot < slots.size());
+	assert(slots[slot].state == SlotState::PENDING);
+
+	slots[slot].state = SlotState::QUEUED;
+}
+
+void
+NfsReadWindow::Store(unsigned slot, const void *data, size_t length)
+{
+	assert(slot < slots.size());
+	assert(!IsHead(slot));
+
+	Slot &s = slots[slot];
+	assert(s.state == SlotState::PENDING);
+	assert(length > 0);
+	assert(length <= s.size);
+
+	if (s.buffer == nullptr)
+		s.buffer.reset(new uint8_t[max_size]);
+
+	memcpy(s.buffer.get(), data, length);
+	s.length = length;
+	s.state = SlotState::DONE;
+}
+
+bool
+NfsReadWindow::GetReady(const void *&data, size_t &length) const
+{
+	if (IsEmpty())
+		return false;
+
+	const Slot &s = slots[head];
+	if (s.state != SlotState::DONE)
+		return false;
+
+	data = s.buffer.get();
+	length = s.length;
+	return true;
+}
+
+void
+NfsReadWindow::Consume(size_t length)
+{
+	assert(!IsEmpty());
+
+	Slot &s = slots[head];
+	assert(s.state != SlotState::QUEUED);
+	assert(length > 0);
+	assert(length <= s.size);
+
+	reserved -= length;
+
+	if (length < s.size) {
+		/* short read: request the rest again */
+		s.offset += length;
+		s.size -= length;
+		s.state = SlotState::QUEUED;
+		return;
+	}
+
+	head = (head + 1) % slots.size();
+	--n_active;
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_NFS_READ_WINDOW_HXX
+#define MPD_NFS_READ_WINDOW_HXX
+
+#include "check.h"
+#include "Compiler.h"
+
+#include <memory>
+#include <vector>
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Bookkeeping for several concurrent read requests on one file.
+ * Requests are submitted in file order, but their responses may
+ * arrive in any order; this class keeps a copy of each response
+ * which arrives early, and hands them out in file order.
+ *
+ * This class does not know anything about libnfs; the caller
+ * submits the requests and passes the responses to Store() or
+ * Consume().
+ */
+class NfsReadWindow {
+public:
+	struct Request {
+		unsigned slot;
+		uint64_t offset;
+		size_t size;
+	};
+
+private:
+	enum class SlotState : uint8_t {
+		/**
+		 * The request has not been submitted yet (or must be
+		 * submitted again after a short read).
+		 */
+		QUEUED,
+
+		/**
+		 * The request has been submitted, and the response
+		 * has not yet arrived.
+		 */
+		PENDING,
+
+		/**
+		 * The response has arrived and was copied to
+		 * #buffer.
+		 */
+		DONE,
+	};
+
+	struct Slot {
+		uint64_t offset;
+		size_t size;
+
+		/**
+		 * The number of bytes in #buffer (only valid in state
+		 * DONE).
+		 */
+		size_t length;
+
+		SlotState state;
+
+		/**
+		 * A copy of a response which has arrived before its
+		 * predecessor.  Allocated on demand.
+		 */
+		std::unique_ptr<uint8_t[]> buffer;
+	};
+
+	/**
+	 * The maximum size of one request.
+	 */
+	const size_t max_size;
+
+	/**
+	 * A ring buffer of request slots.  The active slots start at
+	 * #head and are ordered by file offset.
+	 */
+	std::vector<Slot> slots;
+
+	unsigned head, n_active;
+
+	/**
+	 * The file offset of the next new request.
+	 */
+	uint64_t next_offset;
+
+	/**
+	 * The size of the file; no request goes beyond this offset.
+	 */
+	uint64_t end_offset;
+
+	/**
+	 * The sum of all active request sizes.
+	 */
+	size_t reserved;
+
+public:
+	/**
+	 * @param max_requests the maximum number of concurrent
+	 * requests
+	 * @param _max_size the maximum size of one request
+	 */
+	NfsReadWindow(unsigned max_requests, size_t _max_size);
+
+	NfsReadWindow(const NfsReadWindow &) = delete;
+	NfsReadWindow &operator=(const NfsReadWindow &) = delete;
+
+	/**
+	 * Forget all requests and start over at the given offset.
+	 * The caller is responsible for cancelling all pending
+	 * requests first.
+	 */
+	void Reset(uint64_t offset, uint64_t end);
+
+	/**
+	 * Are there no active requests?
+	 */
+	bool IsEmpty() const {
+		return n_active == 0;
+	}
+
+	/**
+	 * Has everything up to the end of the file been handed out?
+	 */
+	bool IsEOF() const {
+		return IsEmpty() && next_offset >= end_offset;
+	}
+
+	/**
+	 * Returns the file offset of the next byte to be handed out.
+	 */
+	gcc_pure
+	uint64_t GetOffset() const {
+		return IsEmpty() ? next_offset : slots[head].offset;
+	}
+
+	/**
+	 * Returns the number of bytes which have been requested but
+	 * not yet handed out.
+	 */
+	size_t GetReserved() const {
+		return reserved;
+	}
+
+	/**
+	 * Determine the next request to be submitted.  The request
+	 * is marked "pending" by this method.
+	 *
+	 * @param space the number of bytes the consumer is able to
+	 * accept, including the requests which are already active
+	 * @return false if no request shall be submitted now
+	 */
+	bool Next(size_t space, Request &request);
+
+	/**
+	 * Submitting the request returned by Next() has failed;
+	 * mark it as "queued" again.
+	 */
+	void Unsubmit(unsigned slot);
+
+	/**
+	 * Is this (pending) request the first one in file order?  Its
+	 * response can then be handed out directly, without copying
+	 * it; see Consume().
+	 */
+	gcc_pure
+	bool IsHead(unsigned slot) const {
+		return !IsEmpty() && slot == head &&
+			slots[head].state == SlotState::PENDING;
+	}
+
+	/**
+	 * Copy the response of a request which is not the head.
+	 *
+	 * @param length the number of bytes received; may be less
+	 * than requested, but must not be zero
+	 */
+	void Store(unsigned slot, const void *data, size_t length);
+
+	/**
+	 * Obtain the response of the head request if it has already
+	 * been received and stored.
+	 *
+	 * @return false if the head response is not available yet
+	 */
+	bool GetReady(const void *&data, size_t &length) const;
+
+	/**
+	 * The head response (either received directly or obtained
+	 * from GetReady()) has been handed out to the consumer.  If
+	 * it was shorter than requested, the rest is queued again to
+	 * be submitted by the next Next() call; otherwise the slot is
+	 * released.
+	 */
+	void Consume(size_t length);
+
+	/**
+	 * Invoke the given function for each pending request slot.
+	 */
+	template<typename F>
+	void ForEachPending(F &&f) const {
+		for (unsigned i = 0; i < n_active; ++i) {
+			const unsigned slot = (head + i) % slots.size();
+			if (slots[slot].state == SlotState::PENDING)
+				f(slot);
+		}
+	}
+};
+
+#endif
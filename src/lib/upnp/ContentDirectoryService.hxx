@@ -121,6 +121,13 @@ public:
 				   std::list<std::string> &result,
 				   Error &error) const;
 
+	/**
+	 * Obtain the "SystemUpdateID" state variable, which changes
+	 * whenever the server's content is modified.
+	 */
+	bool getSystemUpdateID(UpnpClient_Handle handle, unsigned &result,
+			       Error &error) const;
+
 	gcc_pure
 	std::string GetURI() const {
 		return "upnp://" + m_deviceId + "/" + m_serviceType;
@@ -63,6 +63,8 @@ AudioOutput::AudioOutput(const AudioOutputPlugin &_plugin)
 	assert(plugin.open != nullptr);
 	assert(plugin.close != nullptr);
 	assert(plugin.play != nullptr);
+
+	stats.Clear();
 }
 
 static const AudioOutputPlugin *
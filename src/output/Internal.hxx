@@ -20,6 +20,7 @@
 #ifndef MPD_OUTPUT_INTERNAL_HXX
 #define MPD_OUTPUT_INTERNAL_HXX
 
+#include "OutputStats.hxx"
 #include "AudioFormat.hxx"
 #include "pcm/PcmBuffer.hxx"
 #include "pcm/PcmDither.hxx"
@@ -269,6 +270,12 @@ struct AudioOutput {
 	 */
 	bool current_chunk_finished;
 
+	/**
+	 * Latency and underrun statistics, updated by the output
+	 * thread after each play() call.  Protected by #mutex.
+	 */
+	AudioOutputStats stats;
+
 	AudioOutput(const AudioOutputPlugin &_plugin);
 	~AudioOutput();
 
@@ -342,6 +349,14 @@ struct AudioOutput {
 
 	void SetReplayGainMode(ReplayGainMode mode);
 
+	/**
+	 * Returns a copy of #stats.
+	 */
+	AudioOutputStats LockGetStats() {
+		const ScopeLock protect(mutex);
+		return stats;
+	}
+
 	/**
 	 * Caller must lock the mutex.
 	 */
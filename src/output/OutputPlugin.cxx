@@ -20,6 +20,7 @@
 #include "config.h"
 #include "OutputPlugin.hxx"
 #include "Internal.hxx"
+#include "OutputStats.hxx"
 
 AudioOutput *
 ao_plugin_init(const AudioOutputPlugin *plugin,
@@ -107,3 +108,10 @@ ao_plugin_pause(AudioOutput *ao)
 {
 	return ao->plugin.pause != nullptr && ao->plugin.pause(ao);
 }
+
+bool
+ao_plugin_get_stats(AudioOutput *ao, AudioOutputStats &stats)
+{
+	return ao->plugin.get_stats != nullptr &&
+		ao->plugin.get_stats(ao, stats);
+}
@@ -28,6 +28,7 @@ struct config_param;
 struct AudioFormat;
 struct Tag;
 struct AudioOutput;
+struct AudioOutputStats;
 struct MixerPlugin;
 class Error;
 
@@ -142,6 +143,15 @@ struct AudioOutputPlugin {
 	 */
 	bool (*pause)(AudioOutput *data);
 
+	/**
+	 * Query the device's current latency and underrun counter.
+	 * This method is optional.  It is called by the output
+	 * thread after each play() call.
+	 *
+	 * @return false if no statistics are available
+	 */
+	bool (*get_stats)(AudioOutput *data, AudioOutputStats &stats);
+
 	/**
 	 * The mixer plugin associated with this output plugin.  This
 	 * may be nullptr if no mixer plugin is implemented.  When
@@ -201,4 +211,7 @@ ao_plugin_cancel(AudioOutput *ao);
 bool
 ao_plugin_pause(AudioOutput *ao);
 
+bool
+ao_plugin_get_stats(AudioOutput *ao, AudioOutputStats &stats);
+
 #endif
@@ -41,3 +41,18 @@ printAudioDevices(Client &client, const MultipleOutputs &outputs)
 			      i, ao.name, ao.enabled);
 	}
 }
+
+void
+printAudioOutputStats(Client &client, MultipleOutputs &outputs)
+{
+	for (unsigned i = 0, n = outputs.Size(); i != n; ++i) {
+		AudioOutput &ao = outputs.Get(i);
+		const AudioOutputStats stats = ao.LockGetStats();
+
+		client_printf(client,
+			      "outputid: %i\n"
+			      "latency: %.3f\n"
+			      "underruns: %u\n",
+			      i, stats.latency_ns / 1e9, stats.underruns);
+	}
+}
@@ -31,4 +31,10 @@ class MultipleOutputs;
 void
 printAudioDevices(Client &client, const MultipleOutputs &outputs);
 
+/**
+ * Print the latency and underrun counters of all outputs.
+ */
+void
+printAudioOutputStats(Client &client, MultipleOutputs &outputs);
+
 #endif
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_OUTPUT_STATS_HXX
+#define MPD_OUTPUT_STATS_HXX
+
+#include <stdint.h>
+
+/**
+ * Runtime statistics of an audio output device, as reported by
+ * AudioOutputPlugin::get_stats().
+ */
+struct AudioOutputStats {
+	/**
+	 * The current latency of the device in nanoseconds, i.e. how
+	 * long it takes until data submitted with play() becomes
+	 * audible.  0 if unknown.
+	 */
+	uint64_t latency_ns;
+
+	/**
+	 * The number of buffer underruns (xruns) since the device
+	 * was enabled.
+	 */
+	unsigned underruns;
+
+	void Clear() {
+		latency_ns = 0;
+		underruns = 0;
+	}
+};
+
+#endif
@@ -211,6 +211,7 @@ AudioOutput::Close(bool drain)
 
 	current_chunk = nullptr;
 	open = false;
+	stats.latency_ns = 0;
 
 	mutex.unlock();
 
@@ -251,6 +252,7 @@ AudioOutput::ReopenFilter()
 
 		current_chunk = nullptr;
 		open = false;
+		stats.latency_ns = 0;
 		fail_timer.Update();
 
 		mutex.unlock();
@@ -426,10 +428,17 @@ AudioOutput::PlayChunk(const MusicChunk *chunk)
 		if (!WaitForDelay())
 			break;
 
+		AudioOutputStats new_stats = stats;
+
 		mutex.unlock();
 		size_t nbytes = ao_plugin_play(this, data.data, data.size,
 					       error);
+		const bool have_stats = nbytes > 0 &&
+			ao_plugin_get_stats(this, new_stats);
 		mutex.lock();
+
+		if (have_stats)
+			stats = new_stats;
 		if (nbytes == 0) {
 			/* play()==0 means failure */
 			FormatError(error, "\"%s\" [%s] failed to play",
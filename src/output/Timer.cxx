@@ -27,40 +27,50 @@
 #include <assert.h>
 
 Timer::Timer(const AudioFormat af)
-	: time(0),
+	: time(0), remainder(0),
 	  started(false),
-	 rate(af.sample_rate * af.GetFrameSize())
+	  rate(af.sample_rate * af.GetFrameSize())
 {
 }
 
 void Timer::Start()
 {
-	time = MonotonicClockUS();
+	time = MonotonicClockNS();
+	remainder = 0;
 	started = true;
 }
 
 void Timer::Reset()
 {
 	time = 0;
+	remainder = 0;
 	started = false;
 }
 
-void Timer::Add(int size)
+void Timer::Add(size_t size)
 {
 	assert(started);
 
-	// (size samples) / (rate samples per second) = duration seconds
-	// duration seconds * 1000000 = duration us
-	time += ((uint64_t)size * 1000000) / rate;
+	// (size bytes) / (rate bytes per second) = duration seconds
+	// duration seconds * 1000000000 = duration ns
+	const uint64_t ns = (uint64_t)size * 1000000000 + remainder;
+	time += ns / rate;
+	remainder = ns % rate;
 }
 
-unsigned Timer::GetDelay() const
+uint64_t
+Timer::GetDelayNS() const
 {
-	int64_t delay = (int64_t)(time - MonotonicClockUS()) / 1000;
-	if (delay < 0)
-		return 0;
+	const uint64_t now = MonotonicClockNS();
+	return time > now
+		? time - now
+		: 0;
+}
 
-	if (delay > std::numeric_limits<int>::max())
+unsigned Timer::GetDelay() const
+{
+	uint64_t delay = GetDelayNS() / 1000000;
+	if (delay > (uint64_t)std::numeric_limits<int>::max())
 		delay = std::numeric_limits<int>::max();
 
 	return delay;
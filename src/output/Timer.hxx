@@ -20,14 +20,28 @@
 #ifndef MPD_TIMER_HXX
 #define MPD_TIMER_HXX
 
+#include "Compiler.h"
+
 #include <stdint.h>
+#include <stddef.h>
 
 struct AudioFormat;
 
 class Timer {
+	/**
+	 * The monotonic time (in nanoseconds) at which all data
+	 * passed to Add() will have been played.
+	 */
 	uint64_t time;
+
+	/**
+	 * The remainder of the last division in Add(), carried over
+	 * to the next call, so rounding errors do not accumulate.
+	 */
+	uint64_t remainder;
+
 	bool started;
-	const int rate;
+	const unsigned rate;
 public:
 	explicit Timer(AudioFormat af);
 
@@ -36,11 +50,20 @@ public:
 	void Start();
 	void Reset();
 
-	void Add(int size);
+	void Add(size_t size);
+
+	/**
+	 * Returns the number of nanoseconds this timer is ahead of
+	 * the clock, i.e. the duration of the data which has been
+	 * "played" but would not be audible yet on a real device.
+	 */
+	gcc_pure
+	uint64_t GetDelayNS() const;
 
 	/**
 	 * Returns the number of milliseconds to sleep to get back to sync.
 	 */
+	gcc_pure
 	unsigned GetDelay() const;
 };
 
@@ -20,6 +20,7 @@
 #include "config.h"
 #include "AlsaOutputPlugin.hxx"
 #include "../OutputAPI.hxx"
+#include "../OutputStats.hxx"
 #include "mixer/MixerList.hxx"
 #include "pcm/PcmExport.hxx"
 #include "config/ConfigError.hxx"
@@ -97,6 +98,12 @@ struct AlsaOutput {
 	 */
 	size_t out_frame_size;
 
+	/**
+	 * The sample rate negotiated with libasound.  Used to convert
+	 * snd_pcm_delay() frames to a duration.
+	 */
+	unsigned sample_rate;
+
 	/**
 	 * The size of one period, in number of frames.
 	 */
@@ -119,6 +126,12 @@ struct AlsaOutput {
 	 */
 	bool must_prepare;
 
+	/**
+	 * The number of underruns (-EPIPE) seen since the device was
+	 * enabled.
+	 */
+	unsigned underruns;
+
 	/**
 	 * This buffer gets allocated after opening the ALSA device.
 	 * It contains silence samples, enough to fill one period (see
@@ -208,6 +221,7 @@ alsa_output_enable(AudioOutput *ao, gcc_unused Error &error)
 	AlsaOutput *ad = (AlsaOutput *)ao;
 
 	ad->pcm_export.Construct();
+	ad->underruns = 0;
 	return true;
 }
 
@@ -504,6 +518,7 @@ configure_hw:
 		return false;
 	}
 	audio_format.sample_rate = sample_rate;
+	ad->sample_rate = sample_rate;
 
 	snd_pcm_uframes_t buffer_size_min, buffer_size_max;
 	snd_pcm_hw_params_get_buffer_size_min(hwparams, &buffer_size_min);
@@ -743,6 +758,7 @@ static int
 alsa_recover(AlsaOutput *ad, int err)
 {
 	if (err == -EPIPE) {
+		++ad->underruns;
 		FormatDebug(alsa_output_domain,
 			    "Underrun on ALSA device \"%s\"", alsa_device(ad));
 	} else if (err == -ESTRPIPE) {
@@ -875,6 +891,21 @@ alsa_play(AudioOutput *ao, const void *chunk, size_t size,
 	}
 }
 
+static bool
+alsa_get_stats(AudioOutput *ao, AudioOutputStats &stats)
+{
+	AlsaOutput *ad = (AlsaOutput *)ao;
+
+	stats.underruns = ad->underruns;
+
+	snd_pcm_sframes_t delay;
+	if (snd_pcm_delay(ad->pcm, &delay) < 0 || delay < 0)
+		delay = 0;
+
+	stats.latency_ns = (uint64_t)delay * 1000000000 / ad->sample_rate;
+	return true;
+}
+
 const struct AudioOutputPlugin alsa_output_plugin = {
 	"alsa",
 	alsa_test_default_device,
@@ -890,6 +921,7 @@ const struct AudioOutputPlugin alsa_output_plugin = {
 	alsa_drain,
 	alsa_cancel,
 	nullptr,
+	alsa_get_stats,
 
 	&alsa_mixer_plugin,
 };
@@ -21,6 +21,7 @@
 #include "FifoOutputPlugin.hxx"
 #include "config/ConfigError.hxx"
 #include "../OutputAPI.hxx"
+#include "../OutputStats.hxx"
 #include "../Timer.hxx"
 #include "fs/AllocatedPath.hxx"
 #include "fs/FileSystem.hxx"
@@ -255,6 +256,17 @@ fifo_output_delay(AudioOutput *ao)
 		: 0;
 }
 
+static bool
+fifo_output_get_stats(AudioOutput *ao, AudioOutputStats &stats)
+{
+	FifoOutput *fd = (FifoOutput *)ao;
+
+	stats.latency_ns = fd->timer->IsStarted()
+		? fd->timer->GetDelayNS()
+		: 0;
+	return true;
+}
+
 static size_t
 fifo_output_play(AudioOutput *ao, const void *chunk, size_t size,
 		 Error &error)
@@ -303,5 +315,6 @@ const struct AudioOutputPlugin fifo_output_plugin = {
 	nullptr,
 	fifo_output_cancel,
 	nullptr,
+	fifo_output_get_stats,
 	nullptr,
 };
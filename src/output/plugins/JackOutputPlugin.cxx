@@ -759,4 +759,5 @@ const struct AudioOutputPlugin jack_output_plugin = {
 	nullptr,
 	mpd_jack_pause,
 	nullptr,
+	nullptr,
 };
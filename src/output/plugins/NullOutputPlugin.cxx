@@ -20,6 +20,7 @@
 #include "config.h"
 #include "NullOutputPlugin.hxx"
 #include "../OutputAPI.hxx"
+#include "../OutputStats.hxx"
 #include "../Timer.hxx"
 
 struct NullOutput {
@@ -91,6 +92,20 @@ null_delay(AudioOutput *ao)
 		: 0;
 }
 
+static bool
+null_get_stats(AudioOutput *ao, AudioOutputStats &stats)
+{
+	NullOutput *nd = (NullOutput *)ao;
+
+	if (!nd->sync)
+		return false;
+
+	stats.latency_ns = nd->timer->IsStarted()
+		? nd->timer->GetDelayNS()
+		: 0;
+	return true;
+}
+
 static size_t
 null_play(AudioOutput *ao, gcc_unused const void *chunk, size_t size,
 	  gcc_unused Error &error)
@@ -134,5 +149,6 @@ const struct AudioOutputPlugin null_output_plugin = {
 	nullptr,
 	null_cancel,
 	nullptr,
+	null_get_stats,
 	nullptr,
 };
@@ -279,4 +279,5 @@ const struct AudioOutputPlugin openal_output_plugin = {
 	openal_cancel,
 	nullptr,
 	nullptr,
+	nullptr,
 };
@@ -774,6 +774,7 @@ const struct AudioOutputPlugin oss_output_plugin = {
 	nullptr,
 	oss_output_cancel,
 	nullptr,
+	nullptr,
 
 	&oss_mixer_plugin,
 };
@@ -140,4 +140,5 @@ const struct AudioOutputPlugin pipe_output_plugin = {
 	nullptr,
 	nullptr,
 	nullptr,
+	nullptr,
 };
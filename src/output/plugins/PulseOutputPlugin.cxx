@@ -20,6 +20,7 @@
 #include "config.h"
 #include "PulseOutputPlugin.hxx"
 #include "../OutputAPI.hxx"
+#include "../OutputStats.hxx"
 #include "mixer/MixerList.hxx"
 #include "mixer/plugins/PulseMixerPlugin.hxx"
 #include "util/Error.hxx"
@@ -55,8 +56,14 @@ struct PulseOutput {
 
 	size_t writable;
 
+	/**
+	 * The number of underflow notifications received from the
+	 * server.  Protected by the main loop lock.
+	 */
+	unsigned underruns;
+
 	PulseOutput()
-		:base(pulse_output_plugin) {}
+		:base(pulse_output_plugin), underruns(0) {}
 };
 
 static constexpr Domain pulse_output_domain("pulse_output");
@@ -260,6 +267,7 @@ pulse_output_delete_stream(PulseOutput *po)
 
 	pa_stream_set_state_callback(po->stream, nullptr, nullptr);
 	pa_stream_set_write_callback(po->stream, nullptr, nullptr);
+	pa_stream_set_underflow_callback(po->stream, nullptr, nullptr);
 
 	pa_stream_disconnect(po->stream);
 	pa_stream_unref(po->stream);
@@ -285,6 +293,14 @@ pulse_output_delete_context(PulseOutput *po)
 	po->context = nullptr;
 }
 
+static void
+pulse_output_stream_underflow_cb(gcc_unused pa_stream *stream, void *userdata)
+{
+	PulseOutput *po = (PulseOutput *)userdata;
+
+	++po->underruns;
+}
+
 /**
  * Create, set up and connect a context.
  *
@@ -536,6 +552,8 @@ pulse_output_setup_stream(PulseOutput *po, const pa_sample_spec *ss,
 				     pulse_output_stream_state_cb, po);
 	pa_stream_set_write_callback(po->stream,
 				     pulse_output_stream_write_cb, po);
+	pa_stream_set_underflow_callback(po->stream,
+					 pulse_output_stream_underflow_cb, po);
 
 	return true;
 }
@@ -590,10 +608,15 @@ pulse_output_open(AudioOutput *ao, AudioFormat &audio_format,
 		return false;
 	}
 
-	/* .. and connect it (asynchronously) */
+	/* .. and connect it (asynchronously); the timing flags
+	   allow pulse_output_get_stats() to query the latency
+	   without a server round-trip */
 
+	const pa_stream_flags_t flags =
+		pa_stream_flags_t(PA_STREAM_INTERPOLATE_TIMING |
+				  PA_STREAM_AUTO_TIMING_UPDATE);
 	if (pa_stream_connect_playback(po->stream, po->sink,
-				       nullptr, pa_stream_flags_t(0),
+				       nullptr, flags,
 				       nullptr, nullptr) < 0) {
 		pulse_output_delete_stream(po);
 
@@ -845,6 +868,28 @@ pulse_output_pause(AudioOutput *ao)
 	return true;
 }
 
+static bool
+pulse_output_get_stats(AudioOutput *ao, AudioOutputStats &stats)
+{
+	PulseOutput *po = (PulseOutput *)ao;
+
+	pa_threaded_mainloop_lock(po->mainloop);
+
+	stats.underruns = po->underruns;
+
+	pa_usec_t latency;
+	int negative;
+	if (po->stream == nullptr ||
+	    pa_stream_get_latency(po->stream, &latency, &negative) < 0 ||
+	    negative)
+		latency = 0;
+
+	pa_threaded_mainloop_unlock(po->mainloop);
+
+	stats.latency_ns = (uint64_t)latency * 1000;
+	return true;
+}
+
 static bool
 pulse_output_test_default_device(void)
 {
@@ -877,6 +922,7 @@ const struct AudioOutputPlugin pulse_output_plugin = {
 	nullptr,
 	pulse_output_cancel,
 	pulse_output_pause,
+	pulse_output_get_stats,
 
 	&pulse_mixer_plugin,
 };
@@ -255,4 +255,5 @@ const struct AudioOutputPlugin recorder_output_plugin = {
 	nullptr,
 	nullptr,
 	nullptr,
+	nullptr,
 };
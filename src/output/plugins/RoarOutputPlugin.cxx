@@ -425,5 +425,6 @@ const struct AudioOutputPlugin roar_output_plugin = {
 	nullptr,
 	roar_cancel,
 	nullptr,
+	nullptr,
 	&roar_mixer_plugin,
 };
@@ -534,4 +534,5 @@ const struct AudioOutputPlugin shout_output_plugin = {
 	my_shout_drop_buffered_audio,
 	my_shout_pause,
 	nullptr,
+	nullptr,
 };
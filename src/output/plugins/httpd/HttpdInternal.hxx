@@ -230,6 +230,17 @@ public:
 	gcc_pure
 	unsigned Delay() const;
 
+	/**
+	 * Returns how far the #timer is ahead of the clock, in
+	 * nanoseconds.
+	 */
+	gcc_pure
+	uint64_t GetLatencyNS() const {
+		return timer->IsStarted()
+			? timer->GetDelayNS()
+			: 0;
+	}
+
 	/**
 	 * Reads data from the encoder (as much as available) and
 	 * returns it as a new #page object.
@@ -22,6 +22,7 @@
 #include "HttpdInternal.hxx"
 #include "HttpdClient.hxx"
 #include "output/OutputAPI.hxx"
+#include "output/OutputStats.hxx"
 #include "encoder/EncoderPlugin.hxx"
 #include "encoder/EncoderList.hxx"
 #include "system/Resolver.hxx"
@@ -582,6 +583,15 @@ httpd_output_cancel(AudioOutput *ao)
 		});
 }
 
+static bool
+httpd_output_get_stats(AudioOutput *ao, AudioOutputStats &stats)
+{
+	HttpdOutput *httpd = HttpdOutput::Cast(ao);
+
+	stats.latency_ns = httpd->GetLatencyNS();
+	return true;
+}
+
 const struct AudioOutputPlugin httpd_output_plugin = {
 	"httpd",
 	nullptr,
@@ -597,5 +607,6 @@ const struct AudioOutputPlugin httpd_output_plugin = {
 	nullptr,
 	httpd_output_cancel,
 	httpd_output_pause,
+	httpd_output_get_stats,
 	nullptr,
 };
@@ -536,4 +536,5 @@ const struct AudioOutputPlugin sles_output_plugin = {
 	sles_output_cancel,
 	sles_output_pause,
 	nullptr,
+	nullptr,
 };
@@ -41,6 +41,9 @@ playlist_open_in_playlist_dir(const char *uri, Mutex &mutex, Cond &cond)
 	if (path_fs.IsNull())
 		return nullptr;
 
+	/* the file is read directly, so it must be up to date */
+	spl_flush(uri);
+
 	return playlist_open_path(path_fs.c_str(), mutex, cond);
 }
 
@@ -31,6 +31,7 @@
 #include "tag/TagHandler.hxx"
 #include "tag/TagId3.hxx"
 #include "tag/ApeTag.hxx"
+#include "tag/TagFileBuffer.hxx"
 #include "DetachedSong.hxx"
 #include "TagFile.hxx"
 #include "fs/Traits.hxx"
@@ -105,9 +106,13 @@ embcue_playlist_open_uri(const char *uri,
 
 	tag_file_scan(path_fs, embcue_tag_handler, playlist);
 	if (playlist->cuesheet.empty()) {
-		tag_ape_scan2(path_fs, &embcue_tag_handler, playlist);
-		if (playlist->cuesheet.empty())
-			tag_id3_scan(path_fs, &embcue_tag_handler, playlist);
+		TagFileBuffer file(path_fs);
+		if (file.IsDefined()) {
+			tag_ape_scan2(file, &embcue_tag_handler, playlist);
+			if (playlist->cuesheet.empty())
+				tag_id3_scan(file, &embcue_tag_handler,
+					     playlist);
+		}
 	}
 
 	if (playlist->cuesheet.empty()) {
@@ -23,9 +23,6 @@
 
 #include <assert.h>
 
-const char *current_command;
-int command_list_num;
-
 void
 command_success(Client &client)
 {
@@ -36,14 +33,15 @@ void
 command_error_v(Client &client, enum ack error,
 		const char *fmt, va_list args)
 {
-	assert(current_command != nullptr);
+	assert(client.current_command != nullptr);
 
 	client_printf(client, "ACK [%i@%i] {%s} ",
-		      (int)error, command_list_num, current_command);
+		      (int)error, client.command_list_num,
+		      client.current_command);
 	client_vprintf(client, fmt, args);
 	client_puts(client, "\n");
 
-	current_command = nullptr;
+	client.current_command = nullptr;
 }
 
 void
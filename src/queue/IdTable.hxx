@@ -22,69 +22,206 @@
 
 #include "Compiler.h"
 
-#include <algorithm>
-
 #include <assert.h>
 
 /**
  * A table that maps id numbers to position numbers.
+ *
+ * Ids are handed out in ascending order, and wrap around only after
+ * the whole id range (the specified maximum size) has been used, so
+ * a deleted id is not reused soon.  The mapping is an open
+ * addressing hash table whose capacity follows the number of ids in
+ * use, not the id range.
  */
 class IdTable {
-	unsigned size;
+	/**
+	 * The minimum capacity of the hash table; must be a power of
+	 * two.
+	 */
+	static constexpr unsigned INITIAL_CAPACITY = 64;
+
+	struct Slot {
+		/**
+		 * The id stored in this slot, or 0 if the slot is
+		 * empty.
+		 */
+		unsigned id;
+
+		int position;
+	};
+
+	/**
+	 * Ids are in the range [1, max_size).
+	 */
+	const unsigned max_size;
 
 	unsigned next;
 
-	int *data;
+	/**
+	 * The number of ids which are currently in use.
+	 */
+	unsigned n_used;
+
+	/**
+	 * The number of elements in #slots; a power of two.
+	 */
+	unsigned capacity;
+
+	Slot *slots;
 
 public:
-	IdTable(unsigned _size):size(_size), next(1), data(new int[size]) {
-		std::fill_n(data, size, -1);
+	IdTable(unsigned _max_size)
+		:max_size(_max_size),
+		 next(1), n_used(0),
+		 capacity(INITIAL_CAPACITY),
+		 slots(NewSlots(capacity)) {
+		assert(max_size > 1);
 	}
 
 	~IdTable() {
-		delete[] data;
+		delete[] slots;
 	}
 
+	IdTable(const IdTable &) = delete;
+	IdTable &operator=(const IdTable &) = delete;
+
+	gcc_pure
+	unsigned GetCapacity() const {
+		return capacity;
+	}
+
+	gcc_pure
 	int IdToPosition(unsigned id) const {
-		return id < size
-			? data[id]
+		const Slot *slot = Find(id);
+		return slot != nullptr
+			? slot->position
 			: -1;
 	}
 
 	unsigned GenerateId() {
 		assert(next > 0);
-		assert(next < size);
+		assert(next < max_size);
+		assert(n_used + 1 < max_size);
 
 		while (true) {
-			unsigned id = next;
-
-			++next;
-			if (next == size)
+			unsigned id = next++;
+			if (next == max_size)
 				next = 1;
 
-			if (data[id] < 0)
+			if (Find(id) == nullptr)
 				return id;
 		}
 	}
 
 	unsigned Insert(unsigned position) {
 		unsigned id = GenerateId();
-		data[id] = position;
+
+		/* keep the load factor at 1/2 or below */
+		if ((n_used + 1) * 2 > capacity)
+			Resize(capacity * 2);
+
+		Put(id, position);
+		++n_used;
 		return id;
 	}
 
 	void Move(unsigned id, unsigned position) {
-		assert(id < size);
-		assert(data[id] >= 0);
+		Slot *slot = Find(id);
+		assert(slot != nullptr);
 
-		data[id] = position;
+		slot->position = position;
 	}
 
 	void Erase(unsigned id) {
-		assert(id < size);
-		assert(data[id] >= 0);
+		Slot *slot = Find(id);
+		assert(slot != nullptr);
+		assert(n_used > 0);
+
+		Remove(slot - slots);
+		--n_used;
+
+		if (capacity > INITIAL_CAPACITY && n_used * 8 < capacity)
+			Resize(capacity / 2);
+	}
+
+private:
+	static Slot *NewSlots(unsigned n) {
+		Slot *s = new Slot[n];
+		for (unsigned i = 0; i < n; ++i)
+			s[i].id = 0;
+		return s;
+	}
+
+	/**
+	 * The preferred slot of an id.  Ids are allocated
+	 * sequentially, so their low bits are a good hash.
+	 */
+	unsigned Home(unsigned id) const {
+		return id & (capacity - 1);
+	}
+
+	gcc_pure
+	const Slot *Find(unsigned id) const {
+		if (id == 0)
+			return nullptr;
+
+		for (unsigned i = Home(id);; i = (i + 1) & (capacity - 1)) {
+			const Slot &slot = slots[i];
+			if (slot.id == id)
+				return &slot;
+
+			if (slot.id == 0)
+				return nullptr;
+		}
+	}
+
+	gcc_pure
+	Slot *Find(unsigned id) {
+		return const_cast<Slot *>(((const IdTable *)this)->Find(id));
+	}
+
+	void Put(unsigned id, int position) {
+		unsigned i = Home(id);
+		while (slots[i].id != 0)
+			i = (i + 1) & (capacity - 1);
+
+		slots[i].id = id;
+		slots[i].position = position;
+	}
+
+	/**
+	 * Clear a slot, and move following entries of the same probe
+	 * sequence into the gap, so lookups need no tombstones.
+	 */
+	void Remove(unsigned i) {
+		const unsigned mask = capacity - 1;
+
+		for (unsigned j = (i + 1) & mask; slots[j].id != 0;
+		     j = (j + 1) & mask) {
+			/* the entry at j may move to i only if its home
+			   slot is not within (i, j] */
+			const unsigned home = Home(slots[j].id);
+			if (((j - home) & mask) >= ((j - i) & mask)) {
+				slots[i] = slots[j];
+				i = j;
+			}
+		}
+
+		slots[i].id = 0;
+	}
+
+	void Resize(unsigned new_capacity) {
+		Slot *const old_slots = slots;
+		const unsigned old_capacity = capacity;
+
+		slots = NewSlots(new_capacity);
+		capacity = new_capacity;
+
+		for (unsigned i = 0; i < old_capacity; ++i)
+			if (old_slots[i].id != 0)
+				Put(old_slots[i].id, old_slots[i].position);
 
-		data[id] = -1;
+		delete[] old_slots;
 	}
 };
 
@@ -181,8 +181,15 @@ public:
 			   Error &error);
 
 protected:
+	/**
+	 * Removes a range of songs from the queue, and updates the
+	 * "current" song.  If the current song is deleted while
+	 * playing, playback continues with the next song which
+	 * survives.
+	 */
 	void DeleteInternal(PlayerControl &pc,
-			    unsigned song, const DetachedSong **queued_p);
+			    unsigned start, unsigned end,
+			    const DetachedSong **queued_p);
 
 public:
 	PlaylistResult DeletePosition(PlayerControl &pc,
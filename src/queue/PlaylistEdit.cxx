@@ -230,22 +230,53 @@ playlist::SetPriorityId(PlayerControl &pc,
 
 void
 playlist::DeleteInternal(PlayerControl &pc,
-			 unsigned song, const DetachedSong **queued_p)
+			 unsigned start, unsigned end,
+			 const DetachedSong **queued_p)
 {
-	assert(song < GetLength());
+	assert(start < end);
+	assert(end <= GetLength());
 
-	unsigned songOrder = queue.PositionToOrder(song);
+	const int current_position = GetCurrentPosition();
+	const bool current_deleted = current_position >= int(start) &&
+		current_position < int(end);
+	const bool paused = pc.GetState() == PlayerState::PAUSE;
+
+	/* remember the new "current" song by its id, because order
+	   numbers change while the queue is being compacted */
+
+	int current_id = -1;
+	if (current_deleted) {
+		if (playing) {
+			/* the current song is going to be deleted: see
+			   which song is going to be played instead */
+
+			int next = current;
+			do {
+				next = queue.GetNextOrder(next);
+				if (next == current)
+					/* wrapped around: no song left */
+					next = -1;
+			} while (next >= 0 &&
+				 queue.OrderToPosition(next) >= start &&
+				 queue.OrderToPosition(next) < end);
+
+			if (next >= 0)
+				current_id = queue.PositionToId(queue.OrderToPosition(next));
+		}
+	} else if (current_position >= 0)
+		current_id = queue.PositionToId(current_position);
 
-	if (playing && current == (int)songOrder) {
-		const bool paused = pc.GetState() == PlayerState::PAUSE;
+	/* now do it: remove the songs */
 
-		/* the current song is going to be deleted: see which
-		   song is going to be played instead */
+	queue.DeleteRange(start, end);
+
+	/* update the "current" and "queued" variables */
 
-		current = queue.GetNextOrder(current);
-		if (current == (int)songOrder)
-			current = -1;
+	current = current_id >= 0
+		? (int)queue.PositionToOrder(queue.IdToPosition(current_id))
+		: -1;
 
+	if (current_deleted && playing) {
 		if (current >= 0 && !paused)
 			/* play the song after the deleted one */
 			PlayOrder(pc, current);
@@ -257,19 +288,7 @@ playlist::DeleteInternal(PlayerControl &pc,
 		}
 
 		*queued_p = nullptr;
-	} else if (current == (int)songOrder)
-		/* there's a "current song" but we're not playing
-		   currently - clear "current" */
-		current = -1;
-
-	/* now do it: remove the song */
-
-	queue.DeletePosition(song);
-
-	/* update the "current" and "queued" variables */
-
-	if (current > (int)songOrder)
-		current--;
+	}
 }
 
 PlaylistResult
@@ -280,7 +299,7 @@ playlist::DeletePosition(PlayerControl &pc, unsigned song)
 
 	const DetachedSong *queued_song = GetQueuedSong();
 
-	DeleteInternal(pc, song, &queued_song);
+	DeleteInternal(pc, song, song + 1, &queued_song);
 
 	UpdateQueuedSong(pc, queued_song);
 	OnModified();
@@ -302,9 +321,7 @@ playlist::DeleteRange(PlayerControl &pc, unsigned start, unsigned end)
 
 	const DetachedSong *queued_song = GetQueuedSong();
 
-	do {
-		DeleteInternal(pc, --end, &queued_song);
-	} while (end != start);
+	DeleteInternal(pc, start, end, &queued_song);
 
 	UpdateQueuedSong(pc, queued_song);
 	OnModified();
@@ -325,9 +342,19 @@ playlist::DeleteId(PlayerControl &pc, unsigned id)
 void
 playlist::DeleteSong(PlayerControl &pc, const char *uri)
 {
-	for (int i = queue.GetLength() - 1; i >= 0; --i)
-		if (queue.Get(i).IsURI(uri))
-			DeletePosition(pc, i);
+	/* delete each run of matching songs with one call, starting
+	   at the end */
+
+	for (int i = queue.GetLength() - 1; i >= 0; --i) {
+		if (!queue.Get(i).IsURI(uri))
+			continue;
+
+		const unsigned end = i + 1;
+		while (i > 0 && queue.Get(i - 1).IsURI(uri))
+			--i;
+
+		DeleteRange(pc, i, end);
+	}
 }
 
 PlaylistResult
@@ -21,25 +21,28 @@
 #include "Queue.hxx"
 #include "DetachedSong.hxx"
 
+#include <limits>
+
 Queue::Queue(unsigned _max_length)
-	:max_length(_max_length), length(0),
+	:max_length(_max_length), length(0), capacity(0),
 	 version(1),
-	 items(new Item[max_length]),
-	 order(new unsigned[max_length]),
+	 items(nullptr), order(nullptr),
 	 id_table(max_length * HASH_MULT),
+	 change_log(new Change[CHANGE_LOG_SIZE]),
+	 change_log_head(0), change_log_horizon(0),
 	 repeat(false),
 	 single(false),
 	 consume(false),
 	 random(false)
 {
+	std::fill_n(change_log, CHANGE_LOG_SIZE, Change{0, 0});
 }
 
 Queue::~Queue()
 {
 	Clear();
 
-	delete[] items;
-	delete[] order;
+	delete[] change_log;
 }
 
 int
@@ -71,9 +74,67 @@ Queue::IncrementVersion()
 			items[i].version = 0;
 
 		version = 1;
+
+		/* the items with version 0 are not in the change
+		   log; disable it until the queue gets cleared */
+		std::fill_n(change_log, CHANGE_LOG_SIZE, Change{0, 0});
+		change_log_head = 0;
+		change_log_horizon = std::numeric_limits<uint32_t>::max();
 	}
 }
 
+void
+Queue::Reallocate(unsigned new_capacity)
+{
+	assert(new_capacity >= length);
+	assert(new_capacity <= max_length);
+
+	Item *new_items = nullptr;
+	unsigned *new_order = nullptr;
+	if (new_capacity > 0) {
+		new_items = new Item[new_capacity];
+		new_order = new unsigned[new_capacity];
+		std::copy_n(items, length, new_items);
+		std::copy_n(order, length, new_order);
+	}
+
+	delete[] items;
+	delete[] order;
+	items = new_items;
+	order = new_order;
+	capacity = new_capacity;
+}
+
+bool
+Queue::CollectChanges(uint32_t _version,
+		      std::vector<unsigned> &positions) const
+{
+	if (_version > version || _version <= change_log_horizon)
+		return false;
+
+	/* walk backwards from the newest entry until an entry older
+	   than the specified version is found */
+
+	unsigned i = change_log_head;
+	for (unsigned n = 0; n < CHANGE_LOG_SIZE; ++n) {
+		i = (i == 0 ? CHANGE_LOG_SIZE : i) - 1;
+
+		const Change &c = change_log[i];
+		if (c.version < _version)
+			break;
+
+		/* the item may have been deleted or moved since */
+		if (c.position < length &&
+		    items[c.position].version >= _version)
+			positions.push_back(c.position);
+	}
+
+	std::sort(positions.begin(), positions.end());
+	positions.erase(std::unique(positions.begin(), positions.end()),
+			positions.end());
+	return true;
+}
+
 void
 Queue::ModifyAtOrder(unsigned _order)
 {
@@ -88,6 +149,9 @@ Queue::Append(DetachedSong &&song, uint8_t priority)
 {
 	assert(!IsFull());
 
+	if (length == capacity)
+		Grow();
+
 	const unsigned position = length++;
 	const unsigned id = id_table.Insert(position);
 
@@ -96,6 +160,7 @@ Queue::Append(DetachedSong &&song, uint8_t priority)
 	item.id = id;
 	item.version = version;
 	item.priority = priority;
+	LogChange(position);
 
 	order[position] = position;
 
@@ -112,6 +177,8 @@ Queue::SwapPositions(unsigned position1, unsigned position2)
 
 	items[position1].version = version;
 	items[position2].version = version;
+	LogChange(position1);
+	LogChange(position2);
 
 	id_table.Move(id1, position2);
 	id_table.Move(id2, position1);
@@ -120,63 +187,34 @@ Queue::SwapPositions(unsigned position1, unsigned position2)
 void
 Queue::MovePostion(unsigned from, unsigned to)
 {
-	const Item tmp = items[from];
-
-	/* move songs to one less in from->to */
-
-	for (unsigned i = from; i < to; i++)
-		MoveItemTo(i + 1, i);
-
-	/* move songs to one more in to->from */
-
-	for (unsigned i = from; i > to; i--)
-		MoveItemTo(i - 1, i);
-
-	/* put song at _to_ */
-
-	id_table.Move(tmp.id, to);
-	items[to] = tmp;
-	items[to].version = version;
-
-	/* now deal with order */
-
-	if (random) {
-		for (unsigned i = 0; i < length; i++) {
-			if (order[i] > from && order[i] <= to)
-				order[i]--;
-			else if (order[i] < from &&
-				 order[i] >= to)
-				order[i]++;
-			else if (from == order[i])
-				order[i] = to;
-		}
-	}
+	MoveRange(from, from + 1, to);
 }
 
 void
 Queue::MoveRange(unsigned start, unsigned end, unsigned to)
 {
-	Item tmp[end - start];
-	// Copy the original block [start,end-1]
-	for (unsigned i = start; i < end; i++)
-		tmp[i - start] = items[i];
-
-	// If to > start, we need to move to-start items to start, starting from end
-	for (unsigned i = end; i < end + to - start; i++)
-		MoveItemTo(i, start + i - end);
-
-	// If to < start, we need to move start-to items to newend (= end + to - start), starting from to
-	// This is the same as moving items from start-1 to to (decreasing), with start-1 going to end-1
-	// We have to iterate in this order to avoid writing over something we haven't yet moved
-	for (int i = start - 1; i >= int(to); i--)
-		MoveItemTo(i, i + end - start);
-
-	// Copy the original block back in, starting at to.
-	for (unsigned i = start; i< end; i++)
-	{
-		id_table.Move(tmp[i - start].id, to + i - start);
-		items[to + i - start] = tmp[i-start];
-		items[to + i - start].version = version;
+	assert(start <= end);
+	assert(end <= length);
+	assert(to + end - start <= length);
+
+	/* rotate the affected span in place; everything between
+	   "first" and "last" changes its position */
+
+	unsigned first, last;
+	if (to > start) {
+		first = start;
+		last = to + end - start;
+		std::rotate(items + start, items + end, items + last);
+	} else {
+		first = to;
+		last = end;
+		std::rotate(items + to, items + start, items + end);
+	}
+
+	for (unsigned i = first; i < last; ++i) {
+		items[i].version = version;
+		LogChange(i);
+		id_table.Move(items[i].id, i);
 	}
 
 	if (random) {
@@ -215,36 +253,43 @@ Queue::MoveOrder(unsigned from_order, unsigned to_order)
 }
 
 void
-Queue::DeletePosition(unsigned position)
+Queue::DeleteRange(unsigned start, unsigned end)
 {
-	assert(position < length);
-
-	delete items[position].song;
-
-	const unsigned id = PositionToId(position);
-	const unsigned _order = PositionToOrder(position);
+	assert(start <= end);
+	assert(end <= length);
 
-	--length;
+	const unsigned n = end - start;
+	if (n == 0)
+		return;
 
-	/* release the song id */
+	/* free the songs and release their ids */
 
-	id_table.Erase(id);
+	for (unsigned i = start; i < end; ++i) {
+		delete items[i].song;
+		id_table.Erase(items[i].id);
+	}
 
-	/* delete song from songs array */
+	/* close the gap in the songs array */
 
-	for (unsigned i = position; i < length; i++)
-		MoveItemTo(i + 1, i);
+	for (unsigned i = end; i < length; ++i)
+		MoveItemTo(i, i - n);
 
-	/* delete the entry from the order array */
+	/* remove the deleted entries from the order array and
+	   renumber the remaining ones, all in one pass */
 
-	for (unsigned i = _order; i < length; i++)
-		order[i] = order[i + 1];
+	unsigned *dest = order;
+	for (unsigned i = 0; i < length; ++i) {
+		const unsigned position = order[i];
+		if (position < start)
+			*dest++ = position;
+		else if (position >= end)
+			*dest++ = position - n;
+	}
 
-	/* readjust values in the order array */
+	length -= n;
+	assert(dest == order + length);
 
-	for (unsigned i = 0; i < length; i++)
-		if (order[i] > position)
-			--order[i];
+	MaybeShrink();
 }
 
 void
@@ -259,6 +304,12 @@ Queue::Clear()
 	}
 
 	length = 0;
+	Reallocate(0);
+
+	if (change_log_horizon == std::numeric_limits<uint32_t>::max())
+		/* all items with version 0 are gone; the change log
+		   is usable again for newer versions */
+		change_log_horizon = version - 1;
 }
 
 static void
@@ -413,6 +464,7 @@ Queue::SetPriority(unsigned position, uint8_t priority, int after_order)
 
 	item->version = version;
 	item->priority = priority;
+	LogChange(position);
 
 	if (!random)
 		/* don't reorder if not in random mode */
@@ -25,6 +25,7 @@
 #include "util/LazyRandomEngine.hxx"
 
 #include <algorithm>
+#include <vector>
 
 #include <assert.h>
 #include <stdint.h>
@@ -48,6 +49,12 @@ struct Queue {
 	 */
 	static constexpr unsigned HASH_MULT = 4;
 
+	/**
+	 * The initial capacity of the #items and #order arrays.  They
+	 * grow (and shrink) on demand, up to #max_length.
+	 */
+	static constexpr unsigned INITIAL_CAPACITY = 16;
+
 	/**
 	 * One element of the queue: basically a song plus some queue specific
 	 * information attached.
@@ -69,12 +76,30 @@ struct Queue {
 		uint8_t priority;
 	};
 
+	/**
+	 * One entry of the change log: an item was modified (or moved
+	 * to this position) at the specified version.
+	 */
+	struct Change {
+		uint32_t version;
+
+		unsigned position;
+	};
+
+	/**
+	 * The number of entries in the change log ring.
+	 */
+	static constexpr unsigned CHANGE_LOG_SIZE = 4096;
+
 	/** configured maximum length of the queue */
 	unsigned max_length;
 
 	/** number of songs in the queue */
 	unsigned length;
 
+	/** number of elements allocated in #items and #order */
+	unsigned capacity;
+
 	/** the current version number */
 	uint32_t version;
 
@@ -87,6 +112,21 @@ struct Queue {
 	/** map song ids to positions */
 	IdTable id_table;
 
+	/**
+	 * A ring buffer of recent modifications, which allows
+	 * answering "plchanges" without scanning the whole queue.
+	 */
+	Change *change_log;
+
+	/** the index in #change_log which will be written next */
+	unsigned change_log_head;
+
+	/**
+	 * The change log contains all modifications newer than this
+	 * version; older entries may have been overwritten.
+	 */
+	uint32_t change_log_horizon;
+
 	/** repeat playback when the end of the queue has been
 	    reached? */
 	bool repeat;
@@ -225,6 +265,35 @@ struct Queue {
 			items[position].version == 0;
 	}
 
+	/**
+	 * Find the positions of all items which are newer than the
+	 * specified version (see IsNewerAtPosition()), using the
+	 * change log.  The result is sorted.
+	 *
+	 * @return false if the change log does not reach back far
+	 * enough; the caller must scan the whole queue instead
+	 */
+	bool CollectChanges(uint32_t _version,
+			    std::vector<unsigned> &positions) const;
+
+	/**
+	 * Invoke the given function for the position of each item
+	 * which is newer than the specified version, in ascending
+	 * order.
+	 */
+	template<typename F>
+	void VisitChanges(uint32_t _version, F f) const {
+		std::vector<unsigned> positions;
+		if (CollectChanges(_version, positions)) {
+			for (auto i : positions)
+				f(i);
+		} else {
+			for (unsigned i = 0; i < length; ++i)
+				if (IsNewerAtPosition(i, _version))
+					f(i);
+		}
+	}
+
 	/**
 	 * Returns the order number following the specified one.  This takes
 	 * end of queue and "repeat" mode into account.
@@ -249,6 +318,7 @@ struct Queue {
 		assert(position < length);
 
 		items[position].version = version;
+		LogChange(position);
 	}
 
 	/**
@@ -288,14 +358,24 @@ struct Queue {
 	void MovePostion(unsigned from, unsigned to);
 
 	/**
-	 * Moves a range of songs to a new position.
+	 * Moves a range of songs to a new position.  The cost is
+	 * linear to the distance of the move (plus the queue length
+	 * in random mode, for adjusting the "order" array).
 	 */
 	void MoveRange(unsigned start, unsigned end, unsigned to);
 
 	/**
 	 * Removes a song from the playlist.
 	 */
-	void DeletePosition(unsigned position);
+	void DeletePosition(unsigned position) {
+		DeleteRange(position, position + 1);
+	}
+
+	/**
+	 * Removes a range of songs from the playlist.  The remaining
+	 * items and the "order" array are compacted in a single pass.
+	 */
+	void DeleteRange(unsigned start, unsigned end);
 
 	/**
 	 * Removes all songs from the playlist.
@@ -354,11 +434,68 @@ private:
 	 */
 	void MoveOrder(unsigned from_order, unsigned to_order);
 
+	/**
+	 * Reallocate the #items and #order arrays.  The new capacity
+	 * must not be smaller than the current length.
+	 */
+	void Reallocate(unsigned new_capacity);
+
+	/**
+	 * Make room for one more item.
+	 */
+	void Grow() {
+		assert(capacity < max_length);
+
+		unsigned new_capacity = capacity == 0
+			? INITIAL_CAPACITY
+			: capacity * 2;
+		if (new_capacity > max_length)
+			new_capacity = max_length;
+
+		Reallocate(new_capacity);
+	}
+
+	/**
+	 * Release memory if the queue has become much shorter than
+	 * its capacity.
+	 */
+	void MaybeShrink() {
+		if (capacity > INITIAL_CAPACITY && length < capacity / 4)
+			Reallocate(std::max(length * 2,
+					    unsigned(INITIAL_CAPACITY)));
+	}
+
+	/**
+	 * Record a modification at the current version in the change
+	 * log.
+	 */
+	void LogChange(unsigned position) {
+		const unsigned previous = (change_log_head == 0
+					   ? CHANGE_LOG_SIZE
+					   : change_log_head) - 1;
+		if (change_log[previous].version == version &&
+		    change_log[previous].position == position)
+			/* duplicate */
+			return;
+
+		Change &c = change_log[change_log_head];
+		if (c.version > change_log_horizon)
+			/* overwriting an entry */
+			change_log_horizon = c.version;
+
+		c.version = version;
+		c.position = position;
+
+		if (++change_log_head == CHANGE_LOG_SIZE)
+			change_log_head = 0;
+	}
+
 	void MoveItemTo(unsigned from, unsigned to) {
 		unsigned from_id = items[from].id;
 
 		items[to] = items[from];
 		items[to].version = version;
+		LogChange(to);
 		id_table.Move(from_id, to);
 	}
 
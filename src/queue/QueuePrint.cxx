@@ -73,20 +73,19 @@ void
 queue_print_changes_info(Client &client, const Queue &queue,
 			 uint32_t version)
 {
-	for (unsigned i = 0; i < queue.GetLength(); i++) {
-		if (queue.IsNewerAtPosition(i, version))
+	queue.VisitChanges(version, [&client, &queue](unsigned i){
 			queue_print_song_info(client, queue, i);
-	}
+		});
 }
 
 void
 queue_print_changes_position(Client &client, const Queue &queue,
 			     uint32_t version)
 {
-	for (unsigned i = 0; i < queue.GetLength(); i++)
-		if (queue.IsNewerAtPosition(i, version))
+	queue.VisitChanges(version, [&client, &queue](unsigned i){
 			client_printf(client, "cpos: %i\nId: %i\n",
 				      i, queue.PositionToId(i));
+		});
 }
 
 void
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MPD_STICKER_MATCH_HXX
+#define MPD_STICKER_MATCH_HXX
+
+/**
+ * How sticker_find() compares sticker values.
+ */
+enum class StickerOperator {
+	/**
+	 * Matches if a sticker with the specified name exists,
+	 * regardless of its value.
+	 */
+	EXISTS,
+
+	/**
+	 * Matches if the value is equal to the specified string.
+	 */
+	EQUALS,
+
+	/**
+	 * Matches if the value, interpreted as an integer, is less
+	 * than the specified integer.
+	 */
+	LESS_THAN,
+
+	/**
+	 * Matches if the value, interpreted as an integer, is greater
+	 * than the specified integer.
+	 */
+	GREATER_THAN,
+};
+
+#endif
@@ -20,6 +20,7 @@
 #ifndef MPD_SONG_STICKER_HXX
 #define MPD_SONG_STICKER_HXX
 
+#include "Match.hxx"
 #include "Compiler.h"
 
 #include <string>
@@ -74,11 +75,15 @@ sticker_song_get(const LightSong &song);
  *
  * @param base_uri the base directory to search in
  * @param name the name of the sticker
+ * @param op how to compare the sticker value
+ * @param value the value to compare with; ignored for
+ * #StickerOperator::EXISTS
  * @return true on success (even if no sticker was found), false on
  * failure
  */
 bool
 sticker_song_find(const Database &db, const char *base_uri, const char *name,
+		  StickerOperator op, const char *value,
 		  void (*func)(const LightSong &song, const char *value,
 			       void *user_data),
 		  void *user_data);
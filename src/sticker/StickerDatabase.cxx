@@ -24,13 +24,18 @@
 #include "util/Error.hxx"
 #include "util/Domain.hxx"
 #include "util/Macros.hxx"
+#include "thread/Mutex.hxx"
 #include "Log.hxx"
 
 #include <string>
 #include <map>
+#include <list>
 
 #include <sqlite3.h>
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
 
 #if SQLITE_VERSION_NUMBER < 3003009
 #define sqlite3_prepare_v2 sqlite3_prepare
@@ -41,18 +46,18 @@ struct sticker {
 };
 
 enum sticker_sql {
-	STICKER_SQL_GET,
 	STICKER_SQL_LIST,
 	STICKER_SQL_UPDATE,
 	STICKER_SQL_INSERT,
 	STICKER_SQL_DELETE,
 	STICKER_SQL_DELETE_VALUE,
 	STICKER_SQL_FIND,
+	STICKER_SQL_FIND_VALUE,
+	STICKER_SQL_FIND_LT,
+	STICKER_SQL_FIND_GT,
 };
 
 static const char *const sticker_sql[] = {
-	//[STICKER_SQL_GET] =
-	"SELECT value FROM sticker WHERE type=? AND uri=? AND name=?",
 	//[STICKER_SQL_LIST] =
 	"SELECT name,value FROM sticker WHERE type=? AND uri=?",
 	//[STICKER_SQL_UPDATE] =
@@ -64,7 +69,23 @@ static const char *const sticker_sql[] = {
 	//[STICKER_SQL_DELETE_VALUE] =
 	"DELETE FROM sticker WHERE type=? AND uri=? AND name=?",
 	//[STICKER_SQL_FIND] =
-	"SELECT uri,value FROM sticker WHERE type=? AND uri LIKE (? || '%') AND name=?",
+	"SELECT uri,value FROM sticker"
+	" WHERE type=? AND uri>=? AND uri<? AND name=?"
+	" ORDER BY uri",
+	//[STICKER_SQL_FIND_VALUE] =
+	"SELECT uri,value FROM sticker"
+	" WHERE type=? AND uri>=? AND uri<? AND name=? AND value=?"
+	" ORDER BY uri",
+	//[STICKER_SQL_FIND_LT] =
+	"SELECT uri,value FROM sticker"
+	" WHERE type=? AND uri>=? AND uri<? AND name=?"
+	" AND CAST(value AS INTEGER)<?"
+	" ORDER BY uri",
+	//[STICKER_SQL_FIND_GT] =
+	"SELECT uri,value FROM sticker"
+	" WHERE type=? AND uri>=? AND uri<? AND name=?"
+	" AND CAST(value AS INTEGER)>?"
+	" ORDER BY uri",
 };
 
 static const char sticker_sql_create[] =
@@ -81,6 +102,37 @@ static const char sticker_sql_create[] =
 static sqlite3 *sticker_db;
 static sqlite3_stmt *sticker_stmt[ARRAY_SIZE(sticker_sql)];
 
+/**
+ * Serializes access to the prepared statements in #sticker_stmt and
+ * to #sticker_cache; sticker commands may be executed by worker
+ * threads.
+ */
+static Mutex sticker_mutex;
+
+/**
+ * The maximum number of objects in #sticker_cache.  When it is
+ * full, it is cleared.
+ */
+static constexpr size_t STICKER_CACHE_MAX = 65536;
+
+/**
+ * In-memory copies of the sticker values of recently used objects,
+ * indexed by sticker_cache_key().  An empty sticker means the object
+ * has no values.  Modifications are written to the database first,
+ * and then applied to this cache.
+ */
+static std::map<std::string, sticker> sticker_cache;
+
+/**
+ * The nesting level of sticker_begin_batch() calls.
+ */
+static unsigned sticker_batch_depth;
+
+/**
+ * Has the current batch begun a transaction?
+ */
+static bool sticker_transaction;
+
 static constexpr Domain sticker_domain("sticker");
 
 static void
@@ -106,8 +158,35 @@ sticker_prepare(const char *sql, Error &error)
 	return stmt;
 }
 
+/**
+ * Switch the database to write-ahead logging.  Returns false if
+ * SQLite refuses (e.g. because the file system lacks shared memory
+ * support, which is common on network file systems, or because
+ * SQLite is older than 3.7.0); the database then remains in its
+ * previous journal mode.
+ */
+static bool
+sticker_enable_wal()
+{
+	sqlite3_stmt *stmt;
+	int ret = sqlite3_prepare_v2(sticker_db, "PRAGMA journal_mode=WAL",
+				     -1, &stmt, nullptr);
+	if (ret != SQLITE_OK)
+		return false;
+
+	bool success = false;
+	if (sqlite3_step(stmt) == SQLITE_ROW) {
+		const char *mode =
+			(const char *)sqlite3_column_text(stmt, 0);
+		success = mode != nullptr && strcasecmp(mode, "wal") == 0;
+	}
+
+	sqlite3_finalize(stmt);
+	return success;
+}
+
 bool
-sticker_global_init(Path path, Error &error)
+sticker_global_init(Path path, bool wal, Error &error)
 {
 	assert(!path.IsNull());
 
@@ -135,6 +214,19 @@ sticker_global_init(Path path, Error &error)
 		return false;
 	}
 
+	/* write-ahead logging: commits don't need to sync the disk,
+	   and readers don't block the writer; "synchronous=NORMAL"
+	   is only safe in this mode */
+
+	if (wal) {
+		if (sticker_enable_wal())
+			sqlite3_exec(sticker_db, "PRAGMA synchronous=NORMAL",
+				     nullptr, nullptr, nullptr);
+		else
+			LogWarning(sticker_domain,
+				   "Failed to enable write-ahead logging for the sticker database; falling back to the rollback journal");
+	}
+
 	/* prepare the statements we're going to use */
 
 	for (unsigned i = 0; i < ARRAY_SIZE(sticker_sql); ++i) {
@@ -155,6 +247,11 @@ sticker_global_finish(void)
 		/* not configured */
 		return;
 
+	assert(sticker_batch_depth == 0);
+	assert(!sticker_transaction);
+
+	sticker_cache.clear();
+
 	for (unsigned i = 0; i < ARRAY_SIZE(sticker_stmt); ++i) {
 		assert(sticker_stmt[i] != nullptr);
 
@@ -170,61 +267,6 @@ sticker_enabled(void)
 	return sticker_db != nullptr;
 }
 
-std::string
-sticker_load_value(const char *type, const char *uri, const char *name)
-{
-	sqlite3_stmt *const stmt = sticker_stmt[STICKER_SQL_GET];
-	int ret;
-
-	assert(sticker_enabled());
-	assert(type != nullptr);
-	assert(uri != nullptr);
-	assert(name != nullptr);
-
-	if (*name == 0)
-		return std::string();
-
-	sqlite3_reset(stmt);
-
-	ret = sqlite3_bind_text(stmt, 1, type, -1, nullptr);
-	if (ret != SQLITE_OK) {
-		LogError(sticker_db, "sqlite3_bind_text() failed");
-		return std::string();
-	}
-
-	ret = sqlite3_bind_text(stmt, 2, uri, -1, nullptr);
-	if (ret != SQLITE_OK) {
-		LogError(sticker_db, "sqlite3_bind_text() failed");
-		return std::string();
-	}
-
-	ret = sqlite3_bind_text(stmt, 3, name, -1, nullptr);
-	if (ret != SQLITE_OK) {
-		LogError(sticker_db, "sqlite3_bind_text() failed");
-		return std::string();
-	}
-
-	do {
-		ret = sqlite3_step(stmt);
-	} while (ret == SQLITE_BUSY);
-
-	std::string value;
-	if (ret == SQLITE_ROW) {
-		/* record found */
-		value = (const char*)sqlite3_column_text(stmt, 0);
-	} else if (ret == SQLITE_DONE) {
-		/* no record found */
-	} else {
-		/* error */
-		LogError(sticker_db, "sqlite3_step() failed");
-	}
-
-	sqlite3_reset(stmt);
-	sqlite3_clear_bindings(stmt);
-
-	return value;
-}
-
 static bool
 sticker_list_values(std::map<std::string, std::string> &table,
 		    const char *type, const char *uri)
@@ -278,6 +320,167 @@ sticker_list_values(std::map<std::string, std::string> &table,
 	return true;
 }
 
+static std::string
+sticker_cache_key(const char *type, const char *uri)
+{
+	std::string key(type);
+	key.push_back('\0');
+	key.append(uri);
+	return key;
+}
+
+/**
+ * Returns the cached sticker of the specified object, or nullptr if
+ * it is not cached.  The caller must hold #sticker_mutex.
+ */
+static sticker *
+sticker_cache_find(const char *type, const char *uri)
+{
+	auto i = sticker_cache.find(sticker_cache_key(type, uri));
+	return i != sticker_cache.end()
+		? &i->second
+		: nullptr;
+}
+
+/**
+ * Returns the cached sticker of the specified object, and loads it
+ * from the database if it is not cached yet.  The caller must hold
+ * #sticker_mutex, and the pointer is valid only until it is
+ * released.
+ *
+ * @return the sticker (which may be empty), or nullptr on error
+ */
+static const sticker *
+sticker_cache_get(const char *type, const char *uri)
+{
+	std::string key = sticker_cache_key(type, uri);
+	auto i = sticker_cache.find(key);
+	if (i != sticker_cache.end())
+		return &i->second;
+
+	sticker s;
+	if (!sticker_list_values(s.table, type, uri))
+		return nullptr;
+
+	if (sticker_cache.size() >= STICKER_CACHE_MAX)
+		sticker_cache.clear();
+
+	return &sticker_cache.insert(std::make_pair(std::move(key),
+						    std::move(s)))
+		.first->second;
+}
+
+/**
+ * Applies a modification which has been written to the database to
+ * the cache.
+ *
+ * @param value the new value, or nullptr if it was deleted
+ */
+static void
+sticker_cache_update(const char *type, const char *uri,
+		     const char *name, const char *value)
+{
+	sticker *s = sticker_cache_find(type, uri);
+	if (s == nullptr)
+		/* not cached; will be loaded on demand */
+		return;
+
+	if (value != nullptr)
+		s->table[name] = value;
+	else
+		s->table.erase(name);
+}
+
+static void
+sticker_cache_erase(const char *type, const char *uri)
+{
+	sticker_cache.erase(sticker_cache_key(type, uri));
+}
+
+std::string
+sticker_load_value(const char *type, const char *uri, const char *name)
+{
+	assert(sticker_enabled());
+	assert(type != nullptr);
+	assert(uri != nullptr);
+	assert(name != nullptr);
+
+	if (*name == 0)
+		return std::string();
+
+	const ScopeLock protect(sticker_mutex);
+
+	const sticker *s = sticker_cache_get(type, uri);
+	if (s == nullptr)
+		return std::string();
+
+	auto i = s->table.find(name);
+	if (i == s->table.end())
+		return std::string();
+
+	return i->second;
+}
+
+/**
+ * Begins a transaction if a batch is active and no transaction has
+ * been begun yet.  The caller must hold #sticker_mutex.
+ */
+static bool
+sticker_prepare_write()
+{
+	if (sticker_batch_depth == 0 || sticker_transaction)
+		return true;
+
+	int ret = sqlite3_exec(sticker_db, "BEGIN", nullptr, nullptr, nullptr);
+	if (ret != SQLITE_OK) {
+		LogError(sticker_db, "Failed to begin transaction");
+		return false;
+	}
+
+	sticker_transaction = true;
+	return true;
+}
+
+void
+sticker_begin_batch()
+{
+	assert(sticker_enabled());
+
+	const ScopeLock protect(sticker_mutex);
+	++sticker_batch_depth;
+}
+
+bool
+sticker_end_batch(Error &error)
+{
+	assert(sticker_enabled());
+
+	const ScopeLock protect(sticker_mutex);
+
+	assert(sticker_batch_depth > 0);
+	if (--sticker_batch_depth > 0 || !sticker_transaction)
+		return true;
+
+	sticker_transaction = false;
+
+	int ret = sqlite3_exec(sticker_db, "COMMIT", nullptr, nullptr, nullptr);
+	if (ret != SQLITE_OK) {
+		error.Format(sticker_domain, ret,
+			     "Failed to commit sticker transaction: %s",
+			     sqlite3_errmsg(sticker_db));
+		LogError(error);
+
+		/* the cache contains modifications which are now
+		   lost */
+		sqlite3_exec(sticker_db, "ROLLBACK",
+			     nullptr, nullptr, nullptr);
+		sticker_cache.clear();
+		return false;
+	}
+
+	return true;
+}
+
 static bool
 sticker_update_value(const char *type, const char *uri,
 		     const char *name, const char *value)
@@ -408,8 +611,25 @@ sticker_store_value(const char *type, const char *uri,
 	if (*name == 0)
 		return false;
 
-	return sticker_update_value(type, uri, name, value) ||
-		sticker_insert_value(type, uri, name, value);
+	const ScopeLock protect(sticker_mutex);
+
+	if (!sticker_prepare_write())
+		return false;
+
+	/* if the object is cached, we know which of the two
+	   statements is needed */
+	const sticker *s = sticker_cache_find(type, uri);
+	const bool exists = s == nullptr ||
+		s->table.find(name) != s->table.end();
+
+	if ((exists && sticker_update_value(type, uri, name, value)) ||
+	    sticker_insert_value(type, uri, name, value)) {
+		sticker_cache_update(type, uri, name, value);
+		return true;
+	}
+
+	sticker_cache_erase(type, uri);
+	return false;
 }
 
 bool
@@ -422,6 +642,15 @@ sticker_delete(const char *type, const char *uri)
 	assert(type != nullptr);
 	assert(uri != nullptr);
 
+	const ScopeLock protect(sticker_mutex);
+
+	/* the cached copy is discarded before anything can fail, so
+	   it cannot become stale */
+	sticker_cache_erase(type, uri);
+
+	if (!sticker_prepare_write())
+		return false;
+
 	sqlite3_reset(stmt);
 
 	ret = sqlite3_bind_text(stmt, 1, type, -1, nullptr);
@@ -462,6 +691,15 @@ sticker_delete_value(const char *type, const char *uri, const char *name)
 	assert(type != nullptr);
 	assert(uri != nullptr);
 
+	const ScopeLock protect(sticker_mutex);
+
+	/* the cached copy is discarded before anything can fail, so
+	   it cannot become stale */
+	sticker_cache_erase(type, uri);
+
+	if (!sticker_prepare_write())
+		return false;
+
 	sqlite3_reset(stmt);
 
 	ret = sqlite3_bind_text(stmt, 1, type, -1, nullptr);
@@ -529,30 +767,96 @@ sticker_foreach(const sticker &sticker,
 struct sticker *
 sticker_load(const char *type, const char *uri)
 {
-	sticker s;
+	const ScopeLock protect(sticker_mutex);
 
-	if (!sticker_list_values(s.table, type, uri))
+	const sticker *s = sticker_cache_get(type, uri);
+	if (s == nullptr)
 		return nullptr;
 
-	if (s.table.empty())
+	if (s->table.empty())
 		/* don't return empty sticker objects */
 		return nullptr;
 
-	return new sticker(std::move(s));
+	return new sticker(*s);
 }
 
-bool
-sticker_find(const char *type, const char *base_uri, const char *name,
-	     void (*func)(const char *uri, const char *value,
-			  void *user_data),
-	     void *user_data)
+typedef std::list<std::pair<std::string, std::string>> StickerFindResult;
+
+/**
+ * The number of rows sticker_find() reads while holding
+ * #sticker_mutex.
+ */
+static constexpr unsigned STICKER_FIND_CHUNK = 256;
+
+/**
+ * Returns the smallest string which is greater than all strings
+ * beginning with the specified prefix, or an empty string if there
+ * is none.
+ */
+static std::string
+sticker_prefix_end(const char *prefix)
 {
-	sqlite3_stmt *const stmt = sticker_stmt[STICKER_SQL_FIND];
+	std::string end(prefix);
+
+	while (!end.empty()) {
+		unsigned char &last = (unsigned char &)end[end.length() - 1];
+		if (last != 0xff) {
+			++last;
+			break;
+		}
+
+		end.erase(end.length() - 1);
+	}
+
+	return end;
+}
+
+static sqlite3_stmt *
+sticker_find_stmt(StickerOperator op)
+{
+	switch (op) {
+	case StickerOperator::EXISTS:
+		return sticker_stmt[STICKER_SQL_FIND];
+
+	case StickerOperator::EQUALS:
+		return sticker_stmt[STICKER_SQL_FIND_VALUE];
+
+	case StickerOperator::LESS_THAN:
+		return sticker_stmt[STICKER_SQL_FIND_LT];
+
+	case StickerOperator::GREATER_THAN:
+		return sticker_stmt[STICKER_SQL_FIND_GT];
+	}
+
+	assert(false);
+	gcc_unreachable();
+}
+
+/**
+ * Reads up to #STICKER_FIND_CHUNK matching rows, beginning at the
+ * URI #begin.  The caller must hold #sticker_mutex.
+ *
+ * @param end the end of the URI range (exclusive), or an empty
+ * string for no limit
+ * @param skip a URI which was already reported by the previous chunk
+ * and shall be skipped, or nullptr
+ * @param more_r set to true if there may be more rows after this
+ * chunk
+ */
+static bool
+sticker_find_values(StickerFindResult &result, bool &more_r,
+		    const char *type,
+		    const char *begin, const std::string &end,
+		    const char *skip,
+		    const char *name, StickerOperator op, const char *value)
+{
+	sqlite3_stmt *const stmt = sticker_find_stmt(op);
 	int ret;
 
 	assert(type != nullptr);
+	assert(begin != nullptr);
 	assert(name != nullptr);
-	assert(func != nullptr);
+	assert(op == StickerOperator::EXISTS || value != nullptr);
 	assert(sticker_enabled());
 
 	sqlite3_reset(stmt);
@@ -563,28 +867,71 @@ sticker_find(const char *type, const char *base_uri, const char *name,
 		return false;
 	}
 
-	if (base_uri == nullptr)
-		base_uri = "";
+	ret = sqlite3_bind_text(stmt, 2, begin, -1, nullptr);
+	if (ret != SQLITE_OK) {
+		LogError(sticker_db, "sqlite3_bind_text() failed");
+		return false;
+	}
 
-	ret = sqlite3_bind_text(stmt, 2, base_uri, -1, nullptr);
+	/* without an upper limit, compare with an empty BLOB:
+	   SQLite sorts all TEXT values before all BLOB values */
+	ret = end.empty()
+		? sqlite3_bind_zeroblob(stmt, 3, 0)
+		: sqlite3_bind_text(stmt, 3, end.data(), end.length(),
+				    nullptr);
 	if (ret != SQLITE_OK) {
 		LogError(sticker_db, "sqlite3_bind_text() failed");
 		return false;
 	}
 
-	ret = sqlite3_bind_text(stmt, 3, name, -1, nullptr);
+	ret = sqlite3_bind_text(stmt, 4, name, -1, nullptr);
 	if (ret != SQLITE_OK) {
 		LogError(sticker_db, "sqlite3_bind_text() failed");
 		return false;
 	}
 
+	switch (op) {
+	case StickerOperator::EXISTS:
+		break;
+
+	case StickerOperator::EQUALS:
+		ret = sqlite3_bind_text(stmt, 5, value, -1, nullptr);
+		break;
+
+	case StickerOperator::LESS_THAN:
+	case StickerOperator::GREATER_THAN:
+		ret = sqlite3_bind_int64(stmt, 5,
+					 strtoll(value, nullptr, 10));
+		break;
+	}
+
+	if (ret != SQLITE_OK) {
+		LogError(sticker_db, "sqlite3_bind() failed");
+		return false;
+	}
+
+	unsigned n = 0;
+	more_r = false;
+
 	do {
 		ret = sqlite3_step(stmt);
 		switch (ret) {
+			const char *uri;
+
 		case SQLITE_ROW:
-			func((const char*)sqlite3_column_text(stmt, 0),
-			     (const char*)sqlite3_column_text(stmt, 1),
-			     user_data);
+			if (n >= STICKER_FIND_CHUNK) {
+				more_r = true;
+				ret = SQLITE_DONE;
+				break;
+			}
+
+			uri = (const char*)sqlite3_column_text(stmt, 0);
+			if (skip != nullptr && strcmp(uri, skip) == 0)
+				break;
+
+			result.emplace_back(uri,
+					    (const char*)sqlite3_column_text(stmt, 1));
+			++n;
 			break;
 		case SQLITE_DONE:
 			break;
@@ -602,3 +949,53 @@ sticker_find(const char *type, const char *base_uri, const char *name,
 
 	return true;
 }
+
+bool
+sticker_find(const char *type, const char *base_uri, const char *name,
+	     StickerOperator op, const char *value,
+	     void (*func)(const char *uri, const char *value,
+			  void *user_data),
+	     void *user_data)
+{
+	assert(func != nullptr);
+
+	if (base_uri == nullptr)
+		base_uri = "";
+
+	/* all URIs beginning with base_uri are in this range, which
+	   SQLite can look up in the index */
+	const std::string end = sticker_prefix_end(base_uri);
+
+	/* the rows are read in chunks, and the callback is invoked
+	   after releasing the lock, because it may borrow songs from
+	   the database, and a thread holding a song may be waiting for
+	   the sticker database; the next chunk begins at the last URI
+	   of the previous one */
+	std::string begin(base_uri);
+	bool first = true;
+	StickerFindResult result;
+	bool more;
+
+	do {
+		result.clear();
+
+		{
+			const ScopeLock protect(sticker_mutex);
+			if (!sticker_find_values(result, more, type,
+						 begin.c_str(), end,
+						 first ? nullptr : begin.c_str(),
+						 name, op, value))
+				return false;
+		}
+
+		for (const auto &i : result)
+			func(i.first.c_str(), i.second.c_str(), user_data);
+
+		if (!result.empty()) {
+			begin = result.back().first;
+			first = false;
+		}
+	} while (more);
+
+	return true;
+}
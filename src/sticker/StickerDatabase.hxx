@@ -42,6 +42,7 @@
 #ifndef MPD_STICKER_DATABASE_HXX
 #define MPD_STICKER_DATABASE_HXX
 
+#include "Match.hxx"
 #include "Compiler.h"
 
 #include <string>
@@ -53,10 +54,12 @@ struct sticker;
 /**
  * Opens the sticker database.
  *
+ * @param wal enable write-ahead logging?  It falls back to the
+ * rollback journal if SQLite does not support it on this file system
  * @return true on success, false on error
  */
 bool
-sticker_global_init(Path path, Error &error);
+sticker_global_init(Path path, bool wal, Error &error);
 
 /**
  * Close the sticker database.
@@ -100,6 +103,24 @@ sticker_delete(const char *type, const char *uri);
 bool
 sticker_delete_value(const char *type, const char *uri, const char *name);
 
+/**
+ * Begins a batch of modifications.  They are committed in one
+ * transaction by sticker_end_batch(), instead of one transaction per
+ * modification.  Batches may be nested.
+ */
+void
+sticker_begin_batch();
+
+/**
+ * Ends a batch begun by sticker_begin_batch(), and commits the
+ * modifications when the outermost batch ends.
+ *
+ * @return false if the commit has failed; all modifications of the
+ * batch are then lost
+ */
+bool
+sticker_end_batch(Error &error);
+
 /**
  * Frees resources held by the sticker object.
  *
@@ -144,16 +165,22 @@ sticker_load(const char *type, const char *uri);
 
 /**
  * Finds stickers with the specified name below the specified URI.
+ * The callback is invoked in URI order, while the matching rows are
+ * still being read from the database.
  *
  * @param type the resource type, e.g. "song"
  * @param base_uri the URI prefix of the resources, or nullptr if all
  * resources should be searched
  * @param name the name of the sticker
+ * @param op how to compare the sticker value
+ * @param value the value to compare with; ignored for
+ * #StickerOperator::EXISTS
  * @return true on success (even if no sticker was found), false on
  * failure
  */
 bool
 sticker_find(const char *type, const char *base_uri, const char *name,
+	     StickerOperator op, const char *value,
 	     void (*func)(const char *uri, const char *value,
 			  void *user_data),
 	     void *user_data);
@@ -118,6 +118,43 @@ MonotonicClockUS(void)
 #endif
 }
 
+uint64_t
+MonotonicClockNS(void)
+{
+#ifdef WIN32
+	LARGE_INTEGER l_value, l_frequency;
+
+	if (!QueryPerformanceCounter(&l_value) ||
+	    !QueryPerformanceFrequency(&l_frequency) ||
+	    l_frequency.QuadPart == 0)
+		return 0;
+
+	uint64_t value = l_value.QuadPart;
+	uint64_t frequency = l_frequency.QuadPart;
+
+	/* split into seconds and remainder to avoid overflowing the
+	   64 bit multiplication */
+	return (value / frequency) * 1000000000 +
+		((value % frequency) * 1000000000) / frequency;
+#elif defined(__APPLE__) /* OS X does not define CLOCK_MONOTONIC */
+	static mach_timebase_info_data_t base;
+	if (base.denom == 0)
+		(void)mach_timebase_info(&base);
+
+	return ((uint64_t)mach_absolute_time() * (uint64_t)base.numer)
+		/ (uint64_t)base.denom;
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#else
+	/* we have no monotonic clock, fall back to gettimeofday() */
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return (uint64_t)tv.tv_sec * 1000000000 + (uint64_t)tv.tv_usec * 1000;
+#endif
+}
+
 #ifdef WIN32
 
 gcc_const
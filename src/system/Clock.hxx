@@ -45,6 +45,13 @@ gcc_pure
 uint64_t
 MonotonicClockUS();
 
+/**
+ * Returns the value of a monotonic clock in nanoseconds.
+ */
+gcc_pure
+uint64_t
+MonotonicClockNS();
+
 #ifdef WIN32
 
 /**
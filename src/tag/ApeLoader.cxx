@@ -19,12 +19,12 @@
 
 #include "config.h"
 #include "ApeLoader.hxx"
+#include "TagFileBuffer.hxx"
+#include "fs/Path.hxx"
 #include "system/ByteOrder.hxx"
-#include "fs/FileSystem.hxx"
 
 #include <stdint.h>
 #include <assert.h>
-#include <stdio.h>
 #include <string.h>
 
 struct ape_footer {
@@ -36,13 +36,13 @@ struct ape_footer {
 	unsigned char reserved[8];
 };
 
-static bool
-ape_scan_internal(FILE *fp, ApeTagCallback callback)
+bool
+tag_ape_scan(TagFileBuffer &file, ApeTagCallback callback)
 {
 	/* determine if file has an apeV2 tag */
 	struct ape_footer footer;
-	if (fseek(fp, -(long)sizeof(footer), SEEK_END) ||
-	    fread(&footer, 1, sizeof(footer), fp) != sizeof(footer) ||
+	if (file.Read(-(long)sizeof(footer), &footer,
+		      sizeof(footer)) != sizeof(footer) ||
 	    memcmp(footer.id, "APETAGEX", sizeof(footer.id)) != 0 ||
 	    FromLE32(footer.version) != 2000)
 		return false;
@@ -52,15 +52,17 @@ ape_scan_internal(FILE *fp, ApeTagCallback callback)
 	if (remaining <= sizeof(footer) + 10 ||
 	    /* refuse to load more than one megabyte of tag data */
 	    remaining > 1024 * 1024 ||
-	    fseek(fp, -(long)remaining, SEEK_END))
+	    (long)remaining > file.GetSize())
 		return false;
 
+	const long offset = -(long)remaining;
+
 	/* read tag into buffer */
 	remaining -= sizeof(footer);
 	assert(remaining > 10);
 
 	char *buffer = new char[remaining];
-	if (fread(buffer, 1, remaining, fp) != remaining) {
+	if (file.Read(offset, buffer, remaining) != remaining) {
 		delete[] buffer;
 		return false;
 	}
@@ -103,11 +105,6 @@ ape_scan_internal(FILE *fp, ApeTagCallback callback)
 bool
 tag_ape_scan(Path path_fs, ApeTagCallback callback)
 {
-	FILE *fp = FOpen(path_fs, "rb");
-	if (fp == nullptr)
-		return false;
-
-	bool success = ape_scan_internal(fp, callback);
-	fclose(fp);
-	return success;
+	TagFileBuffer file(path_fs);
+	return file.IsDefined() && tag_ape_scan(file, callback);
 }
@@ -20,6 +20,7 @@
 #include "config.h"
 #include "ApeTag.hxx"
 #include "ApeLoader.hxx"
+#include "TagFileBuffer.hxx"
 #include "Tag.hxx"
 #include "TagTable.hxx"
 #include "TagHandler.hxx"
@@ -105,7 +106,7 @@ tag_ape_import_item(unsigned long flags,
 }
 
 bool
-tag_ape_scan2(Path path_fs,
+tag_ape_scan2(TagFileBuffer &file,
 	      const struct tag_handler *handler, void *handler_ctx)
 {
 	bool recognized = false;
@@ -120,5 +121,13 @@ tag_ape_scan2(Path path_fs,
 		return true;
 	};
 
-	return tag_ape_scan(path_fs, callback) && recognized;
+	return tag_ape_scan(file, callback) && recognized;
+}
+
+bool
+tag_ape_scan2(Path path_fs,
+	      const struct tag_handler *handler, void *handler_ctx)
+{
+	TagFileBuffer file(path_fs);
+	return file.IsDefined() && tag_ape_scan2(file, handler, handler_ctx);
 }
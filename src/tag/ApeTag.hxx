@@ -23,6 +23,7 @@
 #include "TagTable.hxx"
 
 class Path;
+class TagFileBuffer;
 struct tag_handler;
 
 extern const struct tag_table ape_tags[];
@@ -36,4 +37,11 @@ bool
 tag_ape_scan2(Path path_fs,
 	      const tag_handler *handler, void *handler_ctx);
 
+/**
+ * Scan the APE tags of a file which is already open.
+ */
+bool
+tag_ape_scan2(TagFileBuffer &file,
+	      const tag_handler *handler, void *handler_ctx);
+
 #endif
@@ -39,8 +39,8 @@ struct TagLess {
 
 		const unsigned n = a.num_items;
 		for (unsigned i = 0; i < n; ++i) {
-			const TagItem &ai = *a.items[i];
-			const TagItem &bi = *b.items[i];
+			const TagItem &ai = tag_pool_lookup(a.items[i]);
+			const TagItem &bi = tag_pool_lookup(b.items[i]);
 			if (ai.type != bi.type)
 				return unsigned(ai.type) < unsigned(bi.type);
 
@@ -22,6 +22,7 @@
 
 #include "TagType.h" // IWYU pragma: export
 #include "TagItem.hxx" // IWYU pragma: export
+#include "TagPool.hxx"
 #include "Chrono.hxx"
 #include "Compiler.h"
 
@@ -50,8 +51,8 @@ struct Tag {
 	/** the total number of tag items in the #items array */
 	unsigned short num_items;
 
-	/** an array of tag items */
-	TagItem **items;
+	/** an array of tag pool ids */
+	TagPoolId *items;
 
 	/**
 	 * Create an empty tag.
@@ -139,18 +140,18 @@ struct Tag {
 
 	class const_iterator {
 		friend struct Tag;
-		const TagItem *const*cursor;
+		const TagPoolId *cursor;
 
-		constexpr const_iterator(const TagItem *const*_cursor)
+		constexpr const_iterator(const TagPoolId *_cursor)
 			:cursor(_cursor) {}
 
 	public:
-		constexpr const TagItem &operator*() const {
-			return **cursor;
+		const TagItem &operator*() const {
+			return tag_pool_lookup(*cursor);
 		}
 
-		constexpr const TagItem *operator->() const {
-			return *cursor;
+		const TagItem *operator->() const {
+			return &tag_pool_lookup(*cursor);
 		}
 
 		const_iterator &operator++() {
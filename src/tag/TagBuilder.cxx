@@ -33,22 +33,20 @@ TagBuilder::TagBuilder(const Tag &other)
 {
 	items.reserve(other.num_items);
 
-	tag_pool_lock.lock();
 	for (unsigned i = 0, n = other.num_items; i != n; ++i)
 		items.push_back(tag_pool_dup_item(other.items[i]));
-	tag_pool_lock.unlock();
 }
 
 TagBuilder::TagBuilder(Tag &&other)
 	:duration(other.duration), has_playlist(other.has_playlist)
 {
-	/* move all TagItem pointers from the Tag object; we don't
+	/* move all item ids from the Tag object; we don't
 	   need to contact the tag pool, because all we do is move
 	   references */
 	items.reserve(other.num_items);
 	std::copy_n(other.items, other.num_items, std::back_inserter(items));
 
-	/* discard the pointers from the Tag object */
+	/* discard the ids from the Tag object */
 	other.num_items = 0;
 	delete[] other.items;
 	other.items = nullptr;
@@ -63,10 +61,8 @@ TagBuilder::operator=(const TagBuilder &other)
 	items = other.items;
 
 	/* increment the tag pool refcounters */
-	tag_pool_lock.lock();
 	for (auto i : items)
 		tag_pool_dup_item(i);
-	tag_pool_lock.unlock();
 
 	return *this;
 }
@@ -87,14 +83,14 @@ TagBuilder::operator=(Tag &&other)
 	duration = other.duration;
 	has_playlist = other.has_playlist;
 
-	/* move all TagItem pointers from the Tag object; we don't
+	/* move all item ids from the Tag object; we don't
 	   need to contact the tag pool, because all we do is move
 	   references */
 	items.clear();
 	items.reserve(other.num_items);
 	std::copy_n(other.items, other.num_items, std::back_inserter(items));
 
-	/* discard the pointers from the Tag object */
+	/* discard the ids from the Tag object */
 	other.num_items = 0;
 	delete[] other.items;
 	other.items = nullptr;
@@ -118,13 +114,13 @@ TagBuilder::Commit(Tag &tag)
 	tag.duration = duration;
 	tag.has_playlist = has_playlist;
 
-	/* move all TagItem pointers to the new Tag object without
+	/* move all item ids to the new Tag object without
 	   touching the TagPool reference counters; the
 	   vector::clear() call is important to detach them from this
 	   object */
 	const unsigned n_items = items.size();
 	tag.num_items = n_items;
-	tag.items = new TagItem *[n_items];
+	tag.items = new TagPoolId[n_items];
 	std::copy_n(items.begin(), n_items, tag.items);
 	items.clear();
 
@@ -153,7 +149,7 @@ bool
 TagBuilder::HasType(TagType type) const
 {
 	for (auto i : items)
-		if (i->type == type)
+		if (tag_pool_lookup(i).type == type)
 			return true;
 
 	return false;
@@ -169,13 +165,11 @@ TagBuilder::Complement(const Tag &other)
 
 	items.reserve(items.size() + other.num_items);
 
-	tag_pool_lock.lock();
 	for (unsigned i = 0, n = other.num_items; i != n; ++i) {
-		TagItem *item = other.items[i];
-		if (!HasType(item->type))
-			items.push_back(tag_pool_dup_item(item));
+		const TagPoolId id = other.items[i];
+		if (!HasType(tag_pool_lookup(id).type))
+			items.push_back(tag_pool_dup_item(id));
 	}
-	tag_pool_lock.unlock();
 }
 
 inline void
@@ -190,9 +184,7 @@ TagBuilder::AddItemInternal(TagType type, const char *value, size_t length)
 		length = strlen(value);
 	}
 
-	tag_pool_lock.lock();
 	auto i = tag_pool_get_item(type, value, length);
-	tag_pool_lock.unlock();
 
 	free(p);
 
@@ -221,9 +213,7 @@ TagBuilder::AddItem(TagType type, const char *value)
 void
 TagBuilder::AddEmptyItem(TagType type)
 {
-	tag_pool_lock.lock();
 	auto i = tag_pool_get_item(type, "", 0);
-	tag_pool_lock.unlock();
 
 	items.push_back(i);
 }
@@ -231,10 +221,8 @@ TagBuilder::AddEmptyItem(TagType type)
 void
 TagBuilder::RemoveAll()
 {
-	tag_pool_lock.lock();
 	for (auto i : items)
 		tag_pool_put_item(i);
-	tag_pool_lock.unlock();
 
 	items.clear();
 }
@@ -245,10 +233,10 @@ TagBuilder::RemoveType(TagType type)
 	const auto begin = items.begin(), end = items.end();
 
 	items.erase(std::remove_if(begin, end,
-				   [type](TagItem *item) {
-					   if (item->type != type)
+				   [type](TagPoolId id) {
+					   if (tag_pool_lookup(id).type != type)
 						   return false;
-					   tag_pool_put_item(item);
+					   tag_pool_put_item(id);
 					   return true;
 				   }),
 		    end);
@@ -21,6 +21,7 @@
 #define MPD_TAG_BUILDER_HXX
 
 #include "TagType.h"
+#include "TagPool.hxx"
 #include "Chrono.hxx"
 #include "Compiler.h"
 
@@ -47,8 +48,8 @@ class TagBuilder {
 	 */
 	bool has_playlist;
 
-	/** an array of tag items */
-	std::vector<TagItem *> items;
+	/** an array of tag pool ids */
+	std::vector<TagPoolId> items;
 
 public:
 	/**
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "config.h" /* must be first for large file support */
+#include "TagFileBuffer.hxx"
+#include "fs/FileSystem.hxx"
+
+#include <algorithm>
+
+#include <assert.h>
+#include <string.h>
+#include <sys/stat.h>
+
+TagFileBuffer::TagFileBuffer(Path path_fs)
+	:file(FOpen(path_fs, "rb")), size(0), head_size(0),
+	 tail_offset(0), tail_size(0)
+{
+	if (file == nullptr)
+		return;
+
+	struct stat st;
+	if (fstat(fileno(file), &st) < 0 || !S_ISREG(st.st_mode))
+		return;
+
+	size = st.st_size;
+
+	head_size = fread(head, 1, std::min(size_t(size), size_t(HEAD_SIZE)), file);
+
+	if (size_t(size) > HEAD_SIZE) {
+		tail_offset = std::max(size - long(TAIL_SIZE),
+				       long(HEAD_SIZE));
+		if (fseek(file, tail_offset, SEEK_SET) == 0)
+			tail_size = fread(tail, 1, size - tail_offset, file);
+	}
+}
+
+TagFileBuffer::~TagFileBuffer()
+{
+	if (file != nullptr)
+		fclose(file);
+}
+
+size_t
+TagFileBuffer::Read(long offset, void *dest, size_t length)
+{
+	assert(IsDefined());
+
+	if (offset < 0)
+		offset += size;
+
+	if (offset < 0 || offset >= size)
+		return 0;
+
+	length = std::min(length, size_t(size - offset));
+
+	if (size_t(offset) + length <= head_size) {
+		memcpy(dest, head + offset, length);
+		return length;
+	}
+
+	if (tail_size > 0 && offset >= tail_offset &&
+	    size_t(offset - tail_offset) + length <= tail_size) {
+		memcpy(dest, tail + (offset - tail_offset), length);
+		return length;
+	}
+
+	if (fseek(file, offset, SEEK_SET) != 0)
+		return 0;
+
+	return fread(dest, 1, length, file);
+}
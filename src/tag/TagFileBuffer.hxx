@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MPD_TAG_FILE_BUFFER_HXX
+#define MPD_TAG_FILE_BUFFER_HXX
+
+#include "check.h"
+
+#include <stdio.h>
+#include <stddef.h>
+
+class Path;
+
+/**
+ * A file opened for scanning its tags.  The head and the tail of the
+ * file, where ID3 and APE tags are usually located, are read into
+ * memory once, so several tag parsers can examine the same file with
+ * one open() and two read() calls.  Reads outside these regions fall
+ * back to seeking in the open file.
+ */
+class TagFileBuffer {
+	static constexpr size_t HEAD_SIZE = 8192;
+	static constexpr size_t TAIL_SIZE = 8192;
+
+	FILE *file;
+
+	/**
+	 * The total size of the file in bytes.
+	 */
+	long size;
+
+	size_t head_size;
+
+	/**
+	 * The file offset of #tail.
+	 */
+	long tail_offset;
+
+	size_t tail_size;
+
+	char head[HEAD_SIZE];
+	char tail[TAIL_SIZE];
+
+public:
+	explicit TagFileBuffer(Path path_fs);
+	~TagFileBuffer();
+
+	TagFileBuffer(const TagFileBuffer &) = delete;
+	TagFileBuffer &operator=(const TagFileBuffer &) = delete;
+
+	/**
+	 * Was the file opened successfully?
+	 */
+	bool IsDefined() const {
+		return file != nullptr;
+	}
+
+	long GetSize() const {
+		return size;
+	}
+
+	/**
+	 * Copy data from the specified file offset.  Negative offsets
+	 * are relative to the end of the file.
+	 *
+	 * @return the number of bytes copied (less than #length at
+	 * the end of the file or on error)
+	 */
+	size_t Read(long offset, void *dest, size_t length);
+
+	/**
+	 * Returns the underlying stdio handle, for parsers which
+	 * walk through the file sequentially.  They must not close
+	 * it.
+	 */
+	FILE *GetFile() {
+		return file;
+	}
+};
+
+#endif
@@ -30,8 +30,8 @@
 #include "config/ConfigGlobal.hxx"
 #include "Riff.hxx"
 #include "Aiff.hxx"
+#include "TagFileBuffer.hxx"
 #include "fs/Path.hxx"
-#include "fs/FileSystem.hxx"
 
 #ifdef HAVE_GLIB
 #include <glib.h>
@@ -41,6 +41,7 @@
 
 #include <string>
 
+#include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -384,29 +385,29 @@ tag_id3_import(struct id3_tag *tag)
 		: tag_builder.CommitNew();
 }
 
-static size_t
-fill_buffer(void *buf, size_t size, FILE *stream, long offset, int whence)
-{
-	if (fseek(stream, offset, whence) != 0) return 0;
-	return fread(buf, 1, size, stream);
-}
-
 static long
-get_id3v2_footer_size(FILE *stream, long offset, int whence)
+get_id3v2_footer_size(TagFileBuffer &file, long offset)
 {
 	id3_byte_t buf[ID3_TAG_QUERYSIZE];
-	size_t bufsize = fill_buffer(buf, ID3_TAG_QUERYSIZE, stream, offset, whence);
+	size_t bufsize = file.Read(offset, buf, ID3_TAG_QUERYSIZE);
 	if (bufsize == 0) return 0;
 	return id3_tag_query(buf, bufsize);
 }
 
+/**
+ * Parse the ID3 tag at the specified (non-negative) file offset.
+ *
+ * @param end_r on success, receives the file offset after the tag
+ */
 static struct id3_tag *
-tag_id3_read(FILE *stream, long offset, int whence)
+tag_id3_read(TagFileBuffer &file, long offset, long &end_r)
 {
+	assert(offset >= 0);
+
 	/* It's ok if we get less than we asked for */
 	id3_byte_t query_buffer[ID3_TAG_QUERYSIZE];
-	size_t query_buffer_size = fill_buffer(query_buffer, ID3_TAG_QUERYSIZE,
-					       stream, offset, whence);
+	size_t query_buffer_size = file.Read(offset, query_buffer,
+					     ID3_TAG_QUERYSIZE);
 	if (query_buffer_size <= 0)
 		return nullptr;
 
@@ -416,22 +417,24 @@ tag_id3_read(FILE *stream, long offset, int whence)
 
 	/* Found a tag.  Allocate a buffer and read it in. */
 	id3_byte_t *tag_buffer = new id3_byte_t[tag_size];
-	int tag_buffer_size = fill_buffer(tag_buffer, tag_size,
-					  stream, offset, whence);
-	if (tag_buffer_size < tag_size) {
+	size_t tag_buffer_size = file.Read(offset, tag_buffer, tag_size);
+	if (tag_buffer_size < size_t(tag_size)) {
 		delete[] tag_buffer;
 		return nullptr;
 	}
 
 	id3_tag *tag = id3_tag_parse(tag_buffer, tag_buffer_size);
 	delete[] tag_buffer;
+
+	end_r = offset + tag_size;
 	return tag;
 }
 
 static struct id3_tag *
-tag_id3_find_from_beginning(FILE *stream)
+tag_id3_find_from_beginning(TagFileBuffer &file)
 {
-	id3_tag *tag = tag_id3_read(stream, 0, SEEK_SET);
+	long end;
+	id3_tag *tag = tag_id3_read(file, 0, end);
 	if (!tag) {
 		return nullptr;
 	} else if (tag_is_id3v1(tag)) {
@@ -448,8 +451,9 @@ tag_id3_find_from_beginning(FILE *stream)
 		if (seek < 0)
 			break;
 
-		/* Get the tag specified by the SEEK frame */
-		id3_tag *seektag = tag_id3_read(stream, seek, SEEK_CUR);
+		/* Get the tag specified by the SEEK frame; the offset
+		   is relative to the end of the current tag */
+		id3_tag *seektag = tag_id3_read(file, end + seek, end);
 		if (!seektag || tag_is_id3v1(seektag))
 			break;
 
@@ -462,18 +466,28 @@ tag_id3_find_from_beginning(FILE *stream)
 }
 
 static struct id3_tag *
-tag_id3_find_from_end(FILE *stream)
+tag_id3_find_from_end(TagFileBuffer &file)
 {
+	const long size = file.GetSize();
+	long end;
+
 	/* Get an id3v1 tag from the end of file for later use */
-	id3_tag *v1tag = tag_id3_read(stream, -128, SEEK_END);
+	id3_tag *v1tag = size >= 128
+		? tag_id3_read(file, size - 128, end)
+		: nullptr;
 
 	/* Get the id3v2 tag size from the footer (located before v1tag) */
-	int tagsize = get_id3v2_footer_size(stream, (v1tag ? -128 : 0) - 10, SEEK_END);
-	if (tagsize >= 0)
+	const long footer_offset = (v1tag ? size - 128 : size) - 10;
+	if (footer_offset < 0)
 		return v1tag;
 
-	/* Get the tag which the footer belongs to */
-	id3_tag *tag = tag_id3_read(stream, tagsize, SEEK_CUR);
+	int tagsize = get_id3v2_footer_size(file, footer_offset);
+	if (tagsize >= 0 || footer_offset + tagsize < 0)
+		return v1tag;
+
+	/* Get the tag which the footer belongs to; the (negative)
+	   size is relative to the beginning of the footer */
+	id3_tag *tag = tag_id3_read(file, footer_offset + tagsize, end);
 	if (!tag)
 		return v1tag;
 
@@ -510,25 +524,45 @@ tag_id3_riff_aiff_load(FILE *file)
 }
 
 struct id3_tag *
-tag_id3_load(Path path_fs, Error &error)
+tag_id3_load(TagFileBuffer &file)
 {
-	FILE *file = FOpen(path_fs, "rb");
-	if (file == nullptr) {
-		error.FormatErrno("Failed to open file %s", path_fs.c_str());
-		return nullptr;
-	}
+	assert(file.IsDefined());
 
 	struct id3_tag *tag = tag_id3_find_from_beginning(file);
 	if (tag == nullptr) {
-		tag = tag_id3_riff_aiff_load(file);
+		tag = tag_id3_riff_aiff_load(file.GetFile());
 		if (tag == nullptr)
 			tag = tag_id3_find_from_end(file);
 	}
 
-	fclose(file);
 	return tag;
 }
 
+struct id3_tag *
+tag_id3_load(Path path_fs, Error &error)
+{
+	TagFileBuffer file(path_fs);
+	if (!file.IsDefined()) {
+		error.FormatErrno("Failed to open file %s", path_fs.c_str());
+		return nullptr;
+	}
+
+	return tag_id3_load(file);
+}
+
+bool
+tag_id3_scan(TagFileBuffer &file,
+	     const struct tag_handler *handler, void *handler_ctx)
+{
+	struct id3_tag *tag = tag_id3_load(file);
+	if (tag == nullptr)
+		return false;
+
+	scan_id3_tag(tag, handler, handler_ctx);
+	id3_tag_delete(tag);
+	return true;
+}
+
 bool
 tag_id3_scan(Path path_fs,
 	     const struct tag_handler *handler, void *handler_ctx)
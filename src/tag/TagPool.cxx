@@ -20,71 +20,239 @@
 #include "config.h"
 #include "TagPool.hxx"
 #include "TagItem.hxx"
+#include "thread/Mutex.hxx"
 #include "util/Cast.hxx"
 #include "util/VarSize.hxx"
 
+#include <vector>
+
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
 
-Mutex tag_pool_lock;
+/**
+ * The number of independently locked parts of the pool.  Must be a
+ * power of two.
+ */
+static constexpr unsigned NUM_STRIPES = 16;
+
+/**
+ * The initial table size of each stripe.  Must be a power of two.
+ */
+static constexpr size_t INITIAL_CAPACITY = 256;
+
+TagItem **tag_pool_index[TAG_POOL_MAX_CHUNKS];
+
+/**
+ * Hands out #TagPoolId values and maintains #tag_pool_index.  Ids of
+ * deleted items are recycled, so the index stays as small as the
+ * largest number of items the pool ever had.
+ */
+class TagPoolIdAllocator {
+	Mutex mutex;
+
+	/**
+	 * The lowest id which has never been used.
+	 */
+	TagPoolId next;
+
+	/**
+	 * Ids which were released and may be used again.
+	 */
+	std::vector<TagPoolId> released;
+
+public:
+	TagPoolIdAllocator():next(0) {}
+
+	TagPoolId Allocate(TagItem &item);
+	void Release(TagPoolId id);
+
+	size_t GetMemoryUsage();
+};
+
+static TagPoolIdAllocator id_allocator;
+
+static inline TagItem *&
+tag_pool_index_entry(TagPoolId id)
+{
+	return tag_pool_index[id >> TAG_POOL_CHUNK_BITS]
+		[id & (TAG_POOL_CHUNK_SIZE - 1)];
+}
+
+TagPoolId
+TagPoolIdAllocator::Allocate(TagItem &item)
+{
+	const ScopeLock protect(mutex);
+
+	TagPoolId id;
+	if (!released.empty()) {
+		id = released.back();
+		released.pop_back();
+	} else {
+		id = next++;
+
+		auto &chunk = tag_pool_index[id >> TAG_POOL_CHUNK_BITS];
+		if (chunk == nullptr) {
+			if ((id >> TAG_POOL_CHUNK_BITS) >= TAG_POOL_MAX_CHUNKS)
+				/* more than 64 million distinct tag
+				   values; this is not going to happen */
+				abort();
 
-static constexpr size_t NUM_SLOTS = 4096;
+			chunk = new TagItem *[TAG_POOL_CHUNK_SIZE];
+		}
+	}
+
+	/* the caller passes the id to other threads only with a
+	   mutex (the stripe's or the database's), which makes this
+	   store visible to lock-free readers */
+	tag_pool_index_entry(id) = &item;
+	return id;
+}
+
+void
+TagPoolIdAllocator::Release(TagPoolId id)
+{
+	const ScopeLock protect(mutex);
+
+	assert(id < next);
+
+	tag_pool_index_entry(id) = nullptr;
+	released.push_back(id);
+}
+
+size_t
+TagPoolIdAllocator::GetMemoryUsage()
+{
+	const ScopeLock protect(mutex);
+
+	const size_t n_chunks =
+		(next + TAG_POOL_CHUNK_SIZE - 1) / TAG_POOL_CHUNK_SIZE;
+	return n_chunks * TAG_POOL_CHUNK_SIZE * sizeof(TagItem *) +
+		released.capacity() * sizeof(TagPoolId);
+}
 
 struct TagPoolSlot {
-	TagPoolSlot *next;
+	unsigned hash;
+	TagPoolId id;
 	unsigned char ref;
 	TagItem item;
 
-	TagPoolSlot(TagPoolSlot *_next, TagType type,
+	TagPoolSlot(unsigned _hash, TagType type,
 		    const char *value, size_t length)
-		:next(_next), ref(1) {
+		:hash(_hash), ref(1) {
 		item.type = type;
 		memcpy(item.value, value, length);
 		item.value[length] = 0;
+		id = id_allocator.Allocate(item);
+	}
+
+	~TagPoolSlot() {
+		id_allocator.Release(id);
 	}
 
-	static TagPoolSlot *Create(TagPoolSlot *_next, TagType type,
+	static size_t GetAllocationSize(size_t length) {
+		return sizeof(TagPoolSlot) - sizeof(item.value) + length + 1;
+	}
+
+	static TagPoolSlot *Create(unsigned hash, TagType type,
 				   const char *value, size_t length);
 } gcc_packed;
 
 TagPoolSlot *
-TagPoolSlot::Create(TagPoolSlot *_next, TagType type,
+TagPoolSlot::Create(unsigned hash, TagType type,
 		    const char *value, size_t length)
 {
 	TagPoolSlot *dummy;
 	return NewVarSize<TagPoolSlot>(sizeof(dummy->item.value),
 				       length + 1,
-				       _next, type,
+				       hash, type,
 				       value, length);
 }
 
-static TagPoolSlot *slots[NUM_SLOTS];
+/**
+ * One part of the tag pool: an open addressing hash table with
+ * linear probing, protected by its own mutex.  The table grows and
+ * shrinks with the number of items.
+ */
+class TagPoolStripe {
+	Mutex mutex;
 
-static inline unsigned
-calc_hash_n(TagType type, const char *p, size_t length)
-{
-	unsigned hash = 5381;
+	/**
+	 * The hash table; nullptr entries are empty.  nullptr if
+	 * #capacity is zero.
+	 */
+	TagPoolSlot **table;
 
-	assert(p != nullptr);
+	/**
+	 * The size of #table, a power of two (or zero).
+	 */
+	size_t capacity;
 
-	while (length-- > 0)
-		hash = (hash << 5) + hash + *p++;
+	/**
+	 * The number of non-empty entries in #table.
+	 */
+	size_t n_items;
+
+	/**
+	 * The sum of all item allocation sizes.
+	 */
+	size_t item_bytes;
+
+public:
+	TagPoolStripe()
+		:table(nullptr), capacity(0), n_items(0), item_bytes(0) {}
+
+	TagPoolId Get(unsigned hash, TagType type,
+		      const char *value, size_t length);
+	TagPoolId Dup(TagPoolSlot &slot);
+	void Put(TagPoolSlot &slot);
+
+	void AddStats(TagPoolStats &stats);
+
+private:
+	size_t GetHome(unsigned hash) const {
+		/* the lower bits were used to choose the stripe */
+		return (hash / NUM_STRIPES) & (capacity - 1);
+	}
+
+	size_t Next(size_t i) const {
+		return (i + 1) & (capacity - 1);
+	}
+
+	TagPoolSlot *Find(unsigned hash, TagType type,
+			  const char *value, size_t length) const;
 
-	return hash ^ type;
+	void Insert(TagPoolSlot &slot);
+	void Remove(TagPoolSlot &slot);
+	void Resize(size_t new_capacity);
+};
+
+static TagPoolStripe stripes[NUM_STRIPES];
+
+/**
+ * Scramble the bits of the string hash, because the lower bits
+ * choose the stripe and the other bits the table position.
+ */
+static inline unsigned
+mix_hash(unsigned h)
+{
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	return h;
 }
 
 static inline unsigned
-calc_hash(TagType type, const char *p)
+calc_hash_n(TagType type, const char *p, size_t length)
 {
 	unsigned hash = 5381;
 
 	assert(p != nullptr);
 
-	while (*p != 0)
+	while (length-- > 0)
 		hash = (hash << 5) + hash + *p++;
 
-	return hash ^ type;
+	return mix_hash(hash ^ type);
 }
 
 #if defined(__clang__) || GCC_CHECK_VERSION(4,7)
@@ -96,79 +264,211 @@ tag_item_to_slot(TagItem *item)
 	return &ContainerCast(*item, &TagPoolSlot::item);
 }
 
-static inline TagPoolSlot **
-tag_value_slot_p(TagType type, const char *value, size_t length)
+static inline TagPoolSlot &
+tag_id_to_slot(TagPoolId id)
 {
-	return &slots[calc_hash_n(type, value, length) % NUM_SLOTS];
+	TagItem *item = tag_pool_index_entry(id);
+	assert(item != nullptr);
+	return *tag_item_to_slot(item);
 }
 
-static inline TagPoolSlot **
-tag_value_slot_p(TagType type, const char *value)
+static inline TagPoolStripe &
+tag_hash_to_stripe(unsigned hash)
 {
-	return &slots[calc_hash(type, value) % NUM_SLOTS];
+	return stripes[hash % NUM_STRIPES];
 }
 
-TagItem *
-tag_pool_get_item(TagType type, const char *value, size_t length)
+inline TagPoolSlot *
+TagPoolStripe::Find(unsigned hash, TagType type,
+		    const char *value, size_t length) const
 {
-	auto slot_p = tag_value_slot_p(type, value, length);
-	for (auto slot = *slot_p; slot != nullptr; slot = slot->next) {
-		if (slot->item.type == type &&
+	if (capacity == 0)
+		return nullptr;
+
+	for (size_t i = GetHome(hash); table[i] != nullptr; i = Next(i)) {
+		TagPoolSlot *slot = table[i];
+		if (slot->hash == hash && slot->item.type == type &&
 		    length == strlen(slot->item.value) &&
 		    memcmp(value, slot->item.value, length) == 0 &&
-		    slot->ref < 0xff) {
-			assert(slot->ref > 0);
-			++slot->ref;
-			return &slot->item;
-		}
+		    slot->ref < 0xff)
+			return slot;
+	}
+
+	return nullptr;
+}
+
+void
+TagPoolStripe::Resize(size_t new_capacity)
+{
+	assert(new_capacity == 0 || new_capacity > n_items);
+
+	TagPoolSlot **const old_table = table;
+	const size_t old_capacity = capacity;
+
+	capacity = new_capacity;
+	table = new_capacity > 0
+		? new TagPoolSlot *[new_capacity]()
+		: nullptr;
+
+	for (size_t i = 0; i < old_capacity; ++i) {
+		TagPoolSlot *slot = old_table[i];
+		if (slot == nullptr)
+			continue;
+
+		size_t j = GetHome(slot->hash);
+		while (table[j] != nullptr)
+			j = Next(j);
+		table[j] = slot;
 	}
 
-	auto slot = TagPoolSlot::Create(*slot_p, type, value, length);
-	*slot_p = slot;
-	return &slot->item;
+	delete[] old_table;
+}
+
+inline void
+TagPoolStripe::Insert(TagPoolSlot &slot)
+{
+	/* keep the load factor below 3/4 */
+	if (capacity == 0)
+		Resize(INITIAL_CAPACITY);
+	else if ((n_items + 1) * 4 > capacity * 3)
+		Resize(capacity * 2);
+
+	size_t i = GetHome(slot.hash);
+	while (table[i] != nullptr)
+		i = Next(i);
+
+	table[i] = &slot;
+	++n_items;
+	item_bytes += TagPoolSlot::GetAllocationSize(strlen(slot.item.value));
 }
 
-TagItem *
-tag_pool_dup_item(TagItem *item)
+inline void
+TagPoolStripe::Remove(TagPoolSlot &slot)
 {
-	TagPoolSlot *slot = tag_item_to_slot(item);
+	assert(n_items > 0);
 
-	assert(slot->ref > 0);
+	size_t i = GetHome(slot.hash);
+	while (table[i] != &slot) {
+		assert(table[i] != nullptr);
+		i = Next(i);
+	}
 
-	if (slot->ref < 0xff) {
+	/* backward shift deletion: move all following entries of
+	   this cluster which may not live behind the hole anymore */
+	for (size_t j = Next(i); table[j] != nullptr; j = Next(j)) {
+		const size_t home = GetHome(table[j]->hash);
+		const bool stays = i <= j
+			? (i < home && home <= j)
+			: (i < home || home <= j);
+		if (!stays) {
+			table[i] = table[j];
+			i = j;
+		}
+	}
+
+	table[i] = nullptr;
+	--n_items;
+	item_bytes -= TagPoolSlot::GetAllocationSize(strlen(slot.item.value));
+
+	if (n_items == 0)
+		Resize(0);
+	else if (capacity > INITIAL_CAPACITY && n_items * 8 < capacity)
+		Resize(capacity / 2);
+}
+
+TagPoolId
+TagPoolStripe::Get(unsigned hash, TagType type,
+		   const char *value, size_t length)
+{
+	const ScopeLock protect(mutex);
+
+	TagPoolSlot *slot = Find(hash, type, value, length);
+	if (slot != nullptr) {
+		assert(slot->ref > 0);
 		++slot->ref;
-		return item;
+		return slot->id;
+	}
+
+	slot = TagPoolSlot::Create(hash, type, value, length);
+	Insert(*slot);
+	return slot->id;
+}
+
+TagPoolId
+TagPoolStripe::Dup(TagPoolSlot &slot)
+{
+	const ScopeLock protect(mutex);
+
+	assert(slot.ref > 0);
+
+	if (slot.ref < 0xff) {
+		++slot.ref;
+		return slot.id;
 	} else {
 		/* the reference counter overflows above 0xff;
 		   duplicate the item, and start with 1 */
-		size_t length = strlen(item->value);
-		auto slot_p = tag_value_slot_p(item->type,
-					       item->value, length);
-		slot = TagPoolSlot::Create(*slot_p, item->type,
-					   item->value, strlen(item->value));
-		*slot_p = slot;
-		return &slot->item;
+		auto *copy = TagPoolSlot::Create(slot.hash, slot.item.type,
+						 slot.item.value,
+						 strlen(slot.item.value));
+		Insert(*copy);
+		return copy->id;
 	}
 }
 
 void
-tag_pool_put_item(TagItem *item)
+TagPoolStripe::Put(TagPoolSlot &slot)
 {
-	TagPoolSlot **slot_p, *slot;
+	const ScopeLock protect(mutex);
 
-	slot = tag_item_to_slot(item);
-	assert(slot->ref > 0);
-	--slot->ref;
+	assert(slot.ref > 0);
+	--slot.ref;
 
-	if (slot->ref > 0)
+	if (slot.ref > 0)
 		return;
 
-	for (slot_p = tag_value_slot_p(item->type, item->value);
-	     *slot_p != slot;
-	     slot_p = &(*slot_p)->next) {
-		assert(*slot_p != nullptr);
-	}
+	Remove(slot);
+	DeleteVarSize(&slot);
+}
+
+void
+TagPoolStripe::AddStats(TagPoolStats &stats)
+{
+	const ScopeLock protect(mutex);
+
+	stats.items += n_items;
+	stats.bytes += item_bytes + capacity * sizeof(*table);
+}
+
+TagPoolId
+tag_pool_get_item(TagType type, const char *value, size_t length)
+{
+	const unsigned hash = calc_hash_n(type, value, length);
+	return tag_hash_to_stripe(hash).Get(hash, type, value, length);
+}
+
+TagPoolId
+tag_pool_dup_item(TagPoolId id)
+{
+	TagPoolSlot &slot = tag_id_to_slot(id);
+	return tag_hash_to_stripe(slot.hash).Dup(slot);
+}
+
+void
+tag_pool_put_item(TagPoolId id)
+{
+	TagPoolSlot &slot = tag_id_to_slot(id);
+	tag_hash_to_stripe(slot.hash).Put(slot);
+}
+
+TagPoolStats
+tag_pool_get_stats()
+{
+	TagPoolStats stats;
+	stats.items = 0;
+	stats.bytes = id_allocator.GetMemoryUsage();
+
+	for (auto &stripe : stripes)
+		stripe.AddStats(stats);
 
-	*slot_p = slot->next;
-	DeleteVarSize(slot);
+	return stats;
 }
@@ -21,19 +21,76 @@
 #define MPD_TAG_POOL_HXX
 
 #include "TagType.h"
-#include "thread/Mutex.hxx"
+#include "Compiler.h"
 
-extern Mutex tag_pool_lock;
+#include <stdint.h>
+#include <stddef.h>
 
 struct TagItem;
 
-TagItem *
+/*
+ * The tag pool shares #TagItem objects with the same type and value,
+ * with reference counting.  These functions are thread-safe; the pool
+ * is split into independently locked stripes, so concurrent callers
+ * rarely contend.
+ *
+ * Items are referred to by a 32 bit id instead of a pointer, which
+ * halves the size of the item arrays in all #Tag objects on 64 bit
+ * machines.
+ */
+
+/**
+ * Identifies a #TagItem in the pool.  Two ids may refer to items
+ * with the same type and value.
+ */
+typedef uint32_t TagPoolId;
+
+static constexpr unsigned TAG_POOL_CHUNK_BITS = 12;
+static constexpr unsigned TAG_POOL_CHUNK_SIZE = 1u << TAG_POOL_CHUNK_BITS;
+static constexpr unsigned TAG_POOL_MAX_CHUNKS = 1u << 14;
+
+/**
+ * Maps ids to items; this is an implementation detail of
+ * tag_pool_lookup().  The chunks are allocated on demand and are
+ * never freed.
+ */
+extern TagItem **tag_pool_index[TAG_POOL_MAX_CHUNKS];
+
+/**
+ * Returns the #TagItem with the specified id.  The caller must own a
+ * reference.  This function does not lock anything.
+ */
+gcc_pure
+static inline const TagItem &
+tag_pool_lookup(TagPoolId id)
+{
+	return *tag_pool_index[id >> TAG_POOL_CHUNK_BITS]
+		[id & (TAG_POOL_CHUNK_SIZE - 1)];
+}
+
+TagPoolId
 tag_pool_get_item(TagType type, const char *value, size_t length);
 
-TagItem *
-tag_pool_dup_item(TagItem *item);
+TagPoolId
+tag_pool_dup_item(TagPoolId id);
 
 void
-tag_pool_put_item(TagItem *item);
+tag_pool_put_item(TagPoolId id);
+
+struct TagPoolStats {
+	/**
+	 * The number of items in the pool.
+	 */
+	size_t items;
+
+	/**
+	 * The number of bytes allocated for items, hash tables and
+	 * the id index.
+	 */
+	size_t bytes;
+};
+
+TagPoolStats
+tag_pool_get_stats();
 
 #endif
@@ -32,6 +32,8 @@
 
 #include "WritableBuffer.hxx"
 
+#include <algorithm>
+
 #include <assert.h>
 #include <stddef.h>
 
@@ -65,8 +67,8 @@ protected:
 	 */
 	size_type tail;
 
-	const size_type capacity;
-	const pointer_type data;
+	size_type capacity;
+	pointer_type data;
 
 public:
 	constexpr CircularBuffer(pointer_type _data, size_type _capacity)
@@ -167,6 +169,31 @@ public:
 		return Range(data + head, (tail < head ? capacity : tail) - head);
 	}
 
+	/**
+	 * Move the contents of this buffer to a new (larger) buffer.
+	 * The old buffer is returned; the caller is responsible for
+	 * freeing it.
+	 */
+	pointer_type Relocate(pointer_type new_data, size_type new_capacity) {
+		assert(new_capacity > GetSize());
+
+		const size_type size = GetSize();
+		if (head <= tail) {
+			std::copy(data + head, data + tail, new_data);
+		} else {
+			pointer_type p = std::copy(data + head, data + capacity,
+						   new_data);
+			std::copy(data, data + tail, p);
+		}
+
+		pointer_type old_data = data;
+		data = new_data;
+		capacity = new_capacity;
+		head = 0;
+		tail = size;
+		return old_data;
+	}
+
 	/**
 	 * Marks a chunk as consumed.
 	 */
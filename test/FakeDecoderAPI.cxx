@@ -72,6 +72,37 @@ decoder_seek_error(gcc_unused Decoder &decoder)
 {
 }
 
+bool
+decoder_seek_index_lookup(gcc_unused Decoder &decoder,
+			  gcc_unused InputStream &is,
+			  gcc_unused SongTime time,
+			  gcc_unused SeekPoint &result)
+{
+	return false;
+}
+
+void
+decoder_seek_index_add(gcc_unused Decoder &decoder,
+		       gcc_unused InputStream &is,
+		       gcc_unused SongTime time,
+		       gcc_unused offset_type offset)
+{
+}
+
+SignedSongTime
+decoder_seek_index_duration(gcc_unused Decoder &decoder,
+			    gcc_unused InputStream &is)
+{
+	return SignedSongTime::Negative();
+}
+
+void
+decoder_seek_index_set_duration(gcc_unused Decoder &decoder,
+				gcc_unused InputStream &is,
+				gcc_unused SignedSongTime duration)
+{
+}
+
 InputStream *
 decoder_open_uri(Decoder &decoder, const char *uri, Error &error)
 {
@@ -127,15 +158,38 @@ decoder_timestamp(gcc_unused Decoder &decoder,
 }
 
 DecoderCommand
-decoder_data(gcc_unused Decoder &decoder,
+decoder_data(Decoder &decoder,
 	     gcc_unused InputStream *is,
 	     const void *data, size_t datalen,
 	     gcc_unused uint16_t kbit_rate)
 {
+	decoder.data_bytes += datalen;
+	++decoder.data_calls;
+
 	gcc_unused ssize_t nbytes = write(1, data, datalen);
 	return DecoderCommand::NONE;
 }
 
+WritableBuffer<void>
+decoder_write_buffer(Decoder &decoder,
+		     gcc_unused InputStream *is,
+		     gcc_unused uint16_t kbit_rate)
+{
+	return { decoder.write_buffer, sizeof(decoder.write_buffer) };
+}
+
+DecoderCommand
+decoder_commit(Decoder &decoder, size_t length)
+{
+	assert(length <= sizeof(decoder.write_buffer));
+
+	decoder.commit_bytes += length;
+	++decoder.commit_calls;
+
+	gcc_unused ssize_t nbytes = write(1, decoder.write_buffer, length);
+	return DecoderCommand::NONE;
+}
+
 DecoderCommand
 decoder_tag(gcc_unused Decoder &decoder,
 	    gcc_unused InputStream *is,
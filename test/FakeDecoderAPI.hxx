@@ -24,14 +24,31 @@
 #include "thread/Mutex.hxx"
 #include "thread/Cond.hxx"
 
+#include <stdint.h>
+
 struct Decoder {
 	Mutex mutex;
 	Cond cond;
 
 	bool initialized;
 
+	/**
+	 * The buffer returned by decoder_write_buffer(); same size as
+	 * MusicChunk::data.
+	 */
+	uint8_t write_buffer[4096];
+
+	/**
+	 * Statistics printed by run_decoder, to compare the
+	 * decoder_data() and decoder_write_buffer() code paths.
+	 */
+	uint64_t data_bytes, commit_bytes;
+	unsigned data_calls, commit_calls;
+
 	Decoder()
-		:initialized(false) {}
+		:initialized(false),
+		 data_bytes(0), commit_bytes(0),
+		 data_calls(0), commit_calls(0) {}
 };
 
 #endif
@@ -16,6 +16,7 @@
 class TestCircularBuffer : public CppUnit::TestFixture {
 	CPPUNIT_TEST_SUITE(TestCircularBuffer);
 	CPPUNIT_TEST(TestIt);
+	CPPUNIT_TEST(TestRelocate);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -160,4 +161,38 @@ public:
 		CPPUNIT_ASSERT_EQUAL(&data[3], buffer.Write().data);
 		CPPUNIT_ASSERT_EQUAL(size_t(5), buffer.Write().size);
 	}
+
+	void TestRelocate() {
+		static size_t N = 8;
+		int data[N];
+		CircularBuffer<int> buffer(data, N);
+
+		/* fill [0..6], then wrap around: [OOX..OOO] */
+		for (int i = 0; i < 7; ++i)
+			data[i] = i;
+		buffer.Append(7);
+		buffer.Consume(5);
+		auto w = buffer.Write();
+		CPPUNIT_ASSERT_EQUAL(&data[7], w.data);
+		w.data[0] = 7;
+		buffer.Append(1);
+		w = buffer.Write();
+		CPPUNIT_ASSERT_EQUAL(&data[0], w.data);
+		w.data[0] = 8;
+		w.data[1] = 9;
+		buffer.Append(2);
+		CPPUNIT_ASSERT_EQUAL(size_t(5), buffer.GetSize());
+
+		int data2[16];
+		CPPUNIT_ASSERT_EQUAL(&data[0], buffer.Relocate(data2, 16));
+		CPPUNIT_ASSERT_EQUAL(size_t(16), buffer.GetCapacity());
+		CPPUNIT_ASSERT_EQUAL(size_t(5), buffer.GetSize());
+		CPPUNIT_ASSERT_EQUAL(size_t(10), buffer.GetSpace());
+
+		auto r = buffer.Read();
+		CPPUNIT_ASSERT_EQUAL(&data2[0], r.data);
+		CPPUNIT_ASSERT_EQUAL(size_t(5), r.size);
+		for (int i = 0; i < 5; ++i)
+			CPPUNIT_ASSERT_EQUAL(5 + i, r.data[i]);
+	}
 };
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program measures the "proxy" database plugin against a local
+ * "upstream" MPD instance: it walks the whole remote database and
+ * lists all artists several times, first with the response cache
+ * disabled, then with the cache enabled, and verifies that both
+ * return the same results.
+ *
+ * Start the upstream instance first, e.g. "mpd --no-daemon
+ * upstream.conf", then run "bench_proxy_db localhost 6600".
+ */
+
+#include "config.h"
+#include "db/plugins/ProxyDatabasePlugin.hxx"
+#include "db/DatabasePlugin.hxx"
+#include "db/DatabaseListener.hxx"
+#include "db/Interface.hxx"
+#include "db/Selection.hxx"
+#include "db/LightDirectory.hxx"
+#include "db/LightSong.hxx"
+#include "db/PlaylistInfo.hxx"
+#include "config/ConfigData.hxx"
+#include "event/Loop.hxx"
+#include "tag/Tag.hxx"
+#include "system/Clock.hxx"
+#include "util/Error.hxx"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+class MyDatabaseListener final : public DatabaseListener {
+public:
+	virtual void OnDatabaseModified() override {}
+	virtual void OnDatabaseSongRemoved(const LightSong &) override {}
+};
+
+struct Counters {
+	unsigned directories, songs, playlists, artists;
+
+	Counters()
+		:directories(0), songs(0), playlists(0), artists(0) {}
+
+	bool operator==(const Counters &other) const {
+		return directories == other.directories &&
+			songs == other.songs &&
+			playlists == other.playlists &&
+			artists == other.artists;
+	}
+};
+
+static void
+Report(const char *name, unsigned i, uint64_t start_us)
+{
+	const uint64_t duration_us = MonotonicClockUS() - start_us;
+	printf("%-16s pass %u %10.3f ms\n",
+	       name, i, duration_us / 1000.);
+}
+
+static bool
+Run(EventLoop &event_loop, const char *host, const char *port,
+    const char *cache_size, unsigned n_passes, Counters &counters)
+{
+	config_param param("database");
+	param.AddBlockParam("host", host);
+	param.AddBlockParam("port", port);
+	param.AddBlockParam("cache_size", cache_size);
+
+	MyDatabaseListener listener;
+	Error error;
+	Database *db = proxy_db_plugin.create(event_loop, listener,
+					      param, error);
+	if (db == nullptr || !db->Open(error)) {
+		delete db;
+		fprintf(stderr, "%s\n", error.GetMessage());
+		return false;
+	}
+
+	const DatabaseSelection selection("", true);
+
+	char name[32];
+	snprintf(name, sizeof(name), "cache_size=%s", cache_size);
+
+	bool success = true;
+	for (unsigned i = 0; success && i < n_passes; ++i) {
+		counters = Counters();
+
+		const uint64_t start = MonotonicClockUS();
+
+		success = db->Visit(selection,
+				    [&counters](const LightDirectory &,
+						Error &) {
+					    ++counters.directories;
+					    return true;
+				    },
+				    [&counters](const LightSong &, Error &) {
+					    ++counters.songs;
+					    return true;
+				    },
+				    [&counters](const PlaylistInfo &,
+						const LightDirectory &,
+						Error &) {
+					    ++counters.playlists;
+					    return true;
+				    },
+				    error) &&
+			db->VisitUniqueTags(selection, TAG_ARTIST, 0,
+					    [&counters](const Tag &, Error &) {
+						    ++counters.artists;
+						    return true;
+					    },
+					    error);
+
+		Report(name, i, start);
+	}
+
+	if (!success)
+		fprintf(stderr, "%s\n", error.GetMessage());
+
+	db->Close();
+	delete db;
+	return success;
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc < 3 || argc > 4) {
+		fprintf(stderr, "Usage: bench_proxy_db HOST PORT [PASSES]\n");
+		return EXIT_FAILURE;
+	}
+
+	const char *const host = argv[1];
+	const char *const port = argv[2];
+	const unsigned n_passes = argc > 3
+		? strtoul(argv[3], nullptr, 10)
+		: 5;
+	if (n_passes == 0) {
+		fprintf(stderr, "Invalid number of passes\n");
+		return EXIT_FAILURE;
+	}
+
+	EventLoop event_loop;
+
+	Counters uncached, cached;
+	if (!Run(event_loop, host, port, "0", n_passes, uncached) ||
+	    !Run(event_loop, host, port, "1000000", n_passes, cached))
+		return EXIT_FAILURE;
+
+	printf("%u directories, %u songs, %u playlists, %u artists\n",
+	       cached.directories, cached.songs, cached.playlists,
+	       cached.artists);
+
+	if (!(cached == uncached)) {
+		fprintf(stderr, "Cached results differ\n");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
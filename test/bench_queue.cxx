@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program measures the cost of bulk queue edits: it fills a
+ * queue with many songs and deletes and moves ranges in both normal
+ * and random mode.
+ */
+
+#include "config.h"
+#include "queue/Queue.hxx"
+#include "DetachedSong.hxx"
+#include "system/Clock.hxx"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+Tag::Tag(const Tag &) {}
+void Tag::Clear() {}
+
+static void
+Fill(Queue &queue, unsigned n)
+{
+	while (queue.GetLength() < n)
+		queue.Append(DetachedSong("foo.ogg"), 0);
+}
+
+static void
+Report(const char *name, unsigned count, uint64_t start_us)
+{
+	const uint64_t duration_us = MonotonicClockUS() - start_us;
+	printf("%-28s %8u ops %10.3f ms\n",
+	       name, count, duration_us / 1000.);
+}
+
+static void
+Run(unsigned length, bool random)
+{
+	printf("%s mode, %u songs:\n", random ? "random" : "normal", length);
+
+	Queue queue(length);
+	Fill(queue, length);
+	queue.random = random;
+	if (random)
+		queue.ShuffleOrder();
+
+	/* delete 100 songs at a time from the middle */
+
+	uint64_t start = MonotonicClockUS();
+	unsigned count = 0;
+	while (queue.GetLength() >= length / 2) {
+		const unsigned position = queue.GetLength() / 2;
+		queue.DeleteRange(position, position + 100);
+		++count;
+	}
+	Report("delete range of 100", count, start);
+
+	/* delete single songs; this is linear per call, so do fewer */
+
+	Fill(queue, length);
+	if (random)
+		queue.ShuffleOrder();
+
+	start = MonotonicClockUS();
+	count = 0;
+	while (queue.GetLength() > length - 5000) {
+		queue.DeletePosition(queue.GetLength() / 2);
+		++count;
+	}
+	Report("delete single song", count, start);
+
+	/* move 1000 songs back and forth */
+
+	Fill(queue, length);
+	if (random)
+		queue.ShuffleOrder();
+
+	start = MonotonicClockUS();
+	for (count = 0; count < 200; ++count) {
+		if (count % 2 == 0)
+			queue.MoveRange(0, 1000, length - 1000);
+		else
+			queue.MoveRange(length - 1000, length, 0);
+	}
+	Report("move range of 1000", count, start);
+
+	/* move single songs */
+
+	start = MonotonicClockUS();
+	for (count = 0; count < 1000; ++count)
+		queue.MovePostion(count, length - 1 - count);
+	Report("move single song", count, start);
+
+	queue.Clear();
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc > 2) {
+		fprintf(stderr, "Usage: bench_queue [LENGTH]\n");
+		return EXIT_FAILURE;
+	}
+
+	const unsigned length = argc > 1
+		? strtoul(argv[1], nullptr, 10)
+		: 100000;
+	if (length < 2000) {
+		fprintf(stderr, "LENGTH must be at least 2000\n");
+		return EXIT_FAILURE;
+	}
+
+	Run(length, false);
+	Run(length, true);
+	return EXIT_SUCCESS;
+}
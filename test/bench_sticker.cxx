@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program measures the sticker database: it stores one value
+ * for many songs, with one transaction per modification and then in
+ * one batch, and loads them twice, the second time from the
+ * in-memory cache.  Finally, it looks up the values below one
+ * directory.
+ */
+
+#include "config.h"
+#include "sticker/StickerDatabase.hxx"
+#include "Idle.hxx"
+#include "fs/Path.hxx"
+#include "system/Clock.hxx"
+#include "util/Error.hxx"
+
+#include <string>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+void
+idle_add(gcc_unused unsigned flags)
+{
+}
+
+static void
+Report(const char *name, unsigned count, uint64_t start_us)
+{
+	const uint64_t duration_us = MonotonicClockUS() - start_us;
+	printf("%-28s %8u values %10.3f ms\n",
+	       name, count, duration_us / 1000.);
+}
+
+static std::string
+MakeURI(unsigned i)
+{
+	char buffer[64];
+	snprintf(buffer, sizeof(buffer), "artist%u/album%u/track%u.flac",
+		 i % 97, i % 1009, i);
+	return buffer;
+}
+
+static bool
+StoreAll(unsigned n, const char *value)
+{
+	for (unsigned i = 0; i < n; ++i)
+		if (!sticker_store_value("song", MakeURI(i).c_str(),
+					 "playcount", value))
+			return false;
+
+	return true;
+}
+
+static bool
+LoadAll(unsigned n, const char *expected)
+{
+	for (unsigned i = 0; i < n; ++i)
+		if (sticker_load_value("song", MakeURI(i).c_str(),
+				       "playcount") != expected)
+			return false;
+
+	return true;
+}
+
+static void
+CountFound(gcc_unused const char *uri, gcc_unused const char *value,
+	   void *ctx)
+{
+	++*(unsigned *)ctx;
+}
+
+static bool
+Find(const char *name, StickerOperator op, const char *value)
+{
+	unsigned n = 0;
+	const uint64_t start = MonotonicClockUS();
+	if (!sticker_find("song", "artist1/", "playcount", op, value,
+			  CountFound, &n))
+		return false;
+
+	Report(name, n, start);
+	return true;
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "Usage: bench_sticker PATH [COUNT]\n");
+		return EXIT_FAILURE;
+	}
+
+	const Path path = Path::FromFS(argv[1]);
+	const unsigned n = argc > 2 ? strtoul(argv[2], nullptr, 10) : 10000;
+
+	if (access(path.c_str(), F_OK) == 0) {
+		fprintf(stderr, "Refusing to overwrite %s\n", path.c_str());
+		return EXIT_FAILURE;
+	}
+
+	Error error;
+	if (!sticker_global_init(path, true, error)) {
+		fprintf(stderr, "%s\n", error.GetMessage());
+		return EXIT_FAILURE;
+	}
+
+	uint64_t start = MonotonicClockUS();
+	bool success = StoreAll(n, "1");
+	Report("set", n, start);
+
+	start = MonotonicClockUS();
+	sticker_begin_batch();
+	success = success && StoreAll(n, "2");
+	success = sticker_end_batch(error) && success;
+	Report("set (batch)", n, start);
+
+	start = MonotonicClockUS();
+	success = success && LoadAll(n, "2");
+	Report("get", n, start);
+
+	start = MonotonicClockUS();
+	success = success && LoadAll(n, "2");
+	Report("get (cached)", n, start);
+
+	success = success &&
+		Find("find", StickerOperator::EXISTS, nullptr) &&
+		Find("find (value > 1)", StickerOperator::GREATER_THAN, "1");
+
+	sticker_global_finish();
+
+	if (!success) {
+		fprintf(stderr, "Sticker operation failed\n");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
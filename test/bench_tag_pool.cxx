@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/*
+ * This program measures the tag pool with a synthetic library of
+ * many distinct tag values: it inserts them, looks them up again and
+ * releases them, first in one thread and then in several concurrent
+ * threads.
+ */
+
+#include "config.h"
+#include "tag/TagPool.hxx"
+#include "tag/TagItem.hxx"
+#include "thread/Thread.hxx"
+#include "system/Clock.hxx"
+#include "util/Error.hxx"
+
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static constexpr TagType types[] = {
+	TAG_TITLE,
+	TAG_ARTIST,
+	TAG_ALBUM,
+	TAG_MUSICBRAINZ_TRACKID,
+};
+
+static size_t
+FormatValue(char *buffer, size_t size, unsigned i)
+{
+	return snprintf(buffer, size, "value %08x-%u", i * 2654435761u, i);
+}
+
+struct Worker {
+	unsigned begin, end;
+	std::vector<TagPoolId> items;
+
+	Thread thread;
+
+	void Run();
+
+	static void Task(void *ctx) {
+		((Worker *)ctx)->Run();
+	}
+};
+
+/**
+ * Insert all values of the range, look them up a second time, and
+ * release both references.
+ */
+void
+Worker::Run()
+{
+	items.reserve(end - begin);
+
+	char buffer[64];
+	for (unsigned i = begin; i < end; ++i) {
+		size_t length = FormatValue(buffer, sizeof(buffer), i);
+		items.push_back(tag_pool_get_item(types[i % 4],
+						  buffer, length));
+	}
+
+	for (unsigned i = begin; i < end; ++i) {
+		size_t length = FormatValue(buffer, sizeof(buffer), i);
+		tag_pool_get_item(types[i % 4], buffer, length);
+	}
+
+	for (auto item : items) {
+		tag_pool_put_item(item);
+		tag_pool_put_item(item);
+	}
+
+	items.clear();
+}
+
+static void
+Report(const char *name, unsigned count, uint64_t start_us)
+{
+	const uint64_t duration_us = MonotonicClockUS() - start_us;
+	printf("%-28s %8u values %10.3f ms\n",
+	       name, count, duration_us / 1000.);
+}
+
+static void
+RunSingle(unsigned n)
+{
+	std::vector<TagPoolId> items;
+	items.reserve(n);
+
+	char buffer[64];
+
+	uint64_t start = MonotonicClockUS();
+	for (unsigned i = 0; i < n; ++i) {
+		size_t length = FormatValue(buffer, sizeof(buffer), i);
+		items.push_back(tag_pool_get_item(types[i % 4],
+						  buffer, length));
+	}
+	Report("insert", n, start);
+
+	start = MonotonicClockUS();
+	for (unsigned i = 0; i < n; ++i) {
+		size_t length = FormatValue(buffer, sizeof(buffer), i);
+		tag_pool_get_item(types[i % 4], buffer, length);
+	}
+	Report("lookup", n, start);
+
+	start = MonotonicClockUS();
+	for (auto item : items)
+		tag_pool_dup_item(item);
+	Report("dup", n, start);
+
+	start = MonotonicClockUS();
+	for (auto item : items) {
+		tag_pool_put_item(item);
+		tag_pool_put_item(item);
+		tag_pool_put_item(item);
+	}
+	Report("release", n, start);
+}
+
+static bool
+RunThreads(unsigned n, unsigned n_threads)
+{
+	std::vector<Worker> workers(n_threads);
+
+	const uint64_t start = MonotonicClockUS();
+
+	for (unsigned i = 0; i < n_threads; ++i) {
+		Worker &w = workers[i];
+		w.begin = n / n_threads * i;
+		w.end = i + 1 == n_threads ? n : n / n_threads * (i + 1);
+
+		Error error;
+		if (!w.thread.Start(Worker::Task, &w, error)) {
+			fprintf(stderr, "%s\n", error.GetMessage());
+			return false;
+		}
+	}
+
+	for (auto &w : workers)
+		w.thread.Join();
+
+	char name[32];
+	snprintf(name, sizeof(name), "%u threads", n_threads);
+	Report(name, n, start);
+	return true;
+}
+
+int
+main(int argc, char **argv)
+{
+	const unsigned n = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+	const unsigned n_threads = argc > 2
+		? strtoul(argv[2], nullptr, 10)
+		: 4;
+
+	if (n == 0 || n_threads == 0) {
+		fprintf(stderr, "Usage: bench_tag_pool [VALUES [THREADS]]\n");
+		return EXIT_FAILURE;
+	}
+
+	RunSingle(n);
+
+	if (!RunThreads(n, 1) || !RunThreads(n, n_threads))
+		return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
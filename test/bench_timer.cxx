@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2003-2014 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/*
+ * This program compares the #TimerWheel with the sorted multiset the
+ * #EventLoop used before.  It simulates many idle clients which
+ * issue commands at random times; each command re-schedules the
+ * client's connection timeout, just like Client does.
+ */
+
+#include "config.h"
+#include "event/TimerWheel.hxx"
+#include "event/Loop.hxx"
+#include "system/Clock.hxx"
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static constexpr unsigned CLIENT_TIMEOUT_MS = 60000;
+
+class FakeClient final : public TimeoutMonitor {
+public:
+	const unsigned index;
+
+	FakeClient(EventLoop &_loop, unsigned _index)
+		:TimeoutMonitor(_loop), index(_index) {}
+
+protected:
+	void OnTimeout() override {}
+};
+
+/**
+ * The old implementation: a sorted multiset with a linear scan for
+ * cancellation.
+ */
+class TimerSet {
+	struct Record {
+		unsigned due_ms;
+		FakeClient *client;
+
+		bool operator<(const Record &other) const {
+			return due_ms < other.due_ms;
+		}
+	};
+
+	std::multiset<Record> records;
+
+public:
+	void Insert(FakeClient &c, unsigned due_ms) {
+		records.insert(Record{due_ms, &c});
+	}
+
+	void Remove(FakeClient &c) {
+		for (auto i = records.begin(); i != records.end(); ++i) {
+			if (i->client == &c) {
+				records.erase(i);
+				return;
+			}
+		}
+	}
+
+	FakeClient *PopDue(unsigned now_ms) {
+		auto i = records.begin();
+		if (i == records.end() || int(i->due_ms - now_ms) > 0)
+			return nullptr;
+
+		FakeClient *c = i->client;
+		records.erase(i);
+		return c;
+	}
+};
+
+struct Command {
+	unsigned time_ms;
+	unsigned client;
+};
+
+template<typename T>
+static uint64_t
+Simulate(T &timers, std::vector<FakeClient *> &clients,
+	 const std::vector<Command> &commands, unsigned duration_ms,
+	 std::vector<bool> &active, unsigned &fired)
+{
+	const uint64_t start = MonotonicClockUS();
+
+	auto command = commands.begin();
+	fired = 0;
+
+	for (unsigned now = 0; now < duration_ms; ++now) {
+		for (; command != commands.end() &&
+			     command->time_ms == now; ++command) {
+			FakeClient &c = *clients[command->client];
+			if (active[command->client])
+				timers.Remove(c);
+
+			timers.Insert(c, now + CLIENT_TIMEOUT_MS);
+			active[command->client] = true;
+		}
+
+		TimeoutMonitor *t;
+		while ((t = timers.PopDue(now)) != nullptr) {
+			active[static_cast<FakeClient *>(t)->index] = false;
+			++fired;
+		}
+	}
+
+	const uint64_t duration = MonotonicClockUS() - start;
+
+	for (unsigned i = 0; i < clients.size(); ++i) {
+		if (active[i]) {
+			timers.Remove(*clients[i]);
+			active[i] = false;
+		}
+	}
+
+	return duration;
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc > 3) {
+		fprintf(stderr, "Usage: bench_timer [CLIENTS [COMMANDS]]\n");
+		return EXIT_FAILURE;
+	}
+
+	const unsigned n_clients = argc > 1
+		? strtoul(argv[1], nullptr, 10)
+		: 10000;
+	const unsigned n_commands = argc > 2
+		? strtoul(argv[2], nullptr, 10)
+		: 100000;
+	if (n_clients == 0) {
+		fprintf(stderr, "CLIENTS must be positive\n");
+		return EXIT_FAILURE;
+	}
+
+	/* the simulation runs in virtual time; commands are spread
+	   over two minutes, so some clients time out */
+	const unsigned duration_ms = 2 * CLIENT_TIMEOUT_MS + 1000;
+
+	std::mt19937 rng;
+	std::uniform_int_distribution<unsigned> client_distribution(0, n_clients - 1);
+	std::uniform_int_distribution<unsigned> time_distribution(0, 2 * CLIENT_TIMEOUT_MS - 1);
+
+	std::vector<Command> commands;
+	commands.reserve(n_commands);
+	for (unsigned i = 0; i < n_commands; ++i)
+		commands.push_back(Command{time_distribution(rng),
+					   client_distribution(rng)});
+	std::sort(commands.begin(), commands.end(),
+		  [](const Command &a, const Command &b){
+			  return a.time_ms < b.time_ms;
+		  });
+
+	EventLoop loop;
+	std::vector<FakeClient *> clients;
+	for (unsigned i = 0; i < n_clients; ++i)
+		clients.push_back(new FakeClient(loop, i));
+
+	std::vector<bool> active(n_clients, false);
+
+	unsigned fired_wheel, fired_set;
+
+	TimerWheel wheel(0);
+	const uint64_t wheel_us = Simulate(wheel, clients, commands,
+					   duration_ms, active, fired_wheel);
+
+	TimerSet set;
+	const uint64_t set_us = Simulate(set, clients, commands,
+					 duration_ms, active, fired_set);
+
+	printf("%u clients, %u commands, %u ms virtual time\n",
+	       n_clients, n_commands, duration_ms);
+	printf("timer wheel: %10.3f ms, %u timeouts\n",
+	       wheel_us / 1000., fired_wheel);
+	printf("multiset:    %10.3f ms, %u timeouts\n",
+	       set_us / 1000., fired_set);
+
+	for (auto c : clients)
+		delete c;
+
+	if (fired_wheel != fired_set) {
+		fprintf(stderr, "Mismatch!\n");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
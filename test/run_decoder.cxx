@@ -26,6 +26,7 @@
 #include "input/InputStream.hxx"
 #include "fs/Path.hxx"
 #include "AudioFormat.hxx"
+#include "system/Clock.hxx"
 #include "util/Error.hxx"
 #include "Log.hxx"
 #include "stdbin.h"
@@ -73,6 +74,8 @@ int main(int argc, char **argv)
 		return EXIT_FAILURE;
 	}
 
+	const uint64_t start_time = MonotonicClockUS();
+
 	if (plugin->file_decode != nullptr) {
 		plugin->FileDecode(decoder, Path::FromFS(uri));
 	} else if (plugin->stream_decode != nullptr) {
@@ -96,6 +99,17 @@ int main(int argc, char **argv)
 		return EXIT_FAILURE;
 	}
 
+	const uint64_t duration_us = MonotonicClockUS() - start_time;
+	const uint64_t total_bytes = decoder.data_bytes + decoder.commit_bytes;
+	fprintf(stderr,
+		"decoded %llu bytes in %.3f s (%.1f MB/s)\n"
+		"decoder_data: %llu bytes in %u calls\n"
+		"decoder_commit: %llu bytes in %u calls\n",
+		(unsigned long long)total_bytes, duration_us / 1e6,
+		duration_us > 0 ? total_bytes / (double)duration_us : 0.,
+		(unsigned long long)decoder.data_bytes, decoder.data_calls,
+		(unsigned long long)decoder.commit_bytes, decoder.commit_calls);
+
 	decoder_plugin_deinit_all();
 	input_stream_global_finish();
 	io_thread_deinit();
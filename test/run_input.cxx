@@ -25,6 +25,8 @@
 #include "input/InputStream.hxx"
 #include "input/Init.hxx"
 #include "IOThread.hxx"
+#include "fs/Path.hxx"
+#include "system/Clock.hxx"
 #include "util/Error.hxx"
 #include "thread/Cond.hxx"
 #include "Log.hxx"
@@ -41,6 +43,7 @@
 
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
 
 static void
 tag_save(FILE *file, const Tag &tag)
@@ -100,14 +103,93 @@ dump_input_stream(InputStream *is)
 	return 0;
 }
 
+/**
+ * Read the whole stream without writing it anywhere, and report the
+ * throughput of Read() and (if supported) Peek().
+ */
+static int
+benchmark_input_stream(InputStream *is)
+{
+	Error error;
+	char buffer[4096];
+
+	is->Lock();
+
+	uint64_t start_time = MonotonicClockUS();
+	offset_type read_bytes = 0;
+	while (!is->IsEOF()) {
+		size_t nbytes = is->Read(buffer, sizeof(buffer), error);
+		if (nbytes == 0)
+			break;
+
+		read_bytes += nbytes;
+	}
+
+	const uint64_t read_us = MonotonicClockUS() - start_time;
+
+	if (error.IsDefined() || !is->Check(error)) {
+		LogError(error);
+		is->Unlock();
+		return EXIT_FAILURE;
+	}
+
+	fprintf(stderr, "Read(): %llu bytes in %.3f s (%.1f MB/s)\n",
+		(unsigned long long)read_bytes, read_us / 1e6,
+		read_us > 0 ? read_bytes / (double)read_us : 0.);
+
+	if (!is->IsSeekable() || !is->Rewind(error)) {
+		is->Unlock();
+		return 0;
+	}
+
+	start_time = MonotonicClockUS();
+	offset_type peek_bytes = 0;
+	unsigned checksum = 0;
+	while (true) {
+		const auto src = is->Peek();
+		if (src.IsEmpty())
+			break;
+
+		/* touch every page, or nothing would be read */
+		const auto *p = (const unsigned char *)src.data;
+		for (size_t i = 0; i < src.size; i += 4096)
+			checksum += p[i];
+
+		is->Consume(src.size);
+		peek_bytes += src.size;
+	}
+
+	const uint64_t peek_us = MonotonicClockUS() - start_time;
+
+	if (peek_bytes > 0)
+		fprintf(stderr,
+			"Peek(): %llu bytes in %.3f s (%.1f MB/s, checksum %u)\n",
+			(unsigned long long)peek_bytes, peek_us / 1e6,
+			peek_us > 0 ? peek_bytes / (double)peek_us : 0.,
+			checksum);
+	else
+		fprintf(stderr, "Peek(): not supported\n");
+
+	is->Unlock();
+	return 0;
+}
+
 int main(int argc, char **argv)
 {
 	Error error;
 	InputStream *is;
 	int ret;
 
-	if (argc != 2) {
-		fprintf(stderr, "Usage: run_input URI\n");
+	bool benchmark = false;
+	if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+		benchmark = true;
+		--argc;
+		++argv;
+	}
+
+	if (argc != 2 && argc != 3) {
+		fprintf(stderr,
+			"Usage: run_input [--benchmark] URI [CONFIG]\n");
 		return EXIT_FAILURE;
 	}
 
@@ -123,6 +205,12 @@ int main(int argc, char **argv)
 
 	config_global_init();
 
+	if (argc == 3 &&
+	    !ReadConfigFile(Path::FromFS(argv[2]), error)) {
+		LogError(error);
+		return EXIT_FAILURE;
+	}
+
 	io_thread_init();
 	io_thread_start();
 
@@ -142,7 +230,9 @@ int main(int argc, char **argv)
 
 	is = InputStream::OpenReady(argv[1], mutex, cond, error);
 	if (is != NULL) {
-		ret = dump_input_stream(is);
+		ret = benchmark
+			? benchmark_input_stream(is)
+			: dump_input_stream(is);
 		delete is;
 	} else {
 		if (error.IsDefined())
@@ -0,0 +1,243 @@
+/*
+ * Unit tests for class DatabaseCounters.
+ */
+
+#include "config.h"
+#include "db/plugins/simple/Counters.hxx"
+#include "tag/Tag.hxx"
+#include "tag/TagBuilder.hxx"
+#include "tag/Set.hxx"
+#include "util/Error.hxx"
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+static Tag
+MakeTag(const char *artist, const char *album, unsigned duration_s)
+{
+	TagBuilder builder;
+	if (artist != nullptr)
+		builder.AddItem(TAG_ARTIST, artist);
+	if (album != nullptr)
+		builder.AddItem(TAG_ALBUM, album);
+	builder.AddItem(TAG_TITLE, "title");
+	builder.SetDuration(SongTime::FromS(duration_s));
+	return builder.Commit();
+}
+
+class DatabaseCountersTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(DatabaseCountersTest);
+	CPPUNIT_TEST(TestEmpty);
+	CPPUNIT_TEST(TestAddRemove);
+	CPPUNIT_TEST(TestMultiValue);
+	CPPUNIT_TEST(TestNoDuration);
+	CPPUNIT_TEST(TestValues);
+	CPPUNIT_TEST(TestCounts);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void TestEmpty() {
+		DatabaseCounters counters;
+		const auto stats = counters.Get();
+		CPPUNIT_ASSERT_EQUAL(0u, stats.song_count);
+		CPPUNIT_ASSERT_EQUAL(0u, stats.artist_count);
+		CPPUNIT_ASSERT_EQUAL(0u, stats.album_count);
+		CPPUNIT_ASSERT(stats.total_duration.count() == 0);
+	}
+
+	void TestAddRemove() {
+		const Tag a = MakeTag("Artist A", "Album 1", 100);
+		const Tag b = MakeTag("Artist A", "Album 2", 200);
+		const Tag c = MakeTag("Artist B", "Album 2", 300);
+
+		DatabaseCounters counters;
+		counters.Add(a);
+		counters.Add(b);
+		counters.Add(c);
+
+		auto stats = counters.Get();
+		CPPUNIT_ASSERT_EQUAL(3u, stats.song_count);
+		CPPUNIT_ASSERT_EQUAL(2u, stats.artist_count);
+		CPPUNIT_ASSERT_EQUAL(2u, stats.album_count);
+		CPPUNIT_ASSERT(stats.total_duration == SongTime::FromS(600u));
+
+		/* "Artist A" is still referenced by "b" */
+		counters.Remove(a);
+		stats = counters.Get();
+		CPPUNIT_ASSERT_EQUAL(2u, stats.song_count);
+		CPPUNIT_ASSERT_EQUAL(2u, stats.artist_count);
+		CPPUNIT_ASSERT_EQUAL(1u, stats.album_count);
+		CPPUNIT_ASSERT(stats.total_duration == SongTime::FromS(500u));
+
+		counters.Remove(b);
+		stats = counters.Get();
+		CPPUNIT_ASSERT_EQUAL(1u, stats.song_count);
+		CPPUNIT_ASSERT_EQUAL(1u, stats.artist_count);
+		CPPUNIT_ASSERT_EQUAL(1u, stats.album_count);
+
+		/* a modified tag, as in Directory::SongTagChanged() */
+		const Tag c2 = MakeTag("Artist C", "Album 3", 50);
+		counters.Remove(c);
+		counters.Add(c2);
+		stats = counters.Get();
+		CPPUNIT_ASSERT_EQUAL(1u, stats.song_count);
+		CPPUNIT_ASSERT_EQUAL(1u, stats.artist_count);
+		CPPUNIT_ASSERT(stats.total_duration == SongTime::FromS(50u));
+
+		counters.Clear();
+		stats = counters.Get();
+		CPPUNIT_ASSERT_EQUAL(0u, stats.song_count);
+		CPPUNIT_ASSERT_EQUAL(0u, stats.artist_count);
+	}
+
+	void TestMultiValue() {
+		TagBuilder builder;
+		builder.AddItem(TAG_ARTIST, "X");
+		builder.AddItem(TAG_ARTIST, "Y");
+		builder.AddItem(TAG_ARTIST, "X");
+		const Tag tag = builder.Commit();
+
+		DatabaseCounters counters;
+		counters.Add(tag);
+		CPPUNIT_ASSERT_EQUAL(2u, counters.Get().artist_count);
+
+		counters.Remove(tag);
+		CPPUNIT_ASSERT_EQUAL(0u, counters.Get().artist_count);
+	}
+
+	void TestNoDuration() {
+		const Tag tag = MakeTag(nullptr, nullptr, 0);
+		Tag unknown(tag);
+		unknown.duration = SignedSongTime::Negative();
+
+		DatabaseCounters counters;
+		counters.Add(unknown);
+		counters.Add(MakeTag("A", nullptr, 10));
+
+		const auto stats = counters.Get();
+		CPPUNIT_ASSERT_EQUAL(2u, stats.song_count);
+		CPPUNIT_ASSERT_EQUAL(0u, stats.album_count);
+		CPPUNIT_ASSERT(stats.total_duration == SongTime::FromS(10u));
+	}
+
+	void TestValues() {
+		std::vector<Tag> tags;
+		tags.emplace_back(MakeTag("B", "Album 1", 10));
+		tags.emplace_back(MakeTag("A", nullptr, 10));
+		tags.emplace_back(MakeTag(nullptr, "Album 2", 10));
+
+		TagBuilder builder;
+		builder.AddItem(TAG_ARTIST, "C");
+		builder.AddItem(TAG_ALBUM_ARTIST, "D");
+		tags.emplace_back(builder.Commit());
+
+		DatabaseCounters counters;
+		CPPUNIT_ASSERT(!counters.IsEnabled(TAG_ALBUM_ARTIST));
+		counters.Enable(TAG_ALBUM_ARTIST);
+
+		for (const auto &tag : tags)
+			counters.Add(tag);
+
+		/* must produce the same as VisitUniqueTags() */
+		for (auto type : {TAG_ARTIST, TAG_ALBUM, TAG_ALBUM_ARTIST}) {
+			TagSet expected;
+			for (const auto &tag : tags)
+				expected.InsertUnique(tag, type, 0);
+
+			std::vector<std::string> actual;
+			Error error;
+			CPPUNIT_ASSERT(counters.VisitValues(type, [&actual, type](const Tag &tag, Error &){
+						actual.push_back(tag.GetValue(type));
+						return true;
+					}, error));
+
+			CPPUNIT_ASSERT_EQUAL(expected.size(), actual.size());
+
+			unsigned i = 0;
+			for (const auto &tag : expected)
+				CPPUNIT_ASSERT_EQUAL(std::string(tag.GetValue(type)),
+						     actual[i++]);
+		}
+
+		/* the empty "Album" value disappears with the last
+		   song which has no album */
+		counters.Remove(tags[1]);
+		counters.Remove(tags[3]);
+
+		std::vector<std::string> albums;
+		Error error;
+		CPPUNIT_ASSERT(counters.VisitValues(TAG_ALBUM, [&albums](const Tag &tag, Error &){
+					albums.push_back(tag.GetValue(TAG_ALBUM));
+					return true;
+				}, error));
+		CPPUNIT_ASSERT_EQUAL(size_t(2), albums.size());
+		CPPUNIT_ASSERT_EQUAL(std::string("Album 1"), albums[0]);
+		CPPUNIT_ASSERT_EQUAL(std::string("Album 2"), albums[1]);
+	}
+
+	void TestCounts() {
+		const Tag a = MakeTag("B", "X", 10);
+		const Tag b = MakeTag("B", "Y", 20);
+		const Tag c = MakeTag("A", nullptr, 40);
+
+		DatabaseCounters counters;
+		counters.Enable(TAG_ALBUM_ARTIST);
+		counters.Add(a);
+		counters.Add(b);
+		counters.Add(c);
+
+		std::vector<std::string> values;
+		std::vector<SearchStats> stats;
+		const auto f = [&values, &stats](const char *value,
+						 const SearchStats &s,
+						 Error &){
+			values.push_back(value);
+			stats.push_back(s);
+			return true;
+		};
+
+		Error error;
+		CPPUNIT_ASSERT(counters.VisitCounts(TAG_ALBUM_ARTIST, f, error));
+
+		/* "count group" falls back to "Artist", and it
+		   ignores songs without a value */
+		CPPUNIT_ASSERT_EQUAL(size_t(2), values.size());
+		CPPUNIT_ASSERT_EQUAL(std::string("A"), values[0]);
+		CPPUNIT_ASSERT_EQUAL(1u, stats[0].n_songs);
+		CPPUNIT_ASSERT(stats[0].total_duration == SongTime::FromS(40u));
+		CPPUNIT_ASSERT_EQUAL(std::string("B"), values[1]);
+		CPPUNIT_ASSERT_EQUAL(2u, stats[1].n_songs);
+		CPPUNIT_ASSERT(stats[1].total_duration == SongTime::FromS(30u));
+
+		values.clear();
+		stats.clear();
+		CPPUNIT_ASSERT(counters.VisitCounts(TAG_ALBUM, f, error));
+		CPPUNIT_ASSERT_EQUAL(size_t(2), values.size());
+
+		counters.Remove(b);
+		values.clear();
+		stats.clear();
+		CPPUNIT_ASSERT(counters.VisitCounts(TAG_ARTIST, f, error));
+		CPPUNIT_ASSERT_EQUAL(size_t(2), values.size());
+		CPPUNIT_ASSERT_EQUAL(1u, stats[1].n_songs);
+		CPPUNIT_ASSERT(stats[1].total_duration == SongTime::FromS(10u));
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DatabaseCountersTest);
+
+int
+main(gcc_unused int argc, gcc_unused char **argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	auto &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return runner.run() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
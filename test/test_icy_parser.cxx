@@ -30,7 +30,7 @@ CompareTagTitle(const Tag &tag, const std::string &title)
 {
 	CPPUNIT_ASSERT_EQUAL(uint16_t(1), tag.num_items);
 
-	const TagItem &item = *tag.items[0];
+	const TagItem &item = *tag.begin();
 	CPPUNIT_ASSERT_EQUAL(TAG_TITLE, item.type);
 	CPPUNIT_ASSERT_EQUAL(title, std::string(item.value));
 }
@@ -0,0 +1,287 @@
+/*
+ * Unit tests for class NfsReadWindow.
+ */
+
+#include "config.h"
+#include "lib/nfs/ReadWindow.hxx"
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint8_t
+FileByte(uint64_t offset)
+{
+	return uint8_t(offset * 7 + offset / 251);
+}
+
+/**
+ * A fake NFS server which answers each read request after a
+ * latency which varies from request to request, so responses
+ * arrive out of order.  Time is simulated in microseconds.
+ */
+class FakeNfsServer {
+	struct Response {
+		uint64_t time;
+		NfsReadWindow::Request request;
+
+		bool operator<(const Response &other) const {
+			return time < other.time;
+		}
+	};
+
+	const uint64_t file_size;
+	const uint64_t latency;
+
+	/**
+	 * If non-zero, every third response is truncated to this
+	 * size.
+	 */
+	const size_t short_size;
+
+	std::vector<Response> pending;
+	std::vector<uint8_t> buffer;
+
+public:
+	uint64_t now;
+	unsigned n_requests;
+
+	FakeNfsServer(uint64_t _file_size, uint64_t _latency,
+		      size_t _short_size=0)
+		:file_size(_file_size), latency(_latency),
+		 short_size(_short_size), now(0), n_requests(0) {}
+
+	void Submit(const NfsReadWindow::Request &request) {
+		CPPUNIT_ASSERT(request.size > 0);
+		CPPUNIT_ASSERT(request.offset + request.size <= file_size);
+
+		/* up to 50% jitter */
+		const uint64_t jitter = (n_requests * 37 % 11) * latency / 20;
+		++n_requests;
+
+		Response r;
+		r.time = now + latency + jitter;
+		r.request = request;
+		pending.push_back(r);
+	}
+
+	bool IsEmpty() const {
+		return pending.empty();
+	}
+
+	/**
+	 * Wait for the next response.
+	 */
+	const void *Receive(unsigned &slot, size_t &length) {
+		auto i = std::min_element(pending.begin(), pending.end());
+		const Response r = *i;
+		pending.erase(i);
+
+		now = std::max(now, r.time);
+		slot = r.request.slot;
+		length = r.request.size;
+		if (short_size > 0 && n_requests % 3 == 0 &&
+		    length > short_size)
+			length = short_size;
+
+		buffer.resize(length);
+		for (size_t j = 0; j < length; ++j)
+			buffer[j] = FileByte(r.request.offset + j);
+
+		/* scribble over the previous response, just like
+		   libnfs reuses its buffers */
+		return buffer.data();
+	}
+};
+
+/**
+ * A consumer like #NfsInputStream: it submits requests as long as
+ * the window allows it and verifies the data it receives.
+ */
+class Consumer {
+	NfsReadWindow &window;
+	FakeNfsServer &server;
+	const size_t space;
+
+public:
+	uint64_t offset;
+	size_t max_reserved;
+
+	Consumer(NfsReadWindow &_window, FakeNfsServer &_server,
+		 size_t _space, uint64_t _offset=0)
+		:window(_window), server(_server), space(_space),
+		 offset(_offset), max_reserved(0) {}
+
+	void Fill() {
+		NfsReadWindow::Request request;
+		while (window.Next(space, request))
+			server.Submit(request);
+
+		max_reserved = std::max(max_reserved, window.GetReserved());
+		CPPUNIT_ASSERT(window.GetReserved() <= space);
+	}
+
+	void Deliver(const void *data, size_t length) {
+		const uint8_t *p = (const uint8_t *)data;
+		for (size_t i = 0; i < length; ++i)
+			CPPUNIT_ASSERT_EQUAL(FileByte(offset + i), p[i]);
+
+		offset += length;
+	}
+
+	/**
+	 * Handle one response, the same way #NfsFileReader does.
+	 */
+	void Receive() {
+		unsigned slot;
+		size_t length;
+		const void *data = server.Receive(slot, length);
+
+		if (!window.IsHead(slot)) {
+			window.Store(slot, data, length);
+			return;
+		}
+
+		window.Consume(length);
+		Deliver(data, length);
+
+		while (window.GetReady(data, length)) {
+			window.Consume(length);
+			Deliver(data, length);
+		}
+
+		CPPUNIT_ASSERT_EQUAL(offset, window.GetOffset());
+	}
+
+	void Run() {
+		Fill();
+		while (!server.IsEmpty()) {
+			Receive();
+			Fill();
+		}
+	}
+};
+
+/**
+ * Read a file and return the simulated duration.
+ */
+static uint64_t
+ReadFile(unsigned max_requests, size_t max_size, uint64_t file_size,
+	 size_t space, size_t short_size=0)
+{
+	NfsReadWindow window(max_requests, max_size);
+	window.Reset(0, file_size);
+
+	FakeNfsServer server(file_size, 5000, short_size);
+	Consumer consumer(window, server, space);
+	consumer.Run();
+
+	CPPUNIT_ASSERT_EQUAL(file_size, consumer.offset);
+	CPPUNIT_ASSERT(window.IsEOF());
+	CPPUNIT_ASSERT_EQUAL(size_t(0), window.GetReserved());
+
+	return server.now;
+}
+
+class NfsReadWindowTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(NfsReadWindowTest);
+	CPPUNIT_TEST(TestInOrder);
+	CPPUNIT_TEST(TestShortRead);
+	CPPUNIT_TEST(TestSpace);
+	CPPUNIT_TEST(TestRewind);
+	CPPUNIT_TEST(TestLatency);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void TestInOrder() {
+		ReadFile(1, 32768, 1000000, 512 * 1024);
+		ReadFile(4, 32768, 1000000, 512 * 1024);
+		ReadFile(7, 1000, 123457, 512 * 1024);
+
+		/* empty file */
+		ReadFile(4, 32768, 0, 512 * 1024);
+	}
+
+	void TestShortRead() {
+		ReadFile(1, 32768, 1000000, 512 * 1024, 10000);
+		ReadFile(4, 32768, 1000000, 512 * 1024, 10000);
+	}
+
+	void TestSpace() {
+		NfsReadWindow window(8, 32768);
+		window.Reset(0, 1000000);
+
+		FakeNfsServer server(1000000, 5000);
+		Consumer consumer(window, server, 70000);
+		consumer.Run();
+
+		CPPUNIT_ASSERT_EQUAL(uint64_t(1000000), consumer.offset);
+		CPPUNIT_ASSERT_EQUAL(size_t(70000), consumer.max_reserved);
+
+		/* no space at all: nothing is requested */
+		window.Reset(0, 1000000);
+		NfsReadWindow::Request request;
+		CPPUNIT_ASSERT(!window.Next(0, request));
+		CPPUNIT_ASSERT(window.IsEmpty());
+	}
+
+	void TestRewind() {
+		NfsReadWindow window(4, 32768);
+		window.Reset(0, 1000000);
+
+		/* submit some requests, then "seek" before any
+		   response arrives */
+		NfsReadWindow::Request request;
+		unsigned n = 0;
+		while (window.Next(512 * 1024, request))
+			++n;
+		CPPUNIT_ASSERT_EQUAL(4u, n);
+		CPPUNIT_ASSERT_EQUAL(size_t(4 * 32768), window.GetReserved());
+
+		window.Reset(500000, 1000000);
+		CPPUNIT_ASSERT(window.IsEmpty());
+		CPPUNIT_ASSERT_EQUAL(uint64_t(500000), window.GetOffset());
+
+		FakeNfsServer server(1000000, 5000);
+		Consumer consumer(window, server, 512 * 1024, 500000);
+		consumer.Run();
+		CPPUNIT_ASSERT_EQUAL(uint64_t(1000000), consumer.offset);
+	}
+
+	void TestLatency() {
+		const uint64_t file_size = 16 * 1024 * 1024;
+
+		const uint64_t serial = ReadFile(1, 32768, file_size,
+						 512 * 1024);
+		const uint64_t pipelined = ReadFile(4, 32768, file_size,
+						    512 * 1024);
+
+		/* with 4 requests in flight, the round trips overlap */
+		CPPUNIT_ASSERT(pipelined * 3 < serial);
+
+		if (getenv("VERBOSE") != nullptr)
+			printf("\n%llu bytes: %llu ms with 1 request, "
+			       "%llu ms with 4 requests\n",
+			       (unsigned long long)file_size,
+			       (unsigned long long)serial / 1000,
+			       (unsigned long long)pipelined / 1000);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(NfsReadWindowTest);
+
+int
+main(gcc_unused int argc, gcc_unused char **argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	auto &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return runner.run() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -8,6 +8,9 @@
 #include <cppunit/ui/text/TestRunner.h>
 #include <cppunit/extensions/HelperMacros.h>
 
+#include <stdio.h>
+#include <string.h>
+
 Tag::Tag(const Tag &) {}
 void Tag::Clear() {}
 
@@ -193,7 +196,252 @@ QueuePriorityTest::TestPriority()
 	CPPUNIT_ASSERT_EQUAL(6u, a_order);
 }
 
+class QueueRangeTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(QueueRangeTest);
+	CPPUNIT_TEST(TestDeleteRange);
+	CPPUNIT_TEST(TestMoveRange);
+	CPPUNIT_TEST(TestGrow);
+	CPPUNIT_TEST(TestIdChurn);
+	CPPUNIT_TEST_SUITE_END();
+
+	static void Fill(Queue &queue, unsigned n) {
+		for (unsigned i = 0; i < n; ++i) {
+			char uri[16];
+			snprintf(uri, sizeof(uri), "%u.ogg", i);
+			queue.Append(DetachedSong(uri), 0);
+		}
+	}
+
+	/**
+	 * Verify that the "order" array is a permutation of all
+	 * positions and that the id table is consistent.
+	 */
+	static void CheckConsistency(const Queue &queue) {
+		bool seen[64] = {};
+		for (unsigned i = 0; i < queue.GetLength(); ++i) {
+			const unsigned position = queue.OrderToPosition(i);
+			CPPUNIT_ASSERT(position < queue.GetLength());
+			CPPUNIT_ASSERT(!seen[position]);
+			seen[position] = true;
+
+			const unsigned id = queue.PositionToId(i);
+			CPPUNIT_ASSERT_EQUAL(int(i), queue.IdToPosition(id));
+		}
+	}
+
+public:
+	void TestDeleteRange() {
+		Queue queue(64);
+		Fill(queue, 16);
+
+		const unsigned id3 = queue.PositionToId(3);
+		const unsigned id10 = queue.PositionToId(10);
+
+		queue.random = true;
+		queue.ShuffleOrder();
+
+		const unsigned order10 = queue.PositionToOrder(10);
+
+		queue.DeleteRange(4, 10);
+		CPPUNIT_ASSERT_EQUAL(10u, queue.GetLength());
+		CheckConsistency(queue);
+
+		CPPUNIT_ASSERT_EQUAL(3, queue.IdToPosition(id3));
+		CPPUNIT_ASSERT_EQUAL(4, queue.IdToPosition(id10));
+		CPPUNIT_ASSERT(strcmp(queue.Get(4).GetURI(), "10.ogg") == 0);
+
+		/* the relative order of the survivors is preserved */
+		CPPUNIT_ASSERT(queue.PositionToOrder(4) <= order10);
+
+		queue.DeletePosition(0);
+		CPPUNIT_ASSERT_EQUAL(9u, queue.GetLength());
+		CheckConsistency(queue);
+		CPPUNIT_ASSERT(strcmp(queue.Get(0).GetURI(), "1.ogg") == 0);
+
+		queue.DeleteRange(0, queue.GetLength());
+		CPPUNIT_ASSERT(queue.IsEmpty());
+	}
+
+	void TestMoveRange() {
+		Queue queue(64);
+		Fill(queue, 16);
+
+		queue.random = true;
+		queue.ShuffleOrder();
+
+		/* move [2,5) forward to 8 */
+		queue.MoveRange(2, 5, 8);
+		CheckConsistency(queue);
+		CPPUNIT_ASSERT(strcmp(queue.Get(2).GetURI(), "5.ogg") == 0);
+		CPPUNIT_ASSERT(strcmp(queue.Get(8).GetURI(), "2.ogg") == 0);
+		CPPUNIT_ASSERT(strcmp(queue.Get(10).GetURI(), "4.ogg") == 0);
+		CPPUNIT_ASSERT(strcmp(queue.Get(11).GetURI(), "11.ogg") == 0);
+
+		/* and back */
+		queue.MoveRange(8, 11, 2);
+		CheckConsistency(queue);
+		for (unsigned i = 0; i < queue.GetLength(); ++i) {
+			char uri[16];
+			snprintf(uri, sizeof(uri), "%u.ogg", i);
+			CPPUNIT_ASSERT(strcmp(queue.Get(i).GetURI(), uri) == 0);
+		}
+
+		queue.MovePostion(0, 15);
+		CheckConsistency(queue);
+		CPPUNIT_ASSERT(strcmp(queue.Get(15).GetURI(), "0.ogg") == 0);
+		CPPUNIT_ASSERT(strcmp(queue.Get(0).GetURI(), "1.ogg") == 0);
+	}
+
+	void TestGrow() {
+		Queue queue(100000);
+		CPPUNIT_ASSERT_EQUAL(0u, queue.capacity);
+
+		/* the arrays grow with the queue */
+		for (unsigned i = 0; i < 1000; ++i)
+			queue.Append(DetachedSong("foo.ogg"), 0);
+		CPPUNIT_ASSERT(queue.capacity >= 1000);
+		CPPUNIT_ASSERT(queue.capacity < 4000);
+
+		/* all ids are distinct and map back */
+		for (unsigned i = 0; i < queue.GetLength(); ++i)
+			CPPUNIT_ASSERT_EQUAL(int(i),
+					     queue.IdToPosition(queue.PositionToId(i)));
+
+		/* deleted ids are not reused immediately */
+		const unsigned old_id = queue.PositionToId(0);
+		queue.DeletePosition(0);
+		CPPUNIT_ASSERT_EQUAL(-1, queue.IdToPosition(old_id));
+		const unsigned new_id =
+			queue.Append(DetachedSong("foo.ogg"), 0);
+		CPPUNIT_ASSERT(new_id != old_id);
+
+		/* memory is released when the queue shrinks */
+		queue.DeleteRange(10, queue.GetLength());
+		CPPUNIT_ASSERT(queue.capacity < 100);
+
+		queue.Clear();
+		CPPUNIT_ASSERT_EQUAL(0u, queue.capacity);
+		CPPUNIT_ASSERT(queue.items == nullptr);
+	}
+
+	void TestIdChurn() {
+		Queue queue(1 << 20);
+
+		for (unsigned i = 0; i < 3; ++i)
+			queue.Append(DetachedSong("foo.ogg"), 0);
+
+		/* more ids than the initial table size, but only 3 in
+		   use at a time: ids keep ascending, and the id table
+		   stays small */
+		unsigned last_id = queue.PositionToId(2);
+		for (unsigned i = 0; i < 70000; ++i) {
+			queue.DeletePosition(0);
+
+			const unsigned id =
+				queue.Append(DetachedSong("foo.ogg"), 0);
+			CPPUNIT_ASSERT_EQUAL(last_id + 1, id);
+			last_id = id;
+
+			CPPUNIT_ASSERT_EQUAL(2, queue.IdToPosition(id));
+		}
+
+		CPPUNIT_ASSERT(queue.id_table.GetCapacity() <= 64);
+
+		for (unsigned i = 0; i < 3; ++i)
+			CPPUNIT_ASSERT_EQUAL(int(i),
+					     queue.IdToPosition(queue.PositionToId(i)));
+	}
+};
+
+class QueueChangesTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(QueueChangesTest);
+	CPPUNIT_TEST(TestChanges);
+	CPPUNIT_TEST(TestOverflow);
+	CPPUNIT_TEST_SUITE_END();
+
+	/**
+	 * Compare the change log with a full scan for all versions.
+	 */
+	static void CheckChanges(const Queue &queue) {
+		for (uint32_t v = 1; v <= queue.version + 1; ++v) {
+			std::vector<unsigned> expected;
+			for (unsigned i = 0; i < queue.GetLength(); ++i)
+				if (queue.IsNewerAtPosition(i, v))
+					expected.push_back(i);
+
+			std::vector<unsigned> actual;
+			queue.VisitChanges(v, [&actual](unsigned i){
+					actual.push_back(i);
+				});
+
+			CPPUNIT_ASSERT(expected == actual);
+		}
+	}
+
+public:
+	void TestChanges() {
+		Queue queue(64);
+
+		for (unsigned i = 0; i < 16; ++i) {
+			queue.Append(DetachedSong("foo.ogg"), 0);
+			queue.IncrementVersion();
+		}
+
+		CheckChanges(queue);
+
+		/* the change log is used for recent versions */
+		std::vector<unsigned> positions;
+		CPPUNIT_ASSERT(queue.CollectChanges(queue.version - 2,
+						    positions));
+		CPPUNIT_ASSERT_EQUAL(size_t(2), positions.size());
+
+		queue.ModifyAtPosition(3);
+		queue.IncrementVersion();
+		CheckChanges(queue);
+
+		queue.DeleteRange(5, 8);
+		queue.IncrementVersion();
+		CheckChanges(queue);
+
+		queue.MoveRange(0, 2, 10);
+		queue.IncrementVersion();
+		CheckChanges(queue);
+
+		queue.SwapPositions(1, 12);
+		queue.IncrementVersion();
+		CheckChanges(queue);
+
+		queue.DeleteRange(10, queue.GetLength());
+		queue.IncrementVersion();
+		CheckChanges(queue);
+	}
+
+	void TestOverflow() {
+		Queue queue(Queue::CHANGE_LOG_SIZE * 2);
+
+		for (unsigned i = 0; i < Queue::CHANGE_LOG_SIZE + 10; ++i)
+			queue.Append(DetachedSong("foo.ogg"), 0);
+		queue.IncrementVersion();
+
+		/* the first version has been overwritten in the
+		   ring, but recent versions are still there */
+		std::vector<unsigned> positions;
+		CPPUNIT_ASSERT(!queue.CollectChanges(1, positions));
+
+		queue.ModifyAtPosition(7);
+		queue.IncrementVersion();
+		CPPUNIT_ASSERT(queue.CollectChanges(queue.version - 1,
+						    positions));
+		CPPUNIT_ASSERT_EQUAL(size_t(1), positions.size());
+		CPPUNIT_ASSERT_EQUAL(7u, positions.front());
+
+		CheckChanges(queue);
+	}
+};
+
 CPPUNIT_TEST_SUITE_REGISTRATION(QueuePriorityTest);
+CPPUNIT_TEST_SUITE_REGISTRATION(QueueRangeTest);
+CPPUNIT_TEST_SUITE_REGISTRATION(QueueChangesTest);
 
 int
 main(gcc_unused int argc, gcc_unused char **argv)
@@ -0,0 +1,120 @@
+/*
+ * Unit tests for class TimerWheel.
+ */
+
+#include "config.h"
+#include "event/TimerWheel.hxx"
+#include "event/Loop.hxx"
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <random>
+#include <vector>
+
+#include <stdlib.h>
+
+class FakeTimer final : public TimeoutMonitor {
+public:
+	unsigned due, fired_at;
+
+	FakeTimer(EventLoop &_loop)
+		:TimeoutMonitor(_loop), due(0), fired_at(0) {}
+
+protected:
+	void OnTimeout() override {}
+};
+
+/**
+ * Simulate an event loop which sleeps for GetTimeout() milliseconds
+ * and then calls PopDue(), until all timers have fired or the
+ * specified time is reached.
+ */
+static unsigned
+RunUntil(TimerWheel &wheel, unsigned now, unsigned end)
+{
+	while (true) {
+		TimeoutMonitor *t;
+		while ((t = wheel.PopDue(now)) != nullptr)
+			static_cast<FakeTimer *>(t)->fired_at = now;
+
+		if (now == end)
+			return end;
+
+		const int timeout = wheel.GetTimeout();
+		now = timeout < 0 || now + timeout > end
+			? end
+			: now + timeout;
+	}
+}
+
+class TimerWheelTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(TimerWheelTest);
+	CPPUNIT_TEST(TestCascadeBoundary);
+	CPPUNIT_TEST(TestRandom);
+	CPPUNIT_TEST_SUITE_END();
+
+	EventLoop loop;
+
+public:
+	void TestCascadeBoundary() {
+		TimerWheel wheel(0);
+		FakeTimer a(loop), b(loop);
+
+		/* "a" lands on level 1; then the clock moves, and "b"
+		   is inserted on level 0 behind "a" */
+		wheel.Insert(a, 360);
+		CPPUNIT_ASSERT(wheel.PopDue(200) == nullptr);
+		wheel.Insert(b, 450);
+
+		CPPUNIT_ASSERT_EQUAL(56, wheel.GetTimeout());
+
+		RunUntil(wheel, 200, 1000);
+		CPPUNIT_ASSERT(wheel.IsEmpty());
+		CPPUNIT_ASSERT_EQUAL(360u, a.fired_at);
+		CPPUNIT_ASSERT_EQUAL(450u, b.fired_at);
+	}
+
+	void TestRandom() {
+		std::mt19937 rng;
+		std::uniform_int_distribution<unsigned> delay(0, 100000);
+
+		std::vector<FakeTimer *> timers;
+		TimerWheel wheel(0);
+
+		/* insert timers in batches while the clock is moving,
+		   so they are distributed over all levels */
+		unsigned now = 0;
+		for (unsigned batch = 0; batch < 20; ++batch) {
+			for (unsigned i = 0; i < 50; ++i) {
+				FakeTimer *t = new FakeTimer(loop);
+				t->due = now + delay(rng);
+				wheel.Insert(*t, t->due);
+				timers.push_back(t);
+			}
+
+			now = RunUntil(wheel, now, now + delay(rng) / 10);
+		}
+
+		RunUntil(wheel, now, now + 200000);
+		CPPUNIT_ASSERT(wheel.IsEmpty());
+
+		for (auto *t : timers) {
+			CPPUNIT_ASSERT_EQUAL(t->due, t->fired_at);
+			delete t;
+		}
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TimerWheelTest);
+
+int
+main(gcc_unused int argc, gcc_unused char **argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	auto &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return runner.run() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
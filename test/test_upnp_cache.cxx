@@ -0,0 +1,263 @@
+/*
+ * Unit tests for class UpnpCache.
+ */
+
+#include "config.h"
+#include "db/plugins/upnp/Cache.hxx"
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static const std::string server_a("upnp://a/ContentDirectory");
+static const std::string server_b("upnp://b/ContentDirectory");
+
+static UpnpObjectList
+MakeObjects(unsigned n, const char *prefix="x")
+{
+	auto objects = std::make_shared<std::vector<UPnPDirObject>>(n);
+	for (unsigned i = 0; i < n; ++i) {
+		auto &o = (*objects)[i];
+		o.clear();
+		o.m_id = prefix + std::to_string(i);
+		o.name = o.m_id;
+		o.type = UPnPDirObject::Type::CONTAINER;
+	}
+
+	return objects;
+}
+
+/**
+ * A fake ContentDirectory server: a balanced tree of containers,
+ * which counts the "Browse" requests it receives.
+ */
+class FakeContentDirectory {
+	const unsigned fanout, depth;
+
+public:
+	unsigned browse_count;
+
+	FakeContentDirectory(unsigned _fanout, unsigned _depth)
+		:fanout(_fanout), depth(_depth), browse_count(0) {}
+
+	UpnpObjectList Browse(const std::string &id) {
+		++browse_count;
+
+		const unsigned level = std::count(id.begin(), id.end(), '$');
+		if (level >= depth)
+			return MakeObjects(0);
+
+		auto objects = std::make_shared<std::vector<UPnPDirObject>>(fanout);
+		for (unsigned i = 0; i < fanout; ++i) {
+			auto &o = (*objects)[i];
+			o.clear();
+			o.m_id = id + "$" + std::to_string(i);
+			o.m_pid = id;
+			o.name = "dir" + std::to_string(i);
+			o.type = UPnPDirObject::Type::CONTAINER;
+		}
+
+		return objects;
+	}
+};
+
+/**
+ * Resolve a path like UpnpDatabase::Namei() does: browse each
+ * container from the root, using the cache.
+ */
+static std::string
+Namei(UpnpCache &cache, FakeContentDirectory &server,
+      const std::vector<std::string> &path, unsigned now)
+{
+	std::string id("0");
+
+	for (const auto &name : path) {
+		auto objects = cache.Get(server_a, UpnpCache::Kind::CHILDREN,
+					 id.c_str(), now);
+		if (objects == nullptr) {
+			objects = server.Browse(id);
+			cache.Put(server_a, UpnpCache::Kind::CHILDREN,
+				  id.c_str(), objects, now);
+		}
+
+		const UPnPDirObject *child = nullptr;
+		for (const auto &o : *objects)
+			if (o.name == name)
+				child = &o;
+
+		if (child == nullptr)
+			return std::string();
+
+		id = child->m_id;
+	}
+
+	return id;
+}
+
+class UpnpCacheTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(UpnpCacheTest);
+	CPPUNIT_TEST(TestGetPut);
+	CPPUNIT_TEST(TestExpire);
+	CPPUNIT_TEST(TestEvict);
+	CPPUNIT_TEST(TestUpdateId);
+	CPPUNIT_TEST(TestRoundTrips);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void TestGetPut() {
+		UpnpCache cache(1000, 100, 100);
+
+		CPPUNIT_ASSERT(cache.Get(server_a, UpnpCache::Kind::CHILDREN,
+					 "0", 0) == nullptr);
+
+		cache.Put(server_a, UpnpCache::Kind::CHILDREN, "0",
+			  MakeObjects(3), 0);
+
+		auto objects = cache.Get(server_a, UpnpCache::Kind::CHILDREN,
+					 "0", 10);
+		CPPUNIT_ASSERT(objects != nullptr);
+		CPPUNIT_ASSERT_EQUAL(size_t(3), objects->size());
+
+		/* different kind, different server */
+		CPPUNIT_ASSERT(cache.Get(server_a, UpnpCache::Kind::METADATA,
+					 "0", 10) == nullptr);
+		CPPUNIT_ASSERT(cache.Get(server_b, UpnpCache::Kind::CHILDREN,
+					 "0", 10) == nullptr);
+
+		CPPUNIT_ASSERT_EQUAL(1u, cache.GetHits());
+		CPPUNIT_ASSERT_EQUAL(3u, cache.GetMisses());
+	}
+
+	void TestExpire() {
+		UpnpCache cache(1000, 100, 100);
+
+		cache.Put(server_a, UpnpCache::Kind::CHILDREN, "0",
+			  MakeObjects(1), 5000);
+		CPPUNIT_ASSERT(cache.Get(server_a, UpnpCache::Kind::CHILDREN,
+					 "0", 5999) != nullptr);
+		CPPUNIT_ASSERT(cache.Get(server_a, UpnpCache::Kind::CHILDREN,
+					 "0", 6000) == nullptr);
+
+		/* a disabled cache stores nothing */
+		UpnpCache disabled(0, 100, 100);
+		disabled.Put(server_a, UpnpCache::Kind::CHILDREN, "0",
+			     MakeObjects(1), 0);
+		CPPUNIT_ASSERT(disabled.Get(server_a,
+					    UpnpCache::Kind::CHILDREN,
+					    "0", 0) == nullptr);
+	}
+
+	void TestEvict() {
+		UpnpCache cache(1000, 100, 10);
+
+		cache.Put(server_a, UpnpCache::Kind::CHILDREN, "1",
+			  MakeObjects(4), 0);
+		cache.Put(server_a, UpnpCache::Kind::CHILDREN, "2",
+			  MakeObjects(4), 0);
+
+		/* use "1", so "2" is the least recently used one */
+		CPPUNIT_ASSERT(cache.Get(server_a, UpnpCache::Kind::CHILDREN,
+					 "1", 0) != nullptr);
+
+		cache.Put(server_a, UpnpCache::Kind::CHILDREN, "3",
+			  MakeObjects(4), 0);
+
+		CPPUNIT_ASSERT(cache.Get(server_a, UpnpCache::Kind::CHILDREN,
+					 "1", 0) != nullptr);
+		CPPUNIT_ASSERT(cache.Get(server_a, UpnpCache::Kind::CHILDREN,
+					 "2", 0) == nullptr);
+		CPPUNIT_ASSERT(cache.Get(server_a, UpnpCache::Kind::CHILDREN,
+					 "3", 0) != nullptr);
+
+		/* too large to be cached at all */
+		cache.Put(server_a, UpnpCache::Kind::CHILDREN, "4",
+			  MakeObjects(11), 0);
+		CPPUNIT_ASSERT(cache.Get(server_a, UpnpCache::Kind::CHILDREN,
+					 "4", 0) == nullptr);
+		CPPUNIT_ASSERT(cache.Get(server_a, UpnpCache::Kind::CHILDREN,
+					 "1", 0) != nullptr);
+	}
+
+	void TestUpdateId() {
+		UpnpCache cache(100000, 100, 100);
+
+		CPPUNIT_ASSERT(cache.IsUpdateCheckDue(server_a, 0));
+		cache.SetUpdateId(server_a, 7, 0);
+		CPPUNIT_ASSERT(!cache.IsUpdateCheckDue(server_a, 99));
+		CPPUNIT_ASSERT(cache.IsUpdateCheckDue(server_a, 100));
+		CPPUNIT_ASSERT(cache.IsUpdateCheckDue(server_b, 0));
+
+		cache.Put(server_a, UpnpCache::Kind::CHILDREN, "0",
+			  MakeObjects(1), 0);
+		cache.Put(server_a, UpnpCache::Kind::METADATA, "0",
+			  MakeObjects(1), 0);
+		cache.Put(server_b, UpnpCache::Kind::CHILDREN, "0",
+			  MakeObjects(1), 0);
+
+		/* unchanged: entries survive */
+		cache.SetUpdateId(server_a, 7, 100);
+		CPPUNIT_ASSERT(!cache.IsUpdateCheckDue(server_a, 150));
+		CPPUNIT_ASSERT(cache.Get(server_a, UpnpCache::Kind::CHILDREN,
+					 "0", 100) != nullptr);
+
+		/* changed: all entries of this server are discarded */
+		cache.SetUpdateId(server_a, 8, 200);
+		CPPUNIT_ASSERT(cache.Get(server_a, UpnpCache::Kind::CHILDREN,
+					 "0", 200) == nullptr);
+		CPPUNIT_ASSERT(cache.Get(server_a, UpnpCache::Kind::METADATA,
+					 "0", 200) == nullptr);
+		CPPUNIT_ASSERT(cache.Get(server_b, UpnpCache::Kind::CHILDREN,
+					 "0", 200) != nullptr);
+	}
+
+	void TestRoundTrips() {
+		const std::vector<std::string> path = {
+			"dir1", "dir2", "dir3", "dir4",
+		};
+
+		const unsigned N_QUERIES = 100;
+
+		FakeContentDirectory uncached_server(5, 4);
+		UpnpCache disabled(0, 100, 100000);
+		for (unsigned i = 0; i < N_QUERIES; ++i)
+			CPPUNIT_ASSERT_EQUAL(std::string("0$1$2$3$4"),
+					     Namei(disabled, uncached_server,
+						   path, i));
+
+		FakeContentDirectory cached_server(5, 4);
+		UpnpCache cache(300000, 10000, 100000);
+		for (unsigned i = 0; i < N_QUERIES; ++i)
+			CPPUNIT_ASSERT_EQUAL(std::string("0$1$2$3$4"),
+					     Namei(cache, cached_server,
+						   path, i));
+
+		CPPUNIT_ASSERT_EQUAL(N_QUERIES * 4,
+				     uncached_server.browse_count);
+		CPPUNIT_ASSERT_EQUAL(4u, cached_server.browse_count);
+
+		if (getenv("VERBOSE") != nullptr)
+			printf("\n%u queries: %u Browse requests without cache, "
+			       "%u with cache\n",
+			       N_QUERIES, uncached_server.browse_count,
+			       cached_server.browse_count);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(UpnpCacheTest);
+
+int
+main(gcc_unused int argc, gcc_unused char **argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	auto &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return runner.run() ? EXIT_SUCCESS : EXIT_FAILURE;
+}